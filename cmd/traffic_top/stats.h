@@ -24,6 +24,7 @@
 #include <curl/curl.h>
 #include <map>
 #include <string>
+#include <vector>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -53,6 +54,7 @@ const char global[] = "\"global\": {\n";
 const char start[] = "\"proxy.process.";
 const char seperator[] = "\": \"";
 const char end[] = "\",\n";
+const char thread_accepts[] = "proxy.process.net.accepts.thread_";
 };
 
 
@@ -280,6 +282,18 @@ public:
           }
         }
       }
+
+      // The per thread counters are not in the lookup table, the proxy has one for each of its net threads.
+      for (int i = 0;; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "%s%d", constant::thread_accepts, i);
+        if (TSRecordGetInt(name, &value) != TS_ERR_OKAY) {
+          break;
+        }
+        char buffer[32];
+        sprintf(buffer, "%" PRId64, value);
+        (*_stats)[name] = buffer;
+      }
       _old_time = _now;
       _now = now;
       _time_diff = _now - _old_time;
@@ -425,6 +439,25 @@ public:
     }
   }
 
+  void
+  getThreadAccepts(vector<double> &values)
+  {
+    values.clear();
+    for (int i = 0;; ++i) {
+      char name[64];
+      snprintf(name, sizeof(name), "%s%d", constant::thread_accepts, i);
+      if (_stats->find(name) == _stats->end()) {
+        break;
+      }
+
+      double value = getValue(name, _stats);
+      if (_old_stats != NULL && _absolute == false) {
+        value = (value - getValue(name, _old_stats)) / _time_diff;
+      }
+      values.push_back(value);
+    }
+  }
+
   bool
   toggleAbsolute()
   {
@@ -25,6 +25,7 @@
 #include <map>
 #include <list>
 #include <string>
+#include <vector>
 #include <string.h>
 #include <iostream>
 #include <assert.h>
@@ -212,6 +213,28 @@ response_code_page(Stats &stats)
   makeTable(42, 1, response3, stats);
 }
 
+//----------------------------------------------------------------------------
+static void
+thread_accept_page(Stats &stats)
+{
+  attron(COLOR_PAIR(colorPair::border));
+  attron(A_BOLD);
+  mvprintw(0, 0, "                          ACCEPTS PER NET THREAD                               ");
+  attroff(COLOR_PAIR(colorPair::border));
+  attroff(A_BOLD);
+
+  vector<double> accepts;
+  stats.getThreadAccepts(accepts);
+
+  // 4 columns of 21 threads fit on the page.
+  for (size_t i = 0; i < accepts.size() && i < 84; ++i) {
+    int x = (i / 21) * 21;
+    int y = 1 + i % 21;
+    mvprintw(y, x, "Thread %zu", i);
+    prettyPrint(x + 10, y, accepts[i], 2);
+  }
+}
+
 //----------------------------------------------------------------------------
 static void
 help(const string &host, const string &version)
@@ -428,9 +451,10 @@ main(int argc, char **argv)
   enum Page {
     MAIN_PAGE,
     RESPONSE_PAGE,
+    THREAD_ACCEPT_PAGE,
   };
   Page page = MAIN_PAGE;
-  string page_alt = "(r)esponse";
+  string page_alt = "(r)esponse (t)hreads";
 
   while (1) {
     attron(COLOR_PAIR(colorPair::border));
@@ -452,6 +476,8 @@ main(int argc, char **argv)
       main_stats_page(stats);
     } else if (page == RESPONSE_PAGE) {
       response_code_page(stats);
+    } else if (page == THREAD_ACCEPT_PAGE) {
+      thread_accept_page(stats);
     }
 
     curs_set(0);
@@ -467,12 +493,16 @@ main(int argc, char **argv)
       goto quit;
     case 'm':
       page = MAIN_PAGE;
-      page_alt = "(r)esponse";
+      page_alt = "(r)esponse (t)hreads";
       break;
     case 'r':
       page = RESPONSE_PAGE;
       page_alt = "(m)ain";
       break;
+    case 't':
+      page = THREAD_ACCEPT_PAGE;
+      page_alt = "(m)ain";
+      break;
     case 'a':
       absolute = stats.toggleAbsolute();
     }
@@ -27,7 +27,7 @@
 
 #include "P_AIO.h"
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 #define AIO_PERIOD -HRTIME_MSECONDS(10)
 #else
 
@@ -46,7 +46,17 @@ volatile int num_filedes = 1;
 static ink_mutex insert_mutex;
 
 int thread_is_created = 0;
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE == AIO_MODE_THREAD
+#if AIO_MODE == AIO_MODE_IO_URING
+// Buffers and files to map into the rings, see DiskHandler::sync_fixed().
+static ink_mutex aio_fixed_mutex;
+static struct iovec aio_fixed_buffers[AIO_MAX_FIXED_BUFFERS];
+static int aio_n_fixed_buffers = 0;
+static int aio_fixed_files[AIO_MAX_FIXED_FILES];
+static int aio_n_fixed_files = 0;
+static volatile int aio_fixed_version = 0;
+#endif
+
 RecInt cache_config_threads_per_disk = 12;
 RecInt api_config_threads_per_disk = 12;
 
@@ -157,9 +167,11 @@ ink_aio_init(ModuleVersion v)
                      (int)AIO_STAT_KB_READ_PER_SEC, aio_stats_cb);
   RecRegisterRawStat(aio_rsb, RECT_PROCESS, "proxy.process.cache.KB_write_per_sec", RECD_FLOAT, RECP_PERSISTENT,
                      (int)AIO_STAT_KB_WRITE_PER_SEC, aio_stats_cb);
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_THREAD
   memset(&aio_reqs, 0, MAX_DISKS_POSSIBLE * sizeof(AIO_Reqs *));
   ink_mutex_init(&insert_mutex, NULL);
+#elif AIO_MODE == AIO_MODE_IO_URING
+  ink_mutex_init(&aio_fixed_mutex, NULL);
 #endif
   REC_ReadConfigInteger(cache_config_threads_per_disk, "proxy.config.cache.threads_per_disk");
 }
@@ -174,7 +186,7 @@ ink_aio_start()
   return 0;
 }
 
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_THREAD
 
 static void *aio_thread_main(void *arg);
 
@@ -509,7 +521,22 @@ aio_thread_main(void *arg)
   }
   return 0;
 }
-#else
+
+void
+ink_aio_register_buffer(void * /* buf ATS_UNUSED */, size_t /* len ATS_UNUSED */)
+{
+}
+
+void
+ink_aio_unregister_buffer(void * /* buf ATS_UNUSED */)
+{
+}
+
+void
+ink_aio_register_fd(int /* fd ATS_UNUSED */)
+{
+}
+#elif AIO_MODE == AIO_MODE_NATIVE
 int
 DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
 {
@@ -663,4 +690,304 @@ ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
   }
   return 1;
 }
-#endif // AIO_MODE != AIO_MODE_NATIVE
+
+void
+ink_aio_register_buffer(void * /* buf ATS_UNUSED */, size_t /* len ATS_UNUSED */)
+{
+}
+
+void
+ink_aio_unregister_buffer(void * /* buf ATS_UNUSED */)
+{
+}
+
+void
+ink_aio_register_fd(int /* fd ATS_UNUSED */)
+{
+}
+#else /* AIO_MODE == AIO_MODE_IO_URING */
+
+DiskHandler::DiskHandler() : trigger_event(NULL), pending(0), in_flight(0), fixed_version(0), fixed_buffers(0), fixed_files(0)
+{
+  SET_HANDLER(&DiskHandler::startAIOEvent);
+  int ret = ink_io_uring_init(&ring, MAX_AIO_EVENTS);
+  if (ret < 0) {
+    Fatal("io_uring_setup failed: %s (%d), the kernel may not support io_uring", strerror(-ret), -ret);
+  }
+}
+
+DiskHandler::~DiskHandler()
+{
+  ink_io_uring_close(&ring);
+}
+
+int
+DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
+{
+  SET_HANDLER(&DiskHandler::mainAIOEvent);
+  e->schedule_every(AIO_PERIOD);
+  trigger_event = e;
+#if HAVE_EVENTFD
+  // Wake the net handler up when an IO completes.
+  int ret = ink_io_uring_register(&ring, IORING_REGISTER_EVENTFD, &e->ethread->evfd, 1);
+  if (ret < 0) {
+    Debug("aio", "unable to register the eventfd with io_uring: %s (%d)", strerror(-ret), -ret);
+  }
+#endif
+  return EVENT_CONT;
+}
+
+int
+DiskHandler::mainAIOEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  submit();
+  reap();
+  return EVENT_CONT;
+}
+
+// Write the SQE for a request, or return false if it has to wait: the submission queue is full, there
+// wouldn't be room for its completion, or the registered buffers and files are about to change.
+bool
+DiskHandler::prep(AIOCallback *op)
+{
+  struct io_uring_sqe *sqe;
+
+  if (fixed_version != aio_fixed_version || (unsigned)(in_flight + pending) >= ring.cq_entries ||
+      (sqe = ink_io_uring_get_sqe(&ring)) == NULL) {
+    return false;
+  }
+
+  ink_aiocb_t *cb = &op->aiocb;
+  char *buf = (char *)cb->aio_buf;
+  bool write = cb->aio_lio_opcode == LIO_WRITE;
+
+  sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+  sqe->fd = cb->aio_fildes;
+  sqe->off = cb->aio_offset;
+  sqe->addr = (uintptr_t)buf;
+  sqe->len = cb->aio_nbytes;
+  sqe->user_data = (uintptr_t)op;
+
+  for (int i = 0; i < fixed_files; ++i) {
+    if (fixed_fds[i] == cb->aio_fildes) {
+      sqe->fd = i;
+      sqe->flags |= IOSQE_FIXED_FILE;
+      break;
+    }
+  }
+  for (int i = 0; i < fixed_buffers; ++i) {
+    char *base = (char *)fixed_iov[i].iov_base;
+    if (buf >= base && buf + cb->aio_nbytes <= base + fixed_iov[i].iov_len) {
+      sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+      sqe->buf_index = i;
+      break;
+    }
+  }
+
+  ink_io_uring_sqe_ready(&ring);
+  ++pending;
+  return true;
+}
+
+void
+DiskHandler::queue(AIOCallback *op)
+{
+  ink_assert(op->action.continuation);
+  if (ready_list.head || !prep(op)) {
+    ready_list.enqueue(op);
+  }
+}
+
+// Hand the SQEs written since the last call to the kernel in one go.
+void
+DiskHandler::submit()
+{
+  AIOCallback *op;
+
+  sync_fixed();
+  while ((op = ready_list.head) != NULL && prep(op)) {
+    ready_list.dequeue();
+  }
+
+  if (pending == 0) {
+    return;
+  }
+
+  int ret = ink_io_uring_enter(&ring, pending, 0, 0);
+  if (ret < 0) {
+    // The SQEs stay in the ring and are submitted the next time around.
+    Debug("aio", "io_uring_enter failed: %s (%d)", strerror(-ret), -ret);
+    return;
+  }
+  pending -= ret;
+  in_flight += ret;
+}
+
+// Call back the requests that completed. The completion queue is shared with the kernel, so there is no
+// system call unless something completed.
+int
+DiskHandler::reap()
+{
+  AIOCallback *op;
+  struct io_uring_cqe *cqe;
+  int n = 0;
+
+  while ((cqe = ink_io_uring_peek_cqe(&ring)) != NULL) {
+    op = (AIOCallback *)(uintptr_t)cqe->user_data;
+    op->aio_result = cqe->res;
+    complete_list.enqueue(op);
+    ink_io_uring_cqe_seen(&ring);
+    ++n;
+  }
+  in_flight -= n;
+
+  while ((op = complete_list.dequeue()) != NULL) {
+    op->handleEvent(AIO_EVENT_DONE, NULL);
+  }
+  return n;
+}
+
+// Bring the buffers and files registered with the ring up to date. The tables can only be replaced while
+// no request uses them, so prep() holds the new requests back until the ring drains.
+void
+DiskHandler::sync_fixed()
+{
+  if (fixed_version == aio_fixed_version || pending || in_flight) {
+    return;
+  }
+
+  if (fixed_buffers) {
+    ink_io_uring_register(&ring, IORING_UNREGISTER_BUFFERS, NULL, 0);
+    fixed_buffers = 0;
+  }
+  if (fixed_files) {
+    ink_io_uring_register(&ring, IORING_UNREGISTER_FILES, NULL, 0);
+    fixed_files = 0;
+  }
+
+  int nbuffers = 0, nfiles = 0;
+
+  ink_mutex_acquire(&aio_fixed_mutex);
+  int version = aio_fixed_version;
+  for (int i = 0; i < aio_n_fixed_buffers; ++i) {
+    if (aio_fixed_buffers[i].iov_base) {
+      fixed_iov[nbuffers++] = aio_fixed_buffers[i];
+    }
+  }
+  for (int i = 0; i < aio_n_fixed_files; ++i) {
+    fixed_fds[nfiles++] = aio_fixed_files[i];
+  }
+  ink_mutex_release(&aio_fixed_mutex);
+
+  // Registration is an optimization only, the requests fall back to regular reads and writes.
+  if (nbuffers > 0) {
+    int ret = ink_io_uring_register(&ring, IORING_REGISTER_BUFFERS, fixed_iov, nbuffers);
+    if (ret == 0) {
+      fixed_buffers = nbuffers;
+    } else {
+      Debug("aio", "unable to register %d buffers with io_uring: %s (%d)", nbuffers, strerror(-ret), -ret);
+    }
+  }
+  if (nfiles > 0) {
+    int ret = ink_io_uring_register(&ring, IORING_REGISTER_FILES, fixed_fds, nfiles);
+    if (ret == 0) {
+      fixed_files = nfiles;
+    } else {
+      Debug("aio", "unable to register %d files with io_uring: %s (%d)", nfiles, strerror(-ret), -ret);
+    }
+  }
+  fixed_version = version;
+}
+
+int
+ink_aio_read(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  op->aiocb.aio_lio_opcode = LIO_READ;
+  this_ethread()->diskHandler->queue(op);
+  return 1;
+}
+
+int
+ink_aio_write(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  op->aiocb.aio_lio_opcode = LIO_WRITE;
+  this_ethread()->diskHandler->queue(op);
+  return 1;
+}
+
+static int
+aio_queue_vec(AIOCallback *op, int opcode)
+{
+  DiskHandler *dh = this_ethread()->diskHandler;
+  AIOCallback *io;
+  int sz = 0;
+
+  for (io = op; io; io = io->then) {
+    io->aiocb.aio_lio_opcode = opcode;
+    ++sz;
+  }
+
+  if (sz > 1) {
+    ink_assert(op->action.continuation);
+    AIOVec *vec = new AIOVec(sz, op);
+    for (io = op; io; io = io->then) {
+      io->action = vec;
+    }
+  }
+
+  for (io = op; io; io = io->then) {
+    dh->queue(io);
+  }
+  return 1;
+}
+
+int
+ink_aio_readv(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_queue_vec(op, LIO_READ);
+}
+
+int
+ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_queue_vec(op, LIO_WRITE);
+}
+
+void
+ink_aio_register_buffer(void *buf, size_t len)
+{
+  ink_mutex_acquire(&aio_fixed_mutex);
+  if (aio_n_fixed_buffers < AIO_MAX_FIXED_BUFFERS) {
+    aio_fixed_buffers[aio_n_fixed_buffers].iov_base = buf;
+    aio_fixed_buffers[aio_n_fixed_buffers].iov_len = len;
+    ++aio_n_fixed_buffers;
+    ink_atomic_increment(&aio_fixed_version, 1);
+  }
+  ink_mutex_release(&aio_fixed_mutex);
+}
+
+void
+ink_aio_unregister_buffer(void *buf)
+{
+  ink_mutex_acquire(&aio_fixed_mutex);
+  for (int i = 0; i < aio_n_fixed_buffers; ++i) {
+    if (aio_fixed_buffers[i].iov_base == buf) {
+      aio_fixed_buffers[i].iov_base = NULL;
+      aio_fixed_buffers[i].iov_len = 0;
+      ink_atomic_increment(&aio_fixed_version, 1);
+    }
+  }
+  ink_mutex_release(&aio_fixed_mutex);
+}
+
+void
+ink_aio_register_fd(int fd)
+{
+  ink_mutex_acquire(&aio_fixed_mutex);
+  if (aio_n_fixed_files < AIO_MAX_FIXED_FILES) {
+    aio_fixed_files[aio_n_fixed_files++] = fd;
+    ink_atomic_increment(&aio_fixed_version, 1);
+  }
+  ink_mutex_release(&aio_fixed_mutex);
+}
+#endif // AIO_MODE == AIO_MODE_IO_URING
@@ -43,9 +43,12 @@
 
 #define AIO_MODE_THREAD 0
 #define AIO_MODE_NATIVE 1
+#define AIO_MODE_IO_URING 2
 
 #if TS_USE_LINUX_NATIVE_AIO
 #define AIO_MODE AIO_MODE_NATIVE
+#elif TS_USE_LINUX_IO_URING
+#define AIO_MODE AIO_MODE_IO_URING
 #else
 #define AIO_MODE AIO_MODE_THREAD
 #endif
@@ -81,8 +84,19 @@ typedef struct ink_aiocb {
   int aio__pad[1];    /* extension padding */
 } ink_aiocb_t;
 
+#if AIO_MODE == AIO_MODE_IO_URING
+
+#include "ink_io_uring.h"
+
+#define MAX_AIO_EVENTS 1024
+#define AIO_MAX_FIXED_BUFFERS 64
+#define AIO_MAX_FIXED_FILES 256
+
+#else
+
 bool ink_aio_thread_num_set(int thread_num);
 
+#endif
 #endif
 
 // AIOCallback::thread special values
@@ -105,7 +119,7 @@ struct AIOCallback : public Continuation {
   AIOCallback() : thread(AIO_CALLBACK_THREAD_ANY), then(0) { aiocb.aio_reqprio = AIO_DEFAULT_PRIORITY; }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 
 struct AIOVec : public Continuation {
   Action action;
@@ -121,6 +135,9 @@ struct AIOVec : public Continuation {
 
   int mainEvent(int event, Event *e);
 };
+#endif
+
+#if AIO_MODE == AIO_MODE_NATIVE
 
 struct DiskHandler : public Continuation {
   Event *trigger_event;
@@ -142,6 +159,49 @@ struct DiskHandler : public Continuation {
 };
 #endif
 
+#if AIO_MODE == AIO_MODE_IO_URING
+
+// DiskHandler
+//
+// One io_uring per net thread. The requests issued on the thread are written straight into the submission
+// queue and handed to the kernel in a single io_uring_enter() each time around the event loop, right before
+// the net handler polls. The completion queue is shared memory, so the net handler reaps it after every poll
+// without a system call; the thread's eventfd is registered with the ring to wake the poll up when an IO
+// completes. The periodic event covers threads which don't run a net handler.
+//
+// Buffers and files registered with ink_aio_register_buffer() and ink_aio_register_fd() are mapped into
+// every ring, so that the kernel doesn't have to pin the pages and look up the file for each request.
+
+struct DiskHandler : public Continuation {
+  Event *trigger_event;
+  ink_io_uring ring;
+  int pending;       // SQEs written since the last io_uring_enter()
+  int in_flight;     // submitted to the kernel and not reaped yet
+  int fixed_version; // version of the registered buffers and files mapped into the ring
+  int fixed_buffers; // number of buffers registered with the ring
+  int fixed_files;   // number of files registered with the ring
+  struct iovec fixed_iov[AIO_MAX_FIXED_BUFFERS];
+  int fixed_fds[AIO_MAX_FIXED_FILES];
+
+  Que(AIOCallback, link) ready_list;    // waiting for a free SQE
+  Que(AIOCallback, link) complete_list; // reaped and waiting for their callback
+
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+
+  void queue(AIOCallback *op);
+  void submit();
+  int reap();
+
+  DiskHandler();
+  ~DiskHandler();
+
+private:
+  bool prep(AIOCallback *op);
+  void sync_fixed();
+};
+#endif
+
 void ink_aio_init(ModuleVersion version);
 int ink_aio_start();
 void ink_aio_set_callback(Continuation *error_callback);
@@ -153,4 +213,10 @@ int ink_aio_readv(AIOCallback *op,
                   int fromAPI = 0); // fromAPI is a boolean to indicate if this is from a API call such as upload proxy feature
 int ink_aio_writev(AIOCallback *op, int fromAPI = 0);
 AIOCallback *new_AIOCallback(void);
+
+// Hint that a buffer or a file is going to be used for AIO for a long time, such as the aggregation buffer
+// of a volume or the fd of a span. Only the io_uring mode makes use of it, and does so on a best effort basis.
+void ink_aio_register_buffer(void *buf, size_t len);
+void ink_aio_unregister_buffer(void *buf);
+void ink_aio_register_fd(int fd);
 #endif
@@ -236,6 +236,18 @@ struct AIO_Device : public Continuation {
   int do_fd(int event, Event *e);
 };
 
+static const char *
+aio_mode_name()
+{
+#if AIO_MODE == AIO_MODE_NATIVE
+  return "native";
+#elif AIO_MODE == AIO_MODE_IO_URING
+  return "io_uring";
+#else
+  return "thread";
+#endif
+}
+
 void
 dump_summary(void)
 {
@@ -245,6 +257,7 @@ dump_summary(void)
   printf("----------\n");
   printf("parameters\n");
   printf("----------\n");
+  printf("%s aio mode\n", aio_mode_name());
   printf("%d disks\n", n_disk_path);
   printf("%d chains\n", chains);
   printf("%d threads_per_disk\n", threads_per_disk);
@@ -488,7 +501,7 @@ main(int /* argc ATS_UNUSED */, char *argv[])
   RecProcessInit(RECM_STAND_ALONE);
   ink_event_system_init(EVENT_SYSTEM_MODULE_VERSION);
   eventProcessor.start(ink_number_of_processors());
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   int etype = ET_NET;
   int n_netthreads = eventProcessor.n_threads_for_type[etype];
   EThread **netthreads = eventProcessor.eventthread[etype];
@@ -529,6 +542,9 @@ main(int /* argc ATS_UNUSED */, char *argv[])
         exit(1);
       }
       dev[n_accessors]->buf = (char *)valloc(max_size);
+      // Like the spans and the aggregation buffers of the cache.
+      ink_aio_register_fd(dev[n_accessors]->fd);
+      ink_aio_register_buffer(dev[n_accessors]->buf, max_size);
       eventProcessor.schedule_imm(dev[n_accessors]);
       n_accessors++;
     }
@@ -65,6 +65,9 @@ int cache_config_ram_cache_compress_percent = 90;
 int cache_config_ram_cache_use_seen_filter = 0;
 int cache_config_http_max_alts = 3;
 int cache_config_dir_sync_frequency = 60;
+int cache_config_dir_tag_index = 0;
+int cache_config_dir_lock_groups = 0;
+int cache_config_init_dir_reads = 4;
 int cache_config_permit_pinning = 0;
 int cache_config_select_alternate = 1;
 int cache_config_max_doc_size = 0;
@@ -76,11 +79,19 @@ int cache_config_hit_evacuate_size_limit = 0;
 int cache_config_force_sector_size = 0;
 int cache_config_target_fragment_size = DEFAULT_TARGET_FRAGMENT_SIZE;
 int cache_config_agg_write_backlog = AGG_SIZE * 2;
+int cache_config_agg_buffer_size = AGG_SIZE;
+int cache_config_agg_buffers = 1;
 int cache_config_enable_checksum = 0;
 int cache_config_alt_rewrite_max_size = 4096;
 int cache_config_read_while_writer = 0;
 int cache_config_mutex_retry_delay = 2;
 int cache_config_read_while_writer_max_retries = 10;
+int64_t cache_config_sendfile_min_size = 0;
+int cache_config_tier_promote_hits = 2;
+int64_t cache_config_tier_promote_max_size = 0;
+int cache_config_read_ahead_fragments = 0;
+int cache_config_admission_min_hits = 0;
+int64_t cache_config_admission_small_size = 16384;
 #ifdef HTTP_CACHE
 static int enable_cache_empty_http_doc = 0;
 /// Fix up a specific known problem with the 4.2.0 release.
@@ -122,8 +133,15 @@ struct VolInitInfo {
   off_t recover_pos;
   AIOCallbackInternal vol_aio[4];
   char *vol_h_f;
-
-  VolInitInfo()
+  // the reads of the parts of the directory
+  AIOCallbackInternal *dir_aio;
+  int dir_aios;
+  off_t dir_start;
+  off_t dir_read_pos;
+  int dir_reads_pending;
+  bool dir_read_failed;
+
+  VolInitInfo() : dir_aio(NULL), dir_aios(0), dir_start(0), dir_read_pos(0), dir_reads_pending(0), dir_read_failed(false)
   {
     recover_pos = 0;
     vol_h_f = (char *)ats_memalign(ats_pagesize(), 4 * STORE_BLOCK_SIZE);
@@ -136,11 +154,16 @@ struct VolInitInfo {
       vol_aio[i].action = NULL;
       vol_aio[i].mutex.clear();
     }
+    for (int i = 0; i < dir_aios; i++) {
+      dir_aio[i].action = NULL;
+      dir_aio[i].mutex.clear();
+    }
+    delete[] dir_aio;
     free(vol_h_f);
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 struct VolInit : public Continuation {
   Vol *vol;
   char *path;
@@ -347,6 +370,7 @@ CacheVC::do_io_pread(Continuation *c, int64_t nbytes, MIOBuffer *abuf, int64_t o
   vio.nbytes = nbytes;
   vio.vc_server = this;
   seek_to = offset;
+  f.tier_promote = 0; // only whole documents are promoted
 #ifdef DEBUG
   ink_assert(c->mutex->thread_holding);
 #endif
@@ -609,7 +633,7 @@ CacheProcessor::start_internal(int flags)
   ink_assert((int)TS_EVENT_CACHE_SCAN_OPERATION_FAILED == (int)CACHE_EVENT_SCAN_OPERATION_FAILED);
   ink_assert((int)TS_EVENT_CACHE_SCAN_DONE == (int)CACHE_EVENT_SCAN_DONE);
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   int etype = ET_NET;
   int n_netthreads = eventProcessor.n_threads_for_type[etype];
   EThread **netthreads = eventProcessor.eventthread[etype];
@@ -694,6 +718,7 @@ CacheProcessor::start_internal(int flags)
         if (check)
           gdisks[gndisks]->read_only_p = true;
         gdisks[gndisks]->forced_volume_num = sd->forced_volume_num;
+        gdisks[gndisks]->fast_tier = sd->fast_tier;
         if (sd->hash_base_string)
           gdisks[gndisks]->hash_base_string = ats_strdup(sd->hash_base_string);
 
@@ -713,7 +738,7 @@ CacheProcessor::start_internal(int flags)
 
         off_t skip = ROUND_TO_STORE_BLOCK((sd->offset < START_POS ? START_POS + sd->alignment : sd->offset));
         blocks = blocks - (skip >> STORE_BLOCK_SHIFT);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
         eventProcessor.schedule_imm(new DiskInit(gdisks[gndisks], path, blocks, skip, sector_size, fd, clear));
 #else
         gdisks[gndisks]->open(path, blocks, skip, sector_size, fd, clear);
@@ -927,6 +952,9 @@ CacheProcessor::cacheInitialized()
         case RAM_CACHE_ALGORITHM_LRU:
           gvol[i]->ram_cache = new_RamCacheLRU();
           break;
+        case RAM_CACHE_ALGORITHM_TINYLFU:
+          gvol[i]->ram_cache = new_RamCacheTinyLFU();
+          break;
         }
       }
       // let us calculate the Size
@@ -1023,6 +1051,16 @@ CacheProcessor::cacheInitialized()
       case CACHE_COMPRESSION_LIBLZMA:
 #if !TS_HAS_LZMA
         Fatal("lzma not available for RAM cache compression");
+#endif
+        break;
+      case CACHE_COMPRESSION_ZSTD:
+#if !TS_HAS_ZSTD
+        Fatal("zstd not available for RAM cache compression");
+#endif
+        break;
+      case CACHE_COMPRESSION_LZ4:
+#if !TS_HAS_LZ4
+        Fatal("lz4 not available for RAM cache compression");
 #endif
         break;
       }
@@ -1269,6 +1307,8 @@ vol_clear_init(Vol *d)
   size_t dir_len = vol_dirlen(d);
   memset(d->raw_dir, 0, dir_len);
   vol_init_dir(d);
+  dir_tag_index_clear(d);
+  memset(d->dir_dirty, DIR_DIRTY_A | DIR_DIRTY_B, d->segments);
   d->header->magic = VOL_MAGIC;
   d->header->version.ink_major = CACHE_DB_MAJOR_VERSION;
   d->header->version.ink_minor = CACHE_DB_MINOR_VERSION;
@@ -1330,6 +1370,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   dir_skip = ROUND_TO_STORE_BLOCK((dir_skip < START_POS ? START_POS : dir_skip));
   path = ats_strdup(s);
   len = blocks * STORE_BLOCK_SIZE;
+  agg_init();
   ink_assert(len <= MAX_VOL_SIZE);
   skip = dir_skip;
   prev_recover_pos = 0;
@@ -1356,6 +1397,10 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
 
   dir = (Dir *)(raw_dir + vol_headerlen(this));
   header = (VolHeaderFooter *)raw_dir;
+  // either copy of the directory on disk may be behind the one read
+  dir_dirty = (uint8_t *)ats_malloc(segments);
+  memset(dir_dirty, DIR_DIRTY_A | DIR_DIRTY_B, segments);
+  init_time = ink_get_hrtime();
   footer = (VolHeaderFooter *)(raw_dir + vol_dirlen(this) - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
 
 
@@ -1387,7 +1432,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
     aio->thread = AIO_CALLBACK_THREAD_ANY;
     aio->then = (i < 3) ? &(init_info->vol_aio[i + 1]) : 0;
   }
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   ink_assert(ink_aio_readv(init_info->vol_aio));
 #else
   ink_assert(ink_aio_read(init_info->vol_aio));
@@ -1595,7 +1640,7 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
              sync serial and less than (header->sync_serial + 2) then
              continue;
 
-             3. If the position we are recovering from is within AGG_SIZE
+             3. If the position we are recovering from is within agg_size
              from the disk end, then we can't trust this document. The
              aggregation buffer might have been larger than the remaining space
              at the end and we decided to wrap around instead of writing
@@ -1617,7 +1662,7 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
           // (doc->sync_serial < last_sync_serial) ||
           // (doc->sync_serial > header->sync_serial + 1).
           // if we are too close to the end, wrap around
-          else if (recover_pos - (e - s) > (skip + len) - AGG_SIZE) {
+          else if (recover_pos - (e - s) > (skip + len) - agg_size) {
             recover_wrapped = 1;
             recover_pos = start;
             io.aiocb.aio_nbytes = RECOVERY_SIZE;
@@ -1629,10 +1674,10 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
           goto Ldone;
         } else {
           // doc->magic != DOC_MAGIC
-          // If we are in the danger zone - recover_pos is within AGG_SIZE
+          // If we are in the danger zone - recover_pos is within agg_size
           // from the end, then wrap around
           recover_pos -= e - s;
-          if (recover_pos > (skip + len) - AGG_SIZE) {
+          if (recover_pos > (skip + len) - agg_size) {
             recover_wrapped = 1;
             recover_pos = start;
             io.aiocb.aio_nbytes = RECOVERY_SIZE;
@@ -1679,8 +1724,10 @@ Ldone : {
     return handle_recover_write_dir(EVENT_IMMEDIATE, 0);
   }
 
-  recover_pos += EVACUATION_SIZE; // safely cover the max write size
-  if (recover_pos < header->write_pos && (recover_pos + EVACUATION_SIZE >= header->write_pos)) {
+  // safely cover the max write size, the buffers may have been written out of order
+  off_t max_write = MAX((off_t)EVACUATION_SIZE, (off_t)agg_size * agg_nbuffers);
+  recover_pos += max_write;
+  if (recover_pos < header->write_pos && (recover_pos + max_write >= header->write_pos)) {
     Debug("cache_init", "Head Pos: %" PRIu64 ", Rec Pos: %" PRIu64 ", Wrapped:%d", header->write_pos, recover_pos, recover_wrapped);
     Warning("no valid directory found while recovering '%s', clearing", hash_text.get());
     goto Lclear;
@@ -1730,7 +1777,7 @@ Ldone : {
   init_info->vol_aio[2].aiocb.aio_offset = ss + dirlen - footerlen;
 
   SET_HANDLER(&Vol::handle_recover_write_dir);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   ink_assert(ink_aio_writev(init_info->vol_aio));
 #else
   ink_assert(ink_aio_write(init_info->vol_aio));
@@ -1787,19 +1834,15 @@ Vol::handle_header_read(int event, void *data)
 
     if (hf[0]->sync_serial == hf[1]->sync_serial &&
         (hf[0]->sync_serial >= hf[2]->sync_serial || hf[2]->sync_serial != hf[3]->sync_serial)) {
-      SET_HANDLER(&Vol::handle_dir_read);
       if (is_debug_tag_set("cache_init"))
         Note("using directory A for '%s'", hash_text.get());
-      io.aiocb.aio_offset = skip;
-      ink_assert(ink_aio_read(&io));
+      read_dir(skip);
     }
     // try B
     else if (hf[2]->sync_serial == hf[3]->sync_serial) {
-      SET_HANDLER(&Vol::handle_dir_read);
       if (is_debug_tag_set("cache_init"))
         Note("using directory B for '%s'", hash_text.get());
-      io.aiocb.aio_offset = skip + vol_dirlen(this);
-      ink_assert(ink_aio_read(&io));
+      read_dir(skip + vol_dirlen(this));
     } else {
       Note("no good directory, clearing '%s'", hash_text.get());
       clear_dir();
@@ -1813,6 +1856,72 @@ Vol::handle_header_read(int event, void *data)
   return EVENT_DONE;
 }
 
+/*
+  The directory is read in DIR_READ_SIZE parts, proxy.config.cache.init.dir_reads
+  of them at a time, for the disk to work on several at once and not to tie up
+  an AIO thread with one read of the whole directory.
+*/
+void
+Vol::read_dir(off_t pos)
+{
+  int n = (vol_dirlen(this) + DIR_READ_SIZE - 1) / DIR_READ_SIZE;
+  if (n > cache_config_init_dir_reads)
+    n = cache_config_init_dir_reads;
+  if (n < 1)
+    n = 1;
+  init_info->dir_aio = new AIOCallbackInternal[n];
+  init_info->dir_aios = n;
+  init_info->dir_start = pos;
+  SET_HANDLER(&Vol::handle_dir_read_part);
+  for (int i = 0; i < n; i++)
+    read_dir_part(&init_info->dir_aio[i]);
+}
+
+// Reads the next part of the directory, returns false if it is all read.
+bool
+Vol::read_dir_part(AIOCallback *op)
+{
+  off_t dirlen = vol_dirlen(this);
+  off_t pos = init_info->dir_read_pos;
+  if (pos >= dirlen)
+    return false;
+  op->aiocb.aio_fildes = fd;
+  op->aiocb.aio_buf = raw_dir + pos;
+  op->aiocb.aio_nbytes = dirlen - pos < DIR_READ_SIZE ? dirlen - pos : DIR_READ_SIZE;
+  op->aiocb.aio_offset = init_info->dir_start + pos;
+  op->action = this;
+  op->thread = AIO_CALLBACK_THREAD_ANY;
+  op->then = 0;
+  init_info->dir_read_pos += op->aiocb.aio_nbytes;
+  init_info->dir_reads_pending++;
+  ink_assert(ink_aio_read(op));
+  return true;
+}
+
+int
+Vol::handle_dir_read_part(int event, void *data)
+{
+  AIOCallback *op = (AIOCallback *)data;
+
+  ink_assert(event == AIO_EVENT_DONE);
+  init_info->dir_reads_pending--;
+  if ((size_t)op->aio_result != (size_t)op->aiocb.aio_nbytes)
+    init_info->dir_read_failed = true;
+  if (!init_info->dir_read_failed && read_dir_part(op))
+    return EVENT_DONE;
+  if (init_info->dir_reads_pending)
+    return EVENT_DONE;
+  if (init_info->dir_read_failed) {
+    Warning("unable to read cache directory '%s', clearing", hash_text.get());
+    delete init_info;
+    init_info = 0;
+    clear_dir();
+    return EVENT_DONE;
+  }
+  SET_HANDLER(&Vol::handle_dir_read);
+  return handle_dir_read(EVENT_IMMEDIATE, 0);
+}
+
 int
 Vol::dir_init_done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
 {
@@ -1820,6 +1929,12 @@ Vol::dir_init_done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
     eventProcessor.schedule_in(this, HRTIME_MSECONDS(5), ET_CALL);
     return EVENT_CONT;
   } else {
+    if (cache_config_dir_tag_index)
+      dir_tag_index_init(this);
+    dir_lock_init(this);
+    write_serial_done = header->write_serial;
+    Note("cache directory '%s' read and recovered in %" PRId64 " ms", hash_text.get(),
+         (int64_t)ink_hrtime_to_msec(ink_get_hrtime() - init_time));
     int vol_no = ink_atomic_increment(&gnvol, 1);
     ink_assert(!gvol[vol_no]);
     gvol[vol_no] = this;
@@ -2083,6 +2198,7 @@ Cache::open_done()
     return 0;
   }
 
+  tier_init();
   hosttable = new CacheHostTable(this, scheme);
   hosttable->register_config_callback(&hosttable);
 
@@ -2126,7 +2242,7 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */)
             blocks = q->b->len;
 
             bool vol_clear = clear || d->cleared || q->new_block;
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
             eventProcessor.schedule_imm(new VolInit(cp->vols[vol_no], d->path, blocks, q->b->offset, vol_clear));
 #else
             cp->vols[vol_no]->init(d->path, blocks, q->b->offset, vol_clear);
@@ -2164,6 +2280,34 @@ CacheVC::is_pread_capable()
   return !f.read_from_writer_called;
 }
 
+bool
+CacheVC::enable_sendfile()
+{
+  if (cache_config_sendfile_min_size > 0 && (int64_t)doc_len >= cache_config_sendfile_min_size && vol->disk->sendfile_fd >= 0)
+    f.sendfile = 1;
+  return f.sendfile;
+}
+
+// Data ahead of the write position of the volume must stay this far from it to be sent from the disk.
+#define SENDFILE_WRITE_MARGIN(_v) ((_v)->agg_size * 2)
+
+CacheSendfileData::CacheSendfileData(Vol *v, Dir *e, int64_t pos, int64_t size)
+  : IOBufferFileData(v->disk->sendfile_fd, vol_offset(v, e) + pos, size), vol(v), fragment_offset(vol_offset(v, e))
+{
+  // In phase fragments are behind the write position and are overwritten only on the next cycle.
+  overwrite_cycle = v->header->cycle + (v->header->phase == dir_phase(e) ? 1 : 0);
+}
+
+// Called without the volume lock: racing with the aggregation write is covered by the margin.
+bool
+CacheSendfileData::is_valid()
+{
+  uint32_t cycle = vol->header->cycle;
+  if (cycle != overwrite_cycle)
+    return (int32_t)(cycle - overwrite_cycle) < 0;
+  return fragment_offset >= vol->header->write_pos + SENDFILE_WRITE_MARGIN(vol);
+}
+
 #define STORE_COLLISION 1
 
 #ifdef HTTP_CACHE
@@ -2348,7 +2492,7 @@ CacheVC::handleReadDone(int event, Event *e)
       int okay = 1;
       if (!f.doc_from_ram_cache)
         f.not_from_ram_cache = 1;
-      if (cache_config_enable_checksum && doc->checksum != DOC_NO_CHECKSUM) {
+      if (cache_config_enable_checksum && doc->checksum != DOC_NO_CHECKSUM && !f.doc_header_only) {
         // verify that the checksum matches
         uint32_t checksum = 0;
         for (char *b = doc->hdr(); b < (char *)doc + doc->len; b++)
@@ -2373,7 +2517,7 @@ CacheVC::handleReadDone(int event, Event *e)
         unmarshal_helper(doc, buf, okay);
 #endif
       // Put the request in the ram cache only if its a open_read or lookup
-      if (vio.op == VIO::READ && okay) {
+      if (vio.op == VIO::READ && okay && !f.doc_header_only) {
         bool cutoff_check;
         // cutoff_check :
         // doc_len == 0 for the first fragment (it is set from the vector)
@@ -2415,6 +2559,7 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   cancel_trigger();
 
   f.doc_from_ram_cache = false;
+  f.doc_header_only = false;
 
   // check ram cache
   ink_assert(vol->mutex->thread_holding == this_ethread());
@@ -2428,23 +2573,41 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     buf = vol->first_fragment_data;
     goto LmemHit;
   }
-  // see if its in the aggregation buffer
-  if (dir_agg_buf_valid(vol, &dir)) {
-    int agg_offset = vol_offset(vol, &dir) - vol->header->write_pos;
+  // see if its in an aggregation buffer
+  if (char *agg = vol->agg_data(&dir)) {
     buf = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
-    ink_assert((agg_offset + io.aiocb.aio_nbytes) <= (unsigned)vol->agg_buf_pos);
     char *doc = buf->data();
-    char *agg = vol->agg_buffer + agg_offset;
     memcpy(doc, agg, io.aiocb.aio_nbytes);
     io.aio_result = io.aiocb.aio_nbytes;
     SET_HANDLER(&CacheVC::handleReadDone);
     return EVENT_RETURN;
   }
+  // see if it was read ahead
+  if (CacheReadAhead *r = read_ahead_frags.head ? read_ahead_match() : NULL) {
+    SET_HANDLER(&CacheVC::handleReadDone);
+    if (!r->done) {
+      // wait for it as for a read of our own
+      r->waiting = true;
+      io.aiocb.aio_fildes = vol->fd;
+      return EVENT_CONT;
+    }
+    read_ahead_use(r);
+    return EVENT_RETURN;
+  }
 
   io.aiocb.aio_fildes = vol->fd;
   io.aiocb.aio_offset = vol_offset(vol, &dir);
   if ((off_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len))
     io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
+  // the data of a fragment after the first one can be sent from the disk, read only its header
+  if (f.sendfile && vio.op == VIO::READ && !dir_head(&dir) &&
+      (vol->header->phase == dir_phase(&dir) || io.aiocb.aio_offset >= vol->header->write_pos + SENDFILE_WRITE_MARGIN(vol) * 2)) {
+    size_t hlen = ROUND_TO(sizeof(Doc), vol->disk->hw_sector_size);
+    if (hlen < io.aiocb.aio_nbytes) {
+      io.aiocb.aio_nbytes = hlen;
+      f.doc_header_only = true;
+    }
+  }
   buf = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
   io.aiocb.aio_buf = buf->data();
   io.action = this;
@@ -3104,6 +3267,10 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("ram_cache.bytes_used", cache_ram_cache_bytes_stat);
   REG_INT("ram_cache.hits", cache_ram_cache_hits_stat);
   REG_INT("ram_cache.misses", cache_ram_cache_misses_stat);
+  REG_INT("ram_cache.compress.in_bytes", cache_ram_cache_compress_in_bytes_stat);
+  REG_INT("ram_cache.compress.out_bytes", cache_ram_cache_compress_out_bytes_stat);
+  REG_INT("ram_cache.compress.time", cache_ram_cache_compress_time_stat);
+  REG_INT("ram_cache.decompress.time", cache_ram_cache_decompress_time_stat);
   REG_INT("pread_count", cache_pread_count_stat);
   REG_INT("percent_full", cache_percent_full_stat);
   REG_INT("lookup.active", cache_lookup_active_stat);
@@ -3146,6 +3313,25 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("sync.count", cache_directory_sync_count_stat);
   REG_INT("sync.bytes", cache_directory_sync_bytes_stat);
   REG_INT("sync.time", cache_directory_sync_time_stat);
+  REG_INT("sync.segments", cache_directory_sync_segments_stat);
+  REG_INT("sync.segments_skipped", cache_directory_sync_segments_skipped_stat);
+  REG_INT("tier.fast.hits", cache_tier_fast_hits_stat);
+  REG_INT("tier.fast.bytes", cache_tier_fast_bytes_stat);
+  REG_INT("tier.slow.hits", cache_tier_slow_hits_stat);
+  REG_INT("tier.slow.bytes", cache_tier_slow_bytes_stat);
+  REG_INT("tier.promotions", cache_tier_promotions_stat);
+  REG_INT("tier.promoted_bytes", cache_tier_promoted_bytes_stat);
+  REG_INT("tier.fallbacks", cache_tier_fallbacks_stat);
+  REG_INT("lock_miss", cache_lock_miss_stat);
+  REG_INT("dir_group.misses", cache_dir_group_miss_stat);
+  REG_INT("read_ahead.issued", cache_read_ahead_issued_stat);
+  REG_INT("read_ahead.used", cache_read_ahead_used_stat);
+  REG_INT("read_ahead.wasted", cache_read_ahead_wasted_stat);
+  REG_INT("read_ahead.wasted_bytes", cache_read_ahead_wasted_bytes_stat);
+  REG_INT("admission.admitted", cache_admission_admitted_stat);
+  REG_INT("admission.admitted_bytes", cache_admission_admitted_bytes_stat);
+  REG_INT("admission.rejected", cache_admission_rejected_stat);
+  REG_INT("admission.rejected_bytes", cache_admission_rejected_bytes_stat);
 }
 
 
@@ -3178,6 +3364,15 @@ ink_cache_init(ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_dir_sync_frequency, "proxy.config.cache.dir.sync_frequency");
   Debug("cache_init", "proxy.config.cache.dir.sync_frequency = %d", cache_config_dir_sync_frequency);
 
+  REC_EstablishStaticConfigInt32(cache_config_dir_tag_index, "proxy.config.cache.dir.tag_index");
+  Debug("cache_init", "proxy.config.cache.dir.tag_index = %d", cache_config_dir_tag_index);
+
+  REC_EstablishStaticConfigInt32(cache_config_dir_lock_groups, "proxy.config.cache.dir.lock_groups");
+  Debug("cache_init", "proxy.config.cache.dir.lock_groups = %d", cache_config_dir_lock_groups);
+
+  REC_EstablishStaticConfigInt32(cache_config_init_dir_reads, "proxy.config.cache.init.dir_reads");
+  Debug("cache_init", "proxy.config.cache.init.dir_reads = %d", cache_config_init_dir_reads);
+
   REC_EstablishStaticConfigInt32(cache_config_select_alternate, "proxy.config.cache.select_alternate");
   Debug("cache_init", "proxy.config.cache.select_alternate = %d", cache_config_select_alternate);
 
@@ -3191,6 +3386,25 @@ ink_cache_init(ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_read_while_writer_max_retries, "proxy.config.cache.read_while_writer.max_retries");
   Debug("cache_init", "proxy.config.cache.read_while_writer.max_retries = %d", cache_config_read_while_writer_max_retries);
 
+  REC_EstablishStaticConfigInteger(cache_config_sendfile_min_size, "proxy.config.cache.sendfile_min_size");
+  Debug("cache_init", "proxy.config.cache.sendfile_min_size = %" PRId64, cache_config_sendfile_min_size);
+
+  REC_EstablishStaticConfigInt32(cache_config_read_ahead_fragments, "proxy.config.cache.read_ahead_fragments");
+  Debug("cache_init", "proxy.config.cache.read_ahead_fragments = %d", cache_config_read_ahead_fragments);
+
+  REC_EstablishStaticConfigInt32(cache_config_tier_promote_hits, "proxy.config.cache.tier.promote_hits");
+  Debug("cache_init", "proxy.config.cache.tier.promote_hits = %d", cache_config_tier_promote_hits);
+
+  REC_EstablishStaticConfigInteger(cache_config_tier_promote_max_size, "proxy.config.cache.tier.promote_max_size");
+  Debug("cache_init", "proxy.config.cache.tier.promote_max_size = %" PRId64, cache_config_tier_promote_max_size);
+
+  REC_EstablishStaticConfigInt32(cache_config_admission_min_hits, "proxy.config.cache.admission.min_hits");
+  Debug("cache_init", "proxy.config.cache.admission.min_hits = %d", cache_config_admission_min_hits);
+
+  REC_EstablishStaticConfigInteger(cache_config_admission_small_size, "proxy.config.cache.admission.small_size");
+  Debug("cache_init", "proxy.config.cache.admission.small_size = %" PRId64, cache_config_admission_small_size);
+  cache_admission_init();
+
   REC_EstablishStaticConfigInt32(cache_config_hit_evacuate_percent, "proxy.config.cache.hit_evacuate_percent");
   Debug("cache_init", "proxy.config.cache.hit_evacuate_percent = %d", cache_config_hit_evacuate_percent);
 
@@ -3216,6 +3430,12 @@ ink_cache_init(ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_agg_write_backlog, "proxy.config.cache.agg_write_backlog");
   Debug("cache_init", "proxy.config.cache.agg_write_backlog = %d", cache_config_agg_write_backlog);
 
+  REC_EstablishStaticConfigInt32(cache_config_agg_buffer_size, "proxy.config.cache.agg_buffer_size");
+  Debug("cache_init", "proxy.config.cache.agg_buffer_size = %d", cache_config_agg_buffer_size);
+
+  REC_EstablishStaticConfigInt32(cache_config_agg_buffers, "proxy.config.cache.agg_buffers");
+  Debug("cache_init", "proxy.config.cache.agg_buffers = %d", cache_config_agg_buffers);
+
   REC_EstablishStaticConfigInt32(cache_config_enable_checksum, "proxy.config.cache.enable_checksum");
   Debug("cache_init", "proxy.config.cache.enable_checksum = %d", cache_config_enable_checksum);
 
@@ -0,0 +1,181 @@
+/** @file
+
+  Admission of the objects written to the cache.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  @section details Details
+
+  Most of the objects missed are never asked for again, writing them only wears the
+  disks and pushes the documents still being hit towards evacuation. The lookups of
+  each key are counted in a count-min sketch (TinyLFU), and a miss is written only
+  once its key has been looked up proxy.config.cache.admission.min_hits times, unless
+  the object is smaller than proxy.config.cache.admission.small_size.
+
+  The sketch is shared by all the threads without a lock: an update racing with
+  another one may be lost, which only makes the counts a little lower. The counts
+  are halved on a task thread, it goes over the whole sketch.
+ */
+
+#include "P_Cache.h"
+
+#define ADMISSION_SKETCH_DEPTH 4
+#define ADMISSION_SKETCH_WIDTH (1 << 20)
+#define ADMISSION_COUNT_MAX 15
+// the counts are halved after this many lookups, so that the old ones fade
+#define ADMISSION_SAMPLE_SIZE (10 * ADMISSION_SKETCH_WIDTH)
+
+static uint8_t *admission_sketch = NULL;
+static volatile int64_t admission_lookups = 0;
+
+// Halves the counts once ADMISSION_SAMPLE_SIZE lookups were counted.
+struct CacheAdmissionAger : public Continuation {
+  int
+  ageEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    admission_age();
+    delete this;
+    return EVENT_DONE;
+  }
+
+  static void
+  admission_age()
+  {
+    for (int i = 0; i < ADMISSION_SKETCH_DEPTH * ADMISSION_SKETCH_WIDTH; i++)
+      admission_sketch[i] >>= 1;
+    admission_lookups = 0;
+  }
+
+  CacheAdmissionAger() : Continuation(new_ProxyMutex()) { SET_HANDLER(&CacheAdmissionAger::ageEvent); }
+};
+
+static inline uint8_t *
+admission_counter(const CacheKey *key, int row)
+{
+  return &admission_sketch[row * ADMISSION_SKETCH_WIDTH + (key->slice32(row) & (ADMISSION_SKETCH_WIDTH - 1))];
+}
+
+static int
+admission_estimate(const CacheKey *key)
+{
+  int f = ADMISSION_COUNT_MAX;
+
+  for (int r = 0; r < ADMISSION_SKETCH_DEPTH; r++)
+    f = MIN(f, *admission_counter(key, r));
+  return f;
+}
+
+void
+cache_admission_init()
+{
+  if (cache_config_admission_min_hits > 0)
+    admission_sketch = (uint8_t *)ats_calloc(ADMISSION_SKETCH_DEPTH * ADMISSION_SKETCH_WIDTH, sizeof(uint8_t));
+}
+
+void
+CacheProcessor::admission_record(const CacheKey *key)
+{
+  if (!admission_sketch)
+    return;
+  // conservative update, only the smallest counts are incremented
+  int f = admission_estimate(key);
+  if (f < ADMISSION_COUNT_MAX) {
+    for (int r = 0; r < ADMISSION_SKETCH_DEPTH; r++) {
+      uint8_t *c = admission_counter(key, r);
+      if (*c == f)
+        *c = f + 1;
+    }
+  }
+  if (ink_atomic_increment(&admission_lookups, 1) == ADMISSION_SAMPLE_SIZE - 1)
+    eventProcessor.schedule_imm(new CacheAdmissionAger, ET_TASK);
+}
+
+bool
+CacheProcessor::admit(const CacheKey *key, int64_t size)
+{
+  if (!admission_sketch)
+    return true;
+  // an object of unknown size is taken to be large
+  int hits = (size >= 0 && size < cache_config_admission_small_size) ? 1 : cache_config_admission_min_hits;
+  bool admitted = admission_estimate(key) >= hits;
+  EThread *t = this_ethread();
+  RecIncrRawStat(cache_rsb, t, (int)(admitted ? cache_admission_admitted_stat : cache_admission_rejected_stat), 1);
+  if (size > 0)
+    RecIncrRawStat(cache_rsb, t, (int)(admitted ? cache_admission_admitted_bytes_stat : cache_admission_rejected_bytes_stat), size);
+  return admitted;
+}
+
+#if TS_HAS_TESTS
+
+REGRESSION_TEST(cache_admission)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  int ret = REGRESSION_TEST_PASSED;
+  int min_hits = cache_config_admission_min_hits;
+  int64_t small_size = cache_config_admission_small_size;
+  uint8_t *sketch = admission_sketch;
+  CacheKey key, other;
+
+  // a sketch of its own, the one configured is left alone
+  admission_sketch = (uint8_t *)ats_calloc(ADMISSION_SKETCH_DEPTH * ADMISSION_SKETCH_WIDTH, sizeof(uint8_t));
+  cache_config_admission_min_hits = 2;
+  cache_config_admission_small_size = 1000;
+  rand_CacheKey(&key, this_ethread()->mutex);
+  rand_CacheKey(&other, this_ethread()->mutex);
+
+  if (cacheProcessor.admit(&key, 100) || cacheProcessor.admit(&key, 100000)) {
+    rprintf(t, "an object was admitted before its key was looked up\n");
+    ret = REGRESSION_TEST_FAILED;
+  }
+  cacheProcessor.admission_record(&key);
+  if (!cacheProcessor.admit(&key, 100) || cacheProcessor.admit(&key, 100000) || cacheProcessor.admit(&key, -1)) {
+    rprintf(t, "after one lookup, only the small object should be admitted\n");
+    ret = REGRESSION_TEST_FAILED;
+  }
+  cacheProcessor.admission_record(&key);
+  if (!cacheProcessor.admit(&key, 100000) || !cacheProcessor.admit(&key, -1)) {
+    rprintf(t, "after two lookups, the large objects should be admitted\n");
+    ret = REGRESSION_TEST_FAILED;
+  }
+  if (cacheProcessor.admit(&other, 100)) {
+    rprintf(t, "an object was admitted under a key never looked up\n");
+    ret = REGRESSION_TEST_FAILED;
+  }
+
+  // the counts saturate, and fade when they are halved
+  for (int i = 0; i < 2 * ADMISSION_COUNT_MAX; i++)
+    cacheProcessor.admission_record(&key);
+  if (admission_estimate(&key) != ADMISSION_COUNT_MAX) {
+    rprintf(t, "count %d, expected %d\n", admission_estimate(&key), ADMISSION_COUNT_MAX);
+    ret = REGRESSION_TEST_FAILED;
+  }
+  for (int i = 0; i < 3; i++)
+    CacheAdmissionAger::admission_age();
+  if (admission_estimate(&key) != ADMISSION_COUNT_MAX >> 3 || cacheProcessor.admit(&key, 100000)) {
+    rprintf(t, "count %d after three halvings, expected %d\n", admission_estimate(&key), ADMISSION_COUNT_MAX >> 3);
+    ret = REGRESSION_TEST_FAILED;
+  }
+
+  ats_free(admission_sketch);
+  admission_sketch = sketch;
+  cache_config_admission_min_hits = min_hits;
+  cache_config_admission_small_size = small_size;
+  *pstatus = ret;
+}
+
+#endif
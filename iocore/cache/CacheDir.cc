@@ -26,6 +26,10 @@
 
 #include "hugepages.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // #define LOOP_CHECK_MODE 1
 #ifdef LOOP_CHECK_MODE
 #define DIR_LOOP_THRESHOLD 1000
@@ -56,6 +60,34 @@
 ClassAllocator<OpenDirEntry> openDirEntryAllocator("openDirEntry");
 Dir empty_dir;
 
+// A segment of the directory changed, it is written again by the next sync of
+// each copy of the directory.
+static inline void
+dir_segment_dirty(int s, Vol *d)
+{
+  d->header->dirty = 1;
+  d->dir_dirty[s] = DIR_DIRTY_A | DIR_DIRTY_B;
+}
+
+// Holds the lock of the segment group of a segment, if the directory of the stripe is
+// split in groups. The directory is changed under the stripe lock and the lock of the
+// group, so that it can be probed under the lock of the group only. Reading it under
+// the stripe lock does not need the lock of the group.
+struct DirLock {
+  ProxyMutex *m;
+
+  DirLock(Vol *d, int s) : m(d->dir_mutexes ? d->dir_mutex[s % d->dir_mutexes].m_ptr : NULL)
+  {
+    if (m)
+      MUTEX_TAKE_LOCK(m, this_ethread());
+  }
+  ~DirLock()
+  {
+    if (m)
+      MUTEX_UNTAKE_LOCK(m, this_ethread());
+  }
+};
+
 // OpenDir
 
 OpenDir::OpenDir()
@@ -160,6 +192,14 @@ OpenDir::open_read(const CryptoHash *key)
   return NULL;
 }
 
+// Whether a document in the bucket of the key may be being written. This is checked
+// without the stripe lock, so it is only a hint: a writer may come in right after.
+bool
+OpenDir::may_be_open(const CryptoHash *key)
+{
+  return bucket[key->slice32(0) % OPEN_DIR_BUCKETS].head != NULL;
+}
+
 int
 OpenDirEntry::wait(CacheVC *cont, int msec)
 {
@@ -207,6 +247,8 @@ dir_bucket_loop_check(Dir *start_dir, Dir *seg)
 void
 dir_init_segment(int s, Vol *d)
 {
+  DirLock dlock(d, s);
+  dir_segment_dirty(s, d);
   d->header->freelist[s] = 0;
   Dir *seg = dir_segment(s, d);
   int l, b;
@@ -306,7 +348,7 @@ dir_delete_entry(Dir *e, Dir *p, int s, Vol *d)
 {
   Dir *seg = dir_segment(s, d);
   int no = dir_next(e);
-  d->header->dirty = 1;
+  dir_segment_dirty(s, d);
   if (p) {
     unsigned int fo = d->header->freelist[s];
     unsigned int eo = dir_to_offset(e, seg);
@@ -363,6 +405,7 @@ dir_clean_bucket(Dir *b, int s, Vol *vol)
 void
 dir_clean_segment(int s, Vol *d)
 {
+  DirLock dlock(d, s);
   Dir *seg = dir_segment(s, d);
   for (int64_t i = 0; i < d->buckets; i++) {
     dir_clean_bucket(dir_bucket(i, seg), s, d);
@@ -382,11 +425,16 @@ dir_clean_vol(Vol *d)
 void
 dir_clear_range(off_t start, off_t end, Vol *vol)
 {
-  for (off_t i = 0; i < vol->buckets * DIR_DEPTH * vol->segments; i++) {
-    Dir *e = dir_index(vol, i);
-    if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
-      CACHE_DEC_DIR_USED(vol->mutex);
-      dir_set_offset(e, 0); // delete
+  for (int s = 0; s < vol->segments; s++) {
+    DirLock dlock(vol, s);
+    Dir *seg = dir_segment(s, vol);
+    for (off_t i = 0; i < vol->buckets * DIR_DEPTH; i++) {
+      Dir *e = dir_in_seg(seg, i);
+      if (!dir_token(e) && dir_offset(e) >= (int64_t)start && dir_offset(e) < (int64_t)end) {
+        CACHE_DEC_DIR_USED(vol->mutex);
+        dir_set_offset(e, 0); // delete
+        dir_segment_dirty(s, vol);
+      }
     }
   }
   dir_clean_vol(vol);
@@ -503,6 +551,149 @@ dir_free_entry(Dir *e, int s, Vol *d)
   d->header->freelist[s] = eo;
 }
 
+//
+// Tag index
+//
+// The tags of the entries of a bucket are spread over its chain, which goes anywhere
+// in the segment. The tag index keeps them together, DIR_TAG_INDEX_SLOTS per bucket in
+// one aligned vector, so that a probe finds with a single compare whether the bucket
+// may have the entry, and only walks the chain then. The slots hold at least the tags
+// of the bucket: they are added to as entries are put in the bucket but not cleared
+// as they go, the slots of a bucket are rebuilt instead when a probe walks it for
+// nothing. A bucket with more tags than slots is marked in its last slot, and is
+// always walked. The index is in memory only, it is built from the directory once it
+// is read.
+//
+
+#define TAG_INDEX_USED 0x8000     // a tag in the slot
+#define TAG_INDEX_OVERFLOW 0x4000 // too many tags for the slots
+
+static inline uint16_t *
+tag_index_bucket(Vol *d, int s, int b)
+{
+  return d->tag_index + ((int64_t)s * d->buckets + b) * DIR_TAG_INDEX_SLOTS;
+}
+
+// false when the bucket has no entry with the tag
+static inline bool
+tag_index_candidate(const uint16_t *slots, uint32_t t)
+{
+#if defined(__SSE2__) && DIR_TAG_INDEX_SLOTS == 8
+  __m128i v = _mm_load_si128((const __m128i *)slots);
+  __m128i m = _mm_or_si128(_mm_cmpeq_epi16(v, _mm_set1_epi16((short)(TAG_INDEX_USED | t))),
+                           _mm_cmpeq_epi16(v, _mm_set1_epi16(TAG_INDEX_OVERFLOW)));
+  return _mm_movemask_epi8(m) != 0;
+#else
+  for (int i = 0; i < DIR_TAG_INDEX_SLOTS; i++)
+    if (slots[i] == (TAG_INDEX_USED | t) || slots[i] == TAG_INDEX_OVERFLOW)
+      return true;
+  return false;
+#endif
+}
+
+static inline void
+tag_index_add(uint16_t *slots, uint32_t t)
+{
+  for (int i = 0; i < DIR_TAG_INDEX_SLOTS; i++) {
+    if (slots[i] == (TAG_INDEX_USED | t) || slots[i] == TAG_INDEX_OVERFLOW)
+      return;
+    if (!slots[i]) {
+      slots[i] = (uint16_t)(TAG_INDEX_USED | t);
+      return;
+    }
+  }
+  slots[DIR_TAG_INDEX_SLOTS - 1] = TAG_INDEX_OVERFLOW;
+}
+
+static void
+tag_index_rebuild(uint16_t *slots, Dir *b, Dir *seg)
+{
+  memset(slots, 0, DIR_TAG_INDEX_SLOTS * sizeof(uint16_t));
+  if (!dir_offset(b))
+    return;
+  int n = 0;
+  for (Dir *e = b; e; e = next_dir(e, seg)) {
+    // a long chain (or a loop) is simply walked
+    if (++n > 2 * DIR_TAG_INDEX_SLOTS) {
+      slots[DIR_TAG_INDEX_SLOTS - 1] = TAG_INDEX_OVERFLOW;
+      return;
+    }
+    tag_index_add(slots, dir_tag(e));
+  }
+}
+
+void
+dir_tag_index_init(Vol *d)
+{
+  size_t len = (size_t)d->segments * d->buckets * DIR_TAG_INDEX_SLOTS * sizeof(uint16_t);
+  if (!d->tag_index)
+    d->tag_index = (uint16_t *)ats_memalign(64, len);
+  for (int s = 0; s < d->segments; s++) {
+    Dir *seg = dir_segment(s, d);
+    for (int b = 0; b < d->buckets; b++)
+      tag_index_rebuild(tag_index_bucket(d, s, b), dir_bucket(b, seg), seg);
+  }
+}
+
+void
+dir_tag_index_clear(Vol *d)
+{
+  if (d->tag_index)
+    memset(d->tag_index, 0, (size_t)d->segments * d->buckets * DIR_TAG_INDEX_SLOTS * sizeof(uint16_t));
+}
+
+//
+// Segment groups
+//
+// The stripe lock is taken for every read and write of a document, and a busy stripe
+// reschedules them until it is free. The segments of the directory are split over
+// proxy.config.cache.dir.lock_groups locks, which are taken by the functions changing
+// the directory, so that the lookups of the documents which are not there, most of
+// them on a busy cache, can be answered from the directory without the stripe lock.
+//
+
+void
+dir_lock_init(Vol *d)
+{
+  int n = cache_config_dir_lock_groups < d->segments ? cache_config_dir_lock_groups : d->segments;
+  if (n <= 0 || d->dir_mutex)
+    return;
+  d->dir_mutex = new Ptr<ProxyMutex>[n];
+  for (int i = 0; i < n; i++)
+    d->dir_mutex[i] = new_ProxyMutex();
+  d->dir_mutexes = n;
+}
+
+/*
+  Probes the directory under the lock of the segment group only, the caller
+  does not hold the stripe lock. Returns 0 if there is no entry for the key,
+  1 if there may be one, and -1 if the directory is not split in groups or
+  the lock of the group is busy as well. The entries are not checked, and the
+  invalid ones are left for dir_probe to clean up.
+*/
+int
+dir_group_probe(const CacheKey *key, Vol *d)
+{
+  if (!d->dir_mutexes)
+    return -1;
+  int s = key->slice32(0) % d->segments;
+  int b = key->slice32(1) % d->buckets;
+  MUTEX_TRY_LOCK(lock, d->dir_mutex[s % d->dir_mutexes], this_ethread());
+  if (!lock.is_locked())
+    return -1;
+  if (d->tag_index && !tag_index_candidate(tag_index_bucket(d, s, b), DIR_MASK_TAG(key->slice32(2))))
+    return 0;
+  Dir *seg = dir_segment(s, d);
+  Dir *e = dir_bucket(b, seg);
+  if (!dir_offset(e))
+    return 0;
+  for (int n = 0; e && n < d->buckets * DIR_DEPTH; n++, e = next_dir(e, seg)) {
+    if (dir_compare_tag(e, key))
+      return 1;
+  }
+  return e ? 1 : 0; // a loop, left for dir_probe
+}
+
 int
 dir_probe(const CacheKey *key, Vol *d, Dir *result, Dir **last_collision)
 {
@@ -511,12 +702,23 @@ dir_probe(const CacheKey *key, Vol *d, Dir *result, Dir **last_collision)
   int b = key->slice32(1) % d->buckets;
   Dir *seg = dir_segment(s, d);
   Dir *e = NULL, *p = NULL, *collision = *last_collision;
+  uint16_t *tags = NULL;
   Vol *vol = d;
   CHECK_DIR(d);
 #ifdef LOOP_CHECK_MODE
-  if (dir_bucket_loop_fix(dir_bucket(b, seg), s, d))
-    return 0;
+  {
+    DirLock dlock(d, s);
+    if (dir_bucket_loop_fix(dir_bucket(b, seg), s, d))
+      return 0;
+  }
 #endif
+  if (d->tag_index) {
+    tags = tag_index_bucket(d, s, b);
+    if (!collision && !tag_index_candidate(tags, DIR_MASK_TAG(key->slice32(2)))) {
+      DDebug("dir_probe_miss", "missed %X %X on vol %d bucket %d by tag", key->slice32(0), key->slice32(1), d->fd, b);
+      return 0;
+    }
+  }
 Lagain:
   e = dir_bucket(b, seg);
   if (dir_offset(e))
@@ -547,6 +749,7 @@ Lagain:
           ink_assert(dir_offset(e) * CACHE_BLOCK_SIZE < d->len);
           return 1;
         } else { // delete the invalid entry
+          DirLock dlock(d, s);
           CACHE_DEC_DIR_USED(d->mutex);
           e = dir_delete_entry(e, p, s, d);
           continue;
@@ -564,6 +767,10 @@ Lagain:
     goto Lagain;
   }
   DDebug("dir_probe_miss", "missed %X %X on vol %d bucket %d at %p", key->slice32(0), key->slice32(1), d->fd, b, seg);
+  if (tags) {
+    DirLock dlock(d, s);
+    tag_index_rebuild(tags, dir_bucket(b, seg), seg);
+  }
   CHECK_DIR(d);
   return 0;
 }
@@ -579,6 +786,9 @@ dir_insert(const CacheKey *key, Vol *d, Dir *to_part)
   Dir *e = NULL;
   Dir *b = dir_bucket(bi, seg);
   Vol *vol = d;
+  if (d->fast_vol && dir_head(to_part))
+    d->tier_evict(key);
+  DirLock dlock(d, s);
 #if defined(DEBUG) && defined(DO_CHECK_DIR_FAST)
   unsigned int t = DIR_MASK_TAG(key->slice32(2));
   Dir *col = b;
@@ -611,11 +821,13 @@ Llink:
 Lfill:
   dir_assign_data(e, to_part);
   dir_set_tag(e, key->slice32(2));
+  if (d->tag_index)
+    tag_index_add(tag_index_bucket(d, s, bi), dir_tag(e));
   ink_assert(vol_offset(d, e) < (d->skip + d->len));
   DDebug("dir_insert", "insert %p %X into vol %d bucket %d at %p tag %X %X boffset %" PRId64 "", e, key->slice32(0), d->fd, bi, e,
          key->slice32(1), dir_tag(e), dir_offset(e));
   CHECK_DIR(d);
-  d->header->dirty = 1;
+  dir_segment_dirty(s, d);
   CACHE_INC_DIR_USED(d->mutex);
   return 1;
 }
@@ -636,6 +848,9 @@ dir_overwrite(const CacheKey *key, Vol *d, Dir *dir, Dir *overwrite, bool must_o
   bool loop_possible = true;
 #endif
   Vol *vol = d;
+  if (d->fast_vol && dir_head(dir))
+    d->tier_evict(key);
+  DirLock dlock(d, s);
   CHECK_DIR(d);
 
   ink_assert((unsigned int)dir_approx_size(dir) <= (unsigned int)(MAX_FRAG_SIZE + sizeofDoc)); // XXX - size should be unsigned
@@ -684,11 +899,13 @@ Llink:
 Lfill:
   dir_assign_data(e, dir);
   dir_set_tag(e, t);
+  if (d->tag_index)
+    tag_index_add(tag_index_bucket(d, s, bi), t);
   ink_assert(vol_offset(d, e) < d->skip + d->len);
   DDebug("dir_overwrite", "overwrite %p %X into vol %d bucket %d at %p tag %X %X boffset %" PRId64 "", e, key->slice32(0), d->fd,
          bi, e, t, dir_tag(e), dir_offset(e));
   CHECK_DIR(d);
-  d->header->dirty = 1;
+  dir_segment_dirty(s, d);
   return res;
 }
 
@@ -704,6 +921,9 @@ dir_delete(const CacheKey *key, Vol *d, Dir *del)
   int loop_count = 0;
 #endif
   Vol *vol = d;
+  if (d->fast_vol && dir_head(del))
+    d->tier_evict(key);
+  DirLock dlock(d, s);
   CHECK_DIR(d);
 
   e = dir_bucket(b, seg);
@@ -923,10 +1143,19 @@ sync_cache_dir_on_shutdown(void)
     d->hit_evacuate_window = (d->data_blocks * cache_config_hit_evacuate_percent) / 100;
 
 
+    // the buffers being written have their directory entries inserted,
+    // write them again in order before the one being filled
+    for (AggBuffer *b = d->agg_writing.head; b; b = b->link.next) {
+      int r = pwrite(d->fd, b->buf, b->io.aiocb.aio_nbytes, b->io.aiocb.aio_offset);
+      if (r != (int)b->io.aiocb.aio_nbytes)
+        ink_assert(!"flusing agg buffer failed");
+      d->header->last_write_pos = b->io.aiocb.aio_offset;
+    }
+
     // check if we have data in the agg buffer
     // dont worry about the cachevc s in the agg queue
     // directories have not been inserted for these writes
-    if (d->agg_buf_pos) {
+    if (d->agg_buf_pos && d->agg_buffer) {
       Debug("cache_dir_sync", "Dir %s: flushing agg buffer first", d->hash_text.get());
 
       // set write limit
@@ -1015,10 +1244,11 @@ Lrestart:
     // AIO Thread
     if (io.aio_result != (int64_t)io.aiocb.aio_nbytes) {
       Warning("vol write error during directory sync '%s'", gvol[vol_idx]->hash_text.get());
-      event = EVENT_NONE;
-      goto Ldone;
+      // the segments are put back under the lock
+      failed = true;
+    } else {
+      CACHE_SUM_DYN_STAT(cache_directory_sync_bytes_stat, io.aio_result);
     }
-    CACHE_SUM_DYN_STAT(cache_directory_sync_bytes_stat, io.aio_result);
 
     trigger = eventProcessor.schedule_in(this, SYNC_DELAY);
     return EVENT_CONT;
@@ -1039,8 +1269,23 @@ Lrestart:
     if (DISK_BAD(vol->disk))
       goto Ldone;
 
-    int headerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+    int headerlen = vol_headerlen(vol);
+    int footerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
     size_t dirlen = vol_dirlen(vol);
+    off_t seglen = vol->buckets * DIR_DEPTH * SIZEOF_DIR;
+    uint8_t B = (vol->header->sync_serial & 1) ? DIR_DIRTY_B : DIR_DIRTY_A;
+
+    if (failed) {
+      // the copy is left incomplete, its segments are written again next time
+      for (int s = 0; s < vol->segments; s++)
+        if (segs[s])
+          vol->dir_dirty[s] |= B;
+      // and the stripe is synced again even if nothing else changes meanwhile
+      vol->header->dirty = 1;
+      vol->dir_sync_in_progress = 0;
+      failed = false;
+      goto Ldone;
+    }
     if (!writepos) {
       // start
       Debug("cache_dir_sync", "sync started");
@@ -1054,7 +1299,7 @@ Lrestart:
         Debug("cache_dir_sync", "Dir %s not dirty", vol->hash_text.get());
         goto Ldone;
       }
-      if (vol->is_io_in_progress() || vol->agg_buf_pos) {
+      if (vol->is_io_in_progress() || vol->agg_buf_pos || vol->agg_writing.head) {
         Debug("cache_dir_sync", "Dir %s: waiting for agg buffer", vol->hash_text.get());
         vol->dir_sync_waiting = 1;
         if (!vol->is_io_in_progress())
@@ -1081,31 +1326,53 @@ Lrestart:
           buf_huge = false;
         }
       }
+      if (segslen < vol->segments) {
+        ats_free(segs);
+        segslen = vol->segments;
+        segs = (uint8_t *)ats_malloc(segslen);
+      }
       vol->header->sync_serial++;
       vol->footer->sync_serial = vol->header->sync_serial;
       CHECK_DIR(d);
       memcpy(buf, vol->raw_dir, dirlen);
+      // only the segments changed since this copy was last written
+      B = (vol->header->sync_serial & 1) ? DIR_DIRTY_B : DIR_DIRTY_A;
+      int nsegs = 0;
+      for (int s = 0; s < vol->segments; s++) {
+        segs[s] = vol->dir_dirty[s] & B;
+        vol->dir_dirty[s] &= ~B;
+        nsegs += segs[s] ? 1 : 0;
+      }
+      CACHE_SUM_DYN_STAT(cache_directory_sync_segments_stat, nsegs);
+      CACHE_SUM_DYN_STAT(cache_directory_sync_segments_skipped_stat, vol->segments - nsegs);
+      seg = 0;
       vol->dir_sync_in_progress = 1;
     }
-    size_t B = vol->header->sync_serial & 1;
-    off_t start = vol->skip + (B ? dirlen : 0);
+    off_t start = vol->skip + (B == DIR_DIRTY_B ? dirlen : 0);
 
+    // skip to the next segment to write
+    while (writepos && seg < vol->segments && !segs[seg])
+      seg++;
     if (!writepos) {
-      // write header
-      aio_write(vol->fd, buf + writepos, headerlen, start + writepos);
-      writepos += headerlen;
-    } else if (writepos < (off_t)dirlen - headerlen) {
-      // write part of body
-      int l = SYNC_MAX_WRITE;
-      if (writepos + l > (off_t)dirlen - headerlen)
-        l = dirlen - headerlen - writepos;
-      aio_write(vol->fd, buf + writepos, l, start + writepos);
-      writepos += l;
+      // write header, with the freelists
+      aio_write(vol->fd, buf, headerlen, start);
+      writepos = headerlen;
+    } else if (seg < vol->segments) {
+      // write a run of segments, in whole store blocks
+      int end = seg + 1;
+      while (end < vol->segments && segs[end] && (end + 1 - seg) * seglen <= SYNC_MAX_WRITE)
+        end++;
+      off_t b = headerlen + (seg * seglen) / STORE_BLOCK_SIZE * STORE_BLOCK_SIZE;
+      off_t e = ROUND_TO_STORE_BLOCK(headerlen + end * seglen);
+      if (e > (off_t)dirlen - footerlen)
+        e = dirlen - footerlen;
+      aio_write(vol->fd, buf + b, e - b, start + b);
+      writepos = e;
+      seg = end;
     } else if (writepos < (off_t)dirlen) {
-      ink_assert(writepos == (off_t)dirlen - headerlen);
       // write footer
-      aio_write(vol->fd, buf + writepos, headerlen, start + writepos);
-      writepos += headerlen;
+      aio_write(vol->fd, buf + dirlen - footerlen, footerlen, start + dirlen - footerlen);
+      writepos = dirlen;
     } else {
       vol->dir_sync_in_progress = 0;
       CACHE_INCREMENT_DYN_STAT(cache_directory_sync_count_stat);
@@ -1500,3 +1767,79 @@ EXCLUSIVE_REGRESSION_TEST(Cache_dir)(RegressionTest *t, int /* atype ATS_UNUSED
   vol_dir_clear(d);
   *status = ret;
 }
+
+static int
+regress_probe_rate(Vol *d, unsigned int seed, int n, int *found)
+{
+  CacheKey key;
+  Dir dir;
+
+  *found = 0;
+  regress_rand_init(seed);
+  ink_hrtime ttime = ink_get_hrtime_internal();
+  for (int i = 0; i < n; i++) {
+    Dir *last_collision = 0;
+    regress_rand_CacheKey(&key);
+    *found += dir_probe(&key, d, &dir, &last_collision);
+  }
+  uint64_t us = (ink_get_hrtime_internal() - ttime) / HRTIME_USECOND;
+  return us ? (int)((n * (uint64_t)1000000) / us) : 0;
+}
+
+EXCLUSIVE_REGRESSION_TEST(Cache_dir_tag_index)(RegressionTest *t, int /* atype ATS_UNUSED */, int *status)
+{
+  int ret = REGRESSION_TEST_PASSED;
+
+  if ((CacheProcessor::IsCacheEnabled() != CACHE_INITIALIZED) || gnvol < 1) {
+    rprintf(t, "cache not ready/configured");
+    *status = REGRESSION_TEST_FAILED;
+    return;
+  }
+  Vol *d = gvol[0];
+  EThread *thread = this_ethread();
+  MUTEX_TRY_LOCK(lock, d->mutex, thread);
+  ink_release_assert(lock.is_locked());
+  uint16_t *tag_index = d->tag_index;
+
+  Dir dir;
+  dir_clear(&dir);
+  dir_set_phase(&dir, 0);
+  dir_set_head(&dir, true);
+  dir_set_offset(&dir, 1);
+
+  // probes of the documents in the directory and of others, with and without the tag index
+  static const int fill[] = {25, 50, 75, 90};
+  for (unsigned f = 0; f < countof(fill); f++) {
+    d->tag_index = NULL;
+    vol_dir_clear(d);
+    d->header->agg_pos = d->header->write_pos += 1024;
+    CacheKey key;
+    int n = (int)(vol_direntries(d) * (fill[f] / 100.0));
+    regress_rand_init(17);
+    for (int i = 0; i < n; i++) {
+      regress_rand_CacheKey(&key);
+      dir_insert(&key, d, &dir);
+    }
+    int hits, misses, index_hits, index_misses;
+    int hit_rate = regress_probe_rate(d, 17, n, &hits);
+    int miss_rate = regress_probe_rate(d, 31, n, &misses);
+    d->tag_index = tag_index;
+    dir_tag_index_init(d);
+    int index_hit_rate = regress_probe_rate(d, 17, n, &index_hits);
+    int index_miss_rate = regress_probe_rate(d, 31, n, &index_misses);
+    tag_index = d->tag_index;
+    rprintf(t, "%d%% full: hit probe rate = %d / second, %d / second with the tag index\n", fill[f], hit_rate, index_hit_rate);
+    rprintf(t, "%d%% full: miss probe rate = %d / second, %d / second with the tag index\n", fill[f], miss_rate,
+            index_miss_rate);
+    if (hits != index_hits || misses != index_misses)
+      ret = REGRESSION_TEST_FAILED;
+  }
+  // put the directory and the tag index back the way they were configured
+  if (!cache_config_dir_tag_index) {
+    ats_memalign_free(tag_index);
+    tag_index = NULL;
+  }
+  d->tag_index = tag_index;
+  vol_dir_clear(d);
+  *status = ret;
+}
@@ -37,6 +37,13 @@ CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fil
   io.aiocb.aio_fildes = fd;
   io.aiocb.aio_reqprio = 0;
   io.action = this;
+  ink_aio_register_fd(fd);
+#ifdef HAVE_SYS_SENDFILE_H
+  // sendfile() goes through the page cache, which the O_DIRECT writes to the disk keep coherent.
+  if (cache_config_sendfile_min_size > 0 && (sendfile_fd = ::open(path, O_RDONLY)) < 0) {
+    Warning("unable to open '%s' for sendfile, fragments will be read into memory: %s", path, strerror(errno));
+  }
+#endif
   // determine header size and hence start point by successive approximation
   uint64_t l;
   for (int i = 0; i < 3; i++) {
@@ -79,6 +86,9 @@ CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fil
 
 CacheDisk::~CacheDisk()
 {
+  if (sendfile_fd >= 0) {
+    ::close(sendfile_fd);
+  }
   if (path) {
     ats_free(path);
     for (int i = 0; i < (int)header->num_volumes; i++) {
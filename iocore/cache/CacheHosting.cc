@@ -423,7 +423,8 @@ CacheHostRecord::Init(CacheType typ)
   num_cachevols = 0;
   CacheVol *cachep = cp_list.head;
   for (; cachep; cachep = cachep->link.next) {
-    if (cachep->scheme == type) {
+    // the fast tier only holds copies of the documents of the other volumes
+    if (cachep->scheme == type && !cachep->fast_tier) {
       Debug("cache_hosting", "Host Record: %p, Volume: %d, size: %" PRId64, this, cachep->vol_number, (int64_t)cachep->size);
       cp[num_cachevols] = cachep;
       num_cachevols++;
@@ -627,6 +628,8 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
   CacheType scheme = CACHE_NONE_TYPE;
   int size = 0;
   int in_percent = 0;
+  int agg_buffer_size = 0;
+  int agg_buffers = 0;
   const char *matcher_name = "[CacheVolition]";
 
   memset(volume_seen, 0, sizeof(volume_seen));
@@ -643,6 +646,7 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
   tmp = bufTok.iterFirst(&i_state);
   while (tmp != NULL) {
     state = PAIR_ZERO;
+    agg_buffer_size = agg_buffers = 0;
     line_num++;
 
     // skip all blank spaces at beginning of line
@@ -664,6 +668,8 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
         }
         configp->scheme = scheme;
         configp->size = size;
+        configp->agg_buffer_size = agg_buffer_size;
+        configp->agg_buffers = agg_buffers;
         configp->cachep = NULL;
         cp_queue.enqueue(configp);
         num_volumes++;
@@ -782,6 +788,22 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
           in_percent = 0;
         state = DONE;
         break;
+
+      case DONE:
+        // optional
+        if (!strcasecmp(tmp, "agg_buffer_size")) {
+          tmp += 16;
+          agg_buffer_size = atoi(tmp);
+        } else if (!strcasecmp(tmp, "agg_buffers")) {
+          tmp += 12;
+          agg_buffers = atoi(tmp);
+        } else {
+          state = INK_ERROR;
+          break;
+        }
+        while (ParseRules::is_digit(*tmp))
+          tmp++;
+        break;
       }
 
       if (state == INK_ERROR || *tmp) {
@@ -30,6 +30,8 @@
 #define READ_WHILE_WRITER 1
 extern int cache_config_compatibility_4_2_0_fixup;
 
+ClassAllocator<CacheReadAhead> cacheReadAheadAllocator("cacheReadAhead");
+
 Action *
 Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, const char *hostname, int host_len)
 {
@@ -44,8 +46,15 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
   ProxyMutex *mutex = cont->mutex;
   OpenDirEntry *od = NULL;
   CacheVC *c = NULL;
+
+  Vol *tier_vol = vol;
+  vol = vol->read_tier(key, mutex->thread_holding);
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked() && vol == tier_vol && !vol->open_dir.may_be_open(key) && !dir_group_probe(key, vol)) {
+      CACHE_INCREMENT_DYN_STAT(cache_dir_group_miss_stat);
+      goto Lmiss;
+    }
     if (!lock.is_locked() || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c = new_CacheVC(cont);
       SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
@@ -54,19 +63,22 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
       CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
       c->first_key = c->key = c->earliest_key = *key;
       c->vol = vol;
+      c->tier_vol = vol != tier_vol ? tier_vol : NULL;
       c->frag_type = type;
       c->od = od;
     }
     if (!c)
       goto Lmiss;
     if (!lock.is_locked()) {
+      CACHE_LOCK_MISS_STAT(mutex->thread_holding, vol);
       CONT_SCHED_LOCK_RETRY(c);
       return &c->_action;
     }
     if (c->od)
       goto Lwriter;
-    c->dir = result;
+    c->dir = c->first_dir = result;
     c->last_collision = last_collision;
+    c->f.tier_promote = vol->tier_promote_due(key);
     switch (c->do_read_call(&c->key)) {
     case EVENT_DONE:
       return ACTION_RESULT_DONE;
@@ -108,12 +120,19 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
   OpenDirEntry *od = NULL;
   CacheVC *c = NULL;
 
+  Vol *tier_vol = vol;
+  vol = vol->read_tier(key, mutex->thread_holding);
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked() && vol == tier_vol && !vol->open_dir.may_be_open(key) && !dir_group_probe(key, vol)) {
+      CACHE_INCREMENT_DYN_STAT(cache_dir_group_miss_stat);
+      goto Lmiss;
+    }
     if (!lock.is_locked() || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c = new_CacheVC(cont);
       c->first_key = c->key = c->earliest_key = *key;
       c->vol = vol;
+      c->tier_vol = vol != tier_vol ? tier_vol : NULL;
       c->vio.op = VIO::READ;
       c->base_stat = cache_read_active_stat;
       CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
@@ -124,6 +143,7 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
     }
     if (!lock.is_locked()) {
       SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
+      CACHE_LOCK_MISS_STAT(mutex->thread_holding, vol);
       CONT_SCHED_LOCK_RETRY(c);
       return &c->_action;
     }
@@ -134,6 +154,7 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
     // hit
     c->dir = c->first_dir = result;
     c->last_collision = last_collision;
+    c->f.tier_promote = vol->tier_promote_due(key);
     SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
     switch (c->do_read_call(&c->key)) {
     case EVENT_DONE:
@@ -531,10 +552,141 @@ CacheVC::openReadClose(int event, Event * /* e ATS_UNUSED */)
       vol->force_evacuate_head(&earliest_dir, dir_pinned(&earliest_dir));
     }
   }
+  if (f.tier_promote && closed > 0 && vio.ndone >= (int64_t)doc_len)
+    tier_promote_head();
+  if (vol->cache_vol->fast_tier) {
+    CACHE_INCREMENT_DYN_STAT(cache_tier_fast_hits_stat);
+    CACHE_SUM_DYN_STAT(cache_tier_fast_bytes_stat, vio.ndone);
+  } else {
+    CACHE_INCREMENT_DYN_STAT(cache_tier_slow_hits_stat);
+    CACHE_SUM_DYN_STAT(cache_tier_slow_bytes_stat, vio.ndone);
+  }
   vol->close_read(this);
   return free_CacheVC(this);
 }
 
+static void
+free_CacheReadAhead(CacheReadAhead *r)
+{
+  r->io.action.continuation = NULL;
+  r->io.action.mutex = NULL;
+  r->io.mutex.clear();
+  r->buf.clear();
+  r->mutex.clear();
+  cacheReadAheadAllocator.free(r);
+}
+
+int
+CacheReadAhead::readDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  done = true;
+  if (!vc) {
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_wasted_stat);
+    CACHE_SUM_DYN_STAT(cache_read_ahead_wasted_bytes_stat, io.aio_result > 0 ? io.aio_result : 0);
+    free_CacheReadAhead(this);
+    return EVENT_DONE;
+  }
+  if (waiting) {
+    CacheVC *c = vc;
+    c->read_ahead_use(this);
+    return c->handleEvent(AIO_EVENT_DONE, 0);
+  }
+  return EVENT_CONT;
+}
+
+/*
+  Issues the reads of the fragments following the one in @a doc, up to
+  proxy.config.cache.read_ahead_fragments of them in flight, so that a reader going
+  through a large document does not wait for the disk on every fragment. The data
+  is kept here until the reader asks for it, see CacheVC::handleRead().
+*/
+void
+CacheVC::read_ahead(Doc *doc)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  int n = 0;
+  CacheKey k = key;
+  // the data still wanted after this fragment
+  int64_t want = vio.ntodo() - doc->data_len();
+  if (doc_len)
+    want = MIN(want, (int64_t)doc_len - vio.ndone - doc->data_len());
+  for (CacheReadAhead *r = read_ahead_frags.head; r; r = r->link.next, n++) {
+    want -= dir_approx_size(&r->dir) - sizeofDoc;
+    k = r->key;
+  }
+  for (; n < cache_config_read_ahead_fragments && want > 0; n++) {
+    Dir d, *last = NULL;
+    next_CacheKey(&k, &k);
+    // the fragments in the aggregation buffers are copied from there
+    if (!dir_probe(&k, vol, &d, &last) || vol->agg_data(&d))
+      break;
+    CacheReadAhead *r = cacheReadAheadAllocator.alloc();
+    r->vc = this;
+    r->vol = vol;
+    r->mutex = mutex;
+    r->key = k;
+    r->dir = d;
+    r->done = false;
+    r->waiting = false;
+    SET_CONTINUATION_HANDLER(r, &CacheReadAhead::readDone);
+    r->io.aiocb.aio_fildes = vol->fd;
+    r->io.aiocb.aio_offset = vol_offset(vol, &d);
+    r->io.aiocb.aio_nbytes = dir_approx_size(&d);
+    if ((off_t)(r->io.aiocb.aio_offset + r->io.aiocb.aio_nbytes) > (off_t)(vol->skip + vol->len))
+      r->io.aiocb.aio_nbytes = vol->skip + vol->len - r->io.aiocb.aio_offset;
+    r->buf = new_IOBufferData(iobuffer_size_to_index(r->io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    r->io.aiocb.aio_buf = r->buf->data();
+    r->io.action = r;
+    r->io.thread = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
+    read_ahead_frags.enqueue(r);
+    ink_assert(ink_aio_read(&r->io) >= 0);
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_issued_stat);
+    want -= dir_approx_size(&d) - sizeofDoc;
+  }
+}
+
+// The fragment read ahead for the read about to be done, if any. The ones before it were skipped.
+CacheReadAhead *
+CacheVC::read_ahead_match()
+{
+  CacheReadAhead *r = read_ahead_frags.head;
+
+  while (r && r->key != *read_key)
+    r = r->link.next;
+  while (read_ahead_frags.head != r)
+    read_ahead_drop(read_ahead_frags.head);
+  // another collision of the key, it is dropped on the next read
+  if (r && dir_offset(&r->dir) != dir_offset(&dir))
+    return NULL;
+  return r;
+}
+
+// Takes the data of a complete read ahead as if it was read by this VC.
+void
+CacheVC::read_ahead_use(CacheReadAhead *r)
+{
+  ink_assert(r == read_ahead_frags.head && r->done);
+  read_ahead_frags.dequeue();
+  buf = r->buf;
+  io.aiocb.aio_offset = r->io.aiocb.aio_offset;
+  io.aiocb.aio_nbytes = r->io.aiocb.aio_nbytes;
+  io.aio_result = r->io.aio_result;
+  CACHE_INCREMENT_DYN_STAT(cache_read_ahead_used_stat);
+  free_CacheReadAhead(r);
+}
+
+void
+CacheVC::read_ahead_drop(CacheReadAhead *r)
+{
+  read_ahead_frags.remove(r);
+  if (r->done) {
+    CACHE_INCREMENT_DYN_STAT(cache_read_ahead_wasted_stat);
+    CACHE_SUM_DYN_STAT(cache_read_ahead_wasted_bytes_stat, r->io.aio_result > 0 ? r->io.aio_result : 0);
+    free_CacheReadAhead(r);
+  } else
+    r->vc = NULL; // freed when the read is complete
+}
+
 int
 CacheVC::openReadReadDone(int event, Event *e)
 {
@@ -564,8 +716,13 @@ CacheVC::openReadReadDone(int event, Event *e)
           Warning("Middle: Doc magic does not match for %s", key.toHexStr(tmpstring));
         goto Lerror;
       }
-      if (doc->key == key)
+      if (doc->key == key) {
+        if (f.tier_promote)
+          tier_promote(&key, &dir, buf);
+        if (cache_config_read_ahead_fragments && !f.sendfile && !write_vc && !seek_to)
+          read_ahead(doc);
         goto LreadMain;
+      }
     }
     if (last_collision && dir_offset(&dir) != dir_offset(last_collision))
       last_collision = 0; // object has been/is being overwritten
@@ -698,7 +855,10 @@ CacheVC::openReadMain(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     goto Lread;
   if (bytes > vio.ntodo())
     bytes = vio.ntodo();
-  b = new_IOBufferBlock(buf, bytes, doc_pos);
+  if (f.doc_header_only) // the data is still on the disk
+    b = new_IOBufferBlock(new CacheSendfileData(vol, &dir, doc_pos, bytes), bytes, 0);
+  else
+    b = new_IOBufferBlock(buf, bytes, doc_pos);
   b->_buf_end = b->_end;
   vio.buffer.writer()->append_block(b);
   vio.ndone += bytes;
@@ -820,6 +980,8 @@ CacheVC::openReadStartEarliest(int /* event ATS_UNUSED */, Event * /* e ATS_UNUS
       goto Lread;
     // success
     earliest_key = key;
+    if (f.tier_promote)
+      tier_promote(&key, &earliest_dir, buf);
     doc_pos = doc->prefix_len();
     next_CacheKey(&key, &doc->key);
     vol->begin_read(this);
@@ -837,6 +999,9 @@ CacheVC::openReadStartEarliest(int /* event ATS_UNUSED */, Event * /* e ATS_UNUS
         goto Lcallreturn;
       return ret;
     }
+    // the copy in the fast tier is incomplete, its vector is left alone
+    if (tier_vol)
+      goto Ltier;
 // read has detected that alternate does not exist in the cache.
 // rewrite the vector.
 #ifdef HTTP_CACHE
@@ -897,6 +1062,8 @@ CacheVC::openReadStartEarliest(int /* event ATS_UNUSED */, Event * /* e ATS_UNUS
     if (od)
       vol->close_write(this);
   }
+  if (tier_vol)
+    return tier_read_fallback(true);
   CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
   _action.continuation->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NO_DOC);
   return free_CacheVC(this);
@@ -907,6 +1074,8 @@ Lsuccess:
     CACHE_INCREMENT_DYN_STAT(cache_read_busy_success_stat);
   SET_HANDLER(&CacheVC::openReadMain);
   return callcont(CACHE_EVENT_OPEN_READ);
+Ltier:
+  return tier_read_fallback(true);
 }
 
 // create the directory entry after the vector has been evacuated
@@ -1052,6 +1221,9 @@ CacheVC::openReadStartHead(int event, Event *e)
         }
       } else
         alternate_index = 0;
+      // the fast tier holds the vector of a document, only a document with one alternate can be promoted
+      if (vector.count() > 1)
+        f.tier_promote = 0;
       alternate_tmp = vector.get(alternate_index);
       if (!alternate_tmp->valid()) {
         if (buf) {
@@ -1136,6 +1308,8 @@ CacheVC::openReadStartHead(int event, Event *e)
     }
   }
 Ldone:
+  if (tier_vol)
+    return tier_read_fallback(false);
   if (!f.lookup) {
     CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
     _action.continuation->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-err);
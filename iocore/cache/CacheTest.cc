@@ -26,6 +26,7 @@
 #include "P_CacheTest.h"
 #include "api/ts/ts.h"
 #include <vector>
+#include <algorithm>
 
 using namespace std;
 
@@ -392,6 +393,92 @@ EXCLUSIVE_REGRESSION_TEST(cache)(RegressionTest *t, int /* atype ATS_UNUSED */,
   return;
 }
 
+// Several aggregation buffers in flight on one stripe, with an evacuation ahead of them.
+// The stripe is written over once, unless it is too large for a regression test, so that
+// a document forced to be evacuated has to be copied ahead of the buffers being written.
+
+#define AGG_TEST_BUFFERS 4
+#define AGG_TEST_WRITERS 8
+#define AGG_TEST_DOC_SIZE (4 * 1024 * 1024)
+#define AGG_TEST_MAX_WRAP (1024LL * 1024 * 1024)
+
+static Vol *agg_test_vol;
+
+// A random key of a document stored in agg_test_vol.
+static void
+agg_test_key(CacheKey *key, ProxyMutex *mutex)
+{
+  do {
+    rand_CacheKey(key, mutex);
+  } while (caches[CACHE_FRAG_TYPE_NONE]->key_to_vol(key, "", 0) != agg_test_vol);
+}
+
+EXCLUSIVE_REGRESSION_TEST(cache_agg_buffers)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  if (cacheProcessor.IsCacheEnabled() != CACHE_INITIALIZED) {
+    rprintf(t, "cache not initialized");
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+
+  EThread *thread = this_ethread();
+  CacheKey key;
+
+  rand_CacheKey(&key, thread->mutex);
+  agg_test_vol = caches[CACHE_FRAG_TYPE_NONE]->key_to_vol(&key, "", 0);
+  {
+    SCOPED_MUTEX_LOCK(lock, agg_test_vol->mutex, thread);
+    if (agg_test_vol->agg_nbuffers < AGG_TEST_BUFFERS && !agg_test_vol->agg_resize(AGG_TEST_BUFFERS))
+      rprintf(t, "stripe '%s' is busy, its %d aggregation buffers are kept\n", agg_test_vol->hash_text.get(),
+              agg_test_vol->agg_nbuffers);
+  }
+  int64_t in_flight = (int64_t)agg_test_vol->agg_size * agg_test_vol->agg_nbuffers;
+  int64_t total = agg_test_vol->len + 2 * in_flight;
+  if (agg_test_vol->len > AGG_TEST_MAX_WRAP) {
+    rprintf(t, "stripe '%s' is too large to be written over, no evacuation is tested\n", agg_test_vol->hash_text.get());
+    total = 4 * in_flight;
+  }
+  rprintf(t, "writing %" PRId64 " bytes to stripe '%s' through %d aggregation buffers of %d bytes\n", total,
+          agg_test_vol->hash_text.get(), agg_test_vol->agg_nbuffers, agg_test_vol->agg_size);
+
+  CACHE_SM(t, evac_write_test, { cacheProcessor.open_write(this, &key, false, CACHE_FRAG_TYPE_NONE, 100, CACHE_WRITE_OPT_SYNC); });
+  evac_write_test.expect_initial_event = CACHE_EVENT_OPEN_WRITE;
+  evac_write_test.expect_event = VC_EVENT_WRITE_COMPLETE;
+  evac_write_test.nbytes = 100;
+  agg_test_key(&evac_write_test.key, thread->mutex);
+
+  // the document is copied ahead when the stripe gets back to it
+  CACHE_SM(t, evac_force_test, {
+    Dir dir;
+    Dir *last_collision = NULL;
+    SCOPED_MUTEX_LOCK(lock, agg_test_vol->mutex, this_ethread());
+    if (dir_probe(&key, agg_test_vol, &dir, &last_collision))
+      agg_test_vol->force_evacuate_head(&dir, 0);
+    eventProcessor.schedule_imm(this, ET_CALL, AIO_EVENT_DONE);
+  });
+  evac_force_test.expect_event = AIO_EVENT_DONE;
+  evac_force_test.key = evac_write_test.key;
+
+  CACHE_SM(t, fill_write_test, {
+    agg_test_key(&key, mutex);
+    cacheProcessor.open_write(this, &key, false, CACHE_FRAG_TYPE_NONE, AGG_TEST_DOC_SIZE);
+  });
+  fill_write_test.expect_initial_event = CACHE_EVENT_OPEN_WRITE;
+  fill_write_test.expect_event = VC_EVENT_WRITE_COMPLETE;
+  fill_write_test.nbytes = AGG_TEST_DOC_SIZE;
+  fill_write_test.repeat_count = total / (AGG_TEST_DOC_SIZE * AGG_TEST_WRITERS);
+
+  CACHE_SM(t, evac_read_test, { cacheProcessor.open_read(this, &key, false); });
+  evac_read_test.expect_initial_event = CACHE_EVENT_OPEN_READ;
+  evac_read_test.expect_event = VC_EVENT_READ_COMPLETE;
+  evac_read_test.nbytes = 100;
+  evac_read_test.key = evac_write_test.key;
+
+  r_sequential(t, evac_write_test.clone(), evac_force_test.clone(), r_parallel(t, AGG_TEST_WRITERS, fill_write_test.clone()),
+               evac_read_test.clone(), NULL_PTR)
+    ->run(pstatus);
+}
+
 void
 force_link_CacheTest()
 {
@@ -522,8 +609,80 @@ REGRESSION_TEST(ram_cache)(RegressionTest *t, int /* level ATS_UNUSED */, int *p
     *pstatus = REGRESSION_TEST_FAILED;
     return;
   }
-  if (!test_RamCache(t, new_RamCacheLRU()) || !test_RamCache(t, new_RamCacheCLFUS()))
+  if (!test_RamCache(t, new_RamCacheLRU()) || !test_RamCache(t, new_RamCacheCLFUS()) ||
+      !test_RamCache(t, new_RamCacheTinyLFU()))
     *pstatus = REGRESSION_TEST_FAILED;
   else
     *pstatus = REGRESSION_TEST_PASSED;
 }
+
+/*
+  Replays the same trace against each RAM cache, filling it on the misses: lookups of
+  a Zipf distributed set of documents, interrupted by scans of documents looked up once.
+*/
+#define RAM_CACHE_REPLAY_DOCS 20000
+#define RAM_CACHE_REPLAY_LOOKUPS 400000
+#define RAM_CACHE_REPLAY_SCAN_EVERY 40000
+#define RAM_CACHE_REPLAY_SCAN_LEN 10000
+#define RAM_CACHE_REPLAY_SIZE (32 << 20)
+
+static double
+replay_RamCache(RegressionTest *t, const char *name, RamCache *cache, vector<INK_MD5> &trace)
+{
+  CacheKey key;
+  Vol *vol = theCache->key_to_vol(&key, "example.com", sizeof("example.com") - 1);
+  IOBufferData *d = new (ats_malloc(sizeof(IOBufferData))) IOBufferData;
+  Ptr<IOBufferData> data = make_ptr(d);
+  int64_t hits = 0;
+
+  d->alloc(BUFFER_SIZE_INDEX_16K);
+  cache->init(RAM_CACHE_REPLAY_SIZE, vol);
+  ink_hrtime start = ink_get_hrtime();
+  for (size_t i = 0; i < trace.size(); i++) {
+    Ptr<IOBufferData> got;
+    if (cache->get(&trace[i], &got))
+      hits++;
+    else
+      cache->put(&trace[i], data, 1 << 14);
+  }
+  ink_hrtime elapsed = ink_get_hrtime() - start;
+  double ratio = (double)hits / trace.size();
+  rprintf(t, "RamCache %s: hit ratio %.3f, %.0f ops/s\n", name, ratio,
+          elapsed ? trace.size() / ((double)elapsed / HRTIME_SECOND) : 0.0);
+  return ratio;
+}
+
+EXCLUSIVE_REGRESSION_TEST(ram_cache_replay)(RegressionTest *t, int /* level ATS_UNUSED */, int *pstatus)
+{
+  if (cacheProcessor.IsCacheEnabled() != CACHE_INITIALIZED) {
+    rprintf(t, "cache not initialized");
+    *pstatus = REGRESSION_TEST_FAILED;
+    return;
+  }
+
+  InkRand rand(13);
+  vector<double> cdf(RAM_CACHE_REPLAY_DOCS);
+  vector<INK_MD5> trace;
+  double sum = 0;
+  uint64_t scanned = RAM_CACHE_REPLAY_DOCS;
+
+  for (int i = 0; i < RAM_CACHE_REPLAY_DOCS; i++)
+    cdf[i] = (sum += 1.0 / (i + 1));
+  for (int i = 0; i < RAM_CACHE_REPLAY_LOOKUPS; i++) {
+    uint64_t doc;
+    if (i % RAM_CACHE_REPLAY_SCAN_EVERY < RAM_CACHE_REPLAY_SCAN_LEN) {
+      doc = scanned++;
+    } else {
+      doc = lower_bound(cdf.begin(), cdf.end(), rand.drandom() * sum) - cdf.begin();
+    }
+    INK_MD5 md5;
+    MD5Context().hash_immediate(md5, &doc, sizeof(doc));
+    trace.push_back(md5);
+  }
+
+  replay_RamCache(t, "CLFUS", new_RamCacheCLFUS(), trace);
+  double lru = replay_RamCache(t, "LRU", new_RamCacheLRU(), trace);
+  double tinylfu = replay_RamCache(t, "TinyLFU", new_RamCacheTinyLFU(), trace);
+  // the scans flush the LRU, not the TinyLFU
+  *pstatus = tinylfu > lru ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+}
@@ -0,0 +1,309 @@
+/** @file
+
+  Fast storage tier in front of the cache volumes.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  @section details Details
+
+  The spans marked "tier=fast" in storage.config make up the fast tier. The volumes
+  on them are not assigned any documents, instead each stripe of the other volumes is
+  paired with one of their stripes, which holds copies of its documents:
+
+  - A document hit often enough in a stripe is promoted as it is read: the fragments
+    are copied into the aggregation buffer of the fast stripe as they go by, the head
+    last, so that the document is found in the fast stripe only once it is all there.
+  - Reads go to the fast stripe first, and fall back to the stripe of the document when
+    the copy is missing or incomplete.
+  - The vector of the document is copied along with it, so only documents with a single
+    alternate are promoted, otherwise the other alternates would be missed in the fast
+    stripe.
+  - The copies are dropped whenever the head of the document changes in its stripe.
+  - The fast stripe evacuates like any other, the documents still being hit stay, the
+    cold ones are overwritten and are read from their own stripe again.
+ */
+
+#include "P_Cache.h"
+
+extern int gndisks;
+extern Queue<CacheVol> cp_list;
+
+// Number of promotion counters per stripe.
+#define TIER_HITS_SIZE (1 << 16)
+
+// Drops the copies of a document from a fast stripe whose lock was busy.
+struct TierEvict : public Continuation {
+  Vol *vol;
+  CacheKey key;
+
+  int evictEvent(int event, Event *e);
+
+  TierEvict(Vol *v, const CacheKey *k) : Continuation(v->mutex), vol(v), key(*k) { SET_HANDLER(&TierEvict::evictEvent); }
+};
+
+static void
+tier_evict_copies(const CacheKey *key, Vol *vol)
+{
+  Dir dir, *last_collision = NULL;
+  CacheVC *c, *next;
+
+  while (dir_probe(key, vol, &dir, &last_collision)) {
+    dir_delete(key, vol, &dir);
+    last_collision = NULL;
+  }
+  // and the copies not yet in the aggregation buffer
+  for (c = (CacheVC *)vol->agg.head; c; c = next) {
+    next = (CacheVC *)c->link.next;
+    if (c->f.tier_promoter && c->key == *key) {
+      vol->agg.remove(c);
+      vol->agg_todo_size -= c->agg_len;
+      free_CacheVC(c);
+    }
+  }
+}
+
+int
+TierEvict::evictEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  tier_evict_copies(&key, vol);
+  delete this;
+  return EVENT_DONE;
+}
+
+void
+Cache::tier_init()
+{
+  int nfast = 0, nslow = 0;
+  CacheVol *cp;
+
+  for (cp = cp_list.head; cp; cp = cp->link.next) {
+    if (cp->scheme != scheme)
+      continue;
+    int ndisks = 0, nfast_disks = 0;
+    for (int i = 0; i < gndisks; i++) {
+      if (cp->disk_vols[i]) {
+        ndisks++;
+        if (cp->disk_vols[i]->disk->fast_tier)
+          nfast_disks++;
+      }
+    }
+    cp->fast_tier = ndisks && nfast_disks == ndisks;
+    if (nfast_disks && !cp->fast_tier)
+      Warning("volume %d is on spans of both tiers, it is not part of the fast tier", cp->vol_number);
+    if (cp->fast_tier)
+      nfast += cp->num_vols;
+  }
+  if (!nfast)
+    return;
+
+  Vol **fast = (Vol **)ats_malloc(nfast * sizeof(Vol *));
+  nfast = 0;
+  for (cp = cp_list.head; cp; cp = cp->link.next) {
+    if (cp->scheme == scheme && cp->fast_tier) {
+      for (int i = 0; i < cp->num_vols; i++) {
+        if (!DISK_BAD(cp->vols[i]->disk))
+          fast[nfast++] = cp->vols[i];
+      }
+    }
+  }
+  for (cp = cp_list.head; nfast && cp; cp = cp->link.next) {
+    if (cp->scheme == scheme && !cp->fast_tier) {
+      for (int i = 0; i < cp->num_vols; i++, nslow++) {
+        cp->vols[i]->fast_vol = fast[nslow % nfast];
+        cp->vols[i]->tier_hits = (uint8_t *)ats_calloc(TIER_HITS_SIZE, sizeof(uint8_t));
+      }
+    }
+  }
+  Note("cache fast tier: %d stripes in front of %d", nfast, nslow);
+  ats_free(fast);
+}
+
+Vol *
+Vol::read_tier(const CacheKey *key, EThread *t)
+{
+  if (!fast_vol || DISK_BAD(fast_vol->disk))
+    return this;
+  MUTEX_TRY_LOCK(lock, fast_vol->mutex, t);
+  Dir dir, *last_collision = NULL;
+  if (lock.is_locked() && dir_probe(key, fast_vol, &dir, &last_collision))
+    return fast_vol;
+  return this;
+}
+
+bool
+Vol::tier_promote_due(const CacheKey *key)
+{
+  ink_assert(mutex->thread_holding == this_ethread());
+  if (!fast_vol || cache_config_tier_promote_hits <= 0 || DISK_BAD(fast_vol->disk))
+    return false;
+  // age the counts, so that it takes recent hits to be promoted
+  if (++tier_hits_count >= TIER_HITS_SIZE) {
+    for (int i = 0; i < TIER_HITS_SIZE; i++)
+      tier_hits[i] >>= 1;
+    tier_hits_count = 0;
+  }
+  uint8_t *hits = &tier_hits[key->slice32(3) % TIER_HITS_SIZE];
+  if (*hits < UINT8_MAX)
+    ++*hits;
+  if (*hits < cache_config_tier_promote_hits)
+    return false;
+  *hits = 0;
+  return true;
+}
+
+// Called by the directory when the head of a document changes.
+void
+Vol::tier_evict(const CacheKey *key)
+{
+  ink_assert(mutex->thread_holding == this_ethread());
+  MUTEX_TRY_LOCK(lock, fast_vol->mutex, this_ethread());
+  if (lock.is_locked())
+    tier_evict_copies(key, fast_vol);
+  else
+    eventProcessor.schedule_imm(new TierEvict(fast_vol, key), ET_CALL);
+}
+
+/*
+  Queues a copy of a fragment read for the aggregation buffer of the fast stripe, the
+  way an evacuated fragment is. The promotion of the document is given up when the
+  fragment can not be copied.
+*/
+void
+CacheVC::tier_promote(const CacheKey *akey, Dir *adir, IOBufferData *data)
+{
+  Vol *fast = vol->fast_vol;
+  Doc *doc = (Doc *)data->data();
+  CacheVC *c = NULL;
+  Dir copy, *last_copy = NULL;
+
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  if (f.doc_header_only || (cache_config_tier_promote_max_size && doc_len > (uint64_t)cache_config_tier_promote_max_size))
+    goto Lfail;
+  {
+    MUTEX_TRY_LOCK(lock, fast->mutex, mutex->thread_holding);
+    if (!lock.is_locked() || DISK_BAD(fast->disk) || fast->agg_todo_size > cache_config_agg_write_backlog)
+      goto Lfail;
+    // a head already there is left from an earlier promotion of the same document
+    if (dir_head(adir) && dir_probe(akey, fast, &copy, &last_copy))
+      return;
+    c = new_CacheVC(fast);
+    c->base_stat = cache_evacuate_active_stat;
+    CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
+    c->buf = data;
+    c->vol = fast;
+    c->key = *akey;
+    c->earliest_key = zero_key;
+    c->overwrite_dir = *adir;
+    c->f.evacuator = 1;
+    c->f.tier_promoter = 1;
+    c->agg_len = fast->round_to_approx_size(doc->len);
+    SET_CONTINUATION_HANDLER(c, &CacheVC::tierPromoteDone);
+    fast->agg_todo_size += c->agg_len;
+    fast->agg.enqueue(c);
+    if (!fast->is_io_in_progress())
+      fast->aggWrite(EVENT_NONE, 0);
+  }
+  return;
+Lfail:
+  f.tier_promote = 0;
+}
+
+void
+CacheVC::tier_promote_head()
+{
+  Dir head, *head_collision = NULL;
+  bool current = false;
+
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  // the document may have been updated or removed since it was opened
+  while (!current && dir_probe(&first_key, vol, &head, &head_collision))
+    current = dir_offset(&head) == dir_offset(&first_dir);
+  if (!current)
+    return;
+
+  Ptr<IOBufferData> data = first_buf;
+#ifdef HTTP_CACHE
+  if (frag_type == CACHE_FRAG_TYPE_HTTP) {
+    if (vector.count() != 1)
+      return;
+    // the vector was unmarshaled in place, marshal it again into a copy of the head
+    Doc *doc = (Doc *)first_buf->data();
+    int hlen = vector.marshal_length();
+    uint32_t len = sizeofDoc + hlen + doc->data_len();
+    if (len > MAX_FRAG_SIZE + sizeofDoc)
+      return;
+    data = new_IOBufferData(iobuffer_size_to_index(len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    Doc *copy = (Doc *)data->data();
+    memcpy(copy, doc, sizeofDoc);
+    copy->len = len;
+    copy->hlen = hlen;
+    vector.marshal(copy->hdr(), hlen);
+    memcpy(copy->data(), doc->data(), doc->data_len());
+    copy->checksum = DOC_NO_CHECKSUM;
+    if (cache_config_enable_checksum) {
+      copy->checksum = 0;
+      for (char *b = copy->hdr(); b < (char *)copy + copy->len; b++)
+        copy->checksum += *b;
+    }
+  }
+#endif
+  tier_promote(&first_key, &first_dir, data);
+  if (f.tier_promote) {
+    CACHE_INCREMENT_DYN_STAT(cache_tier_promotions_stat);
+  }
+}
+
+/*
+  The copy read from the fast stripe is missing or incomplete, the document is read from
+  its own stripe again. The copy is dropped when its fragments are gone, so that the next
+  reads do not go to the fast stripe for it.
+*/
+int
+CacheVC::tier_read_fallback(bool drop_copy)
+{
+  if (drop_copy) {
+    MUTEX_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (lock.is_locked())
+      tier_evict_copies(&first_key, vol);
+    else
+      eventProcessor.schedule_imm(new TierEvict(vol, &first_key), ET_CALL);
+  }
+  vol = tier_vol;
+  tier_vol = NULL;
+  buf = NULL;
+  first_buf = NULL;
+  key = earliest_key = first_key;
+  last_collision = NULL;
+#ifdef HTTP_CACHE
+  vector.clear();
+#endif
+  CACHE_INCREMENT_DYN_STAT(cache_tier_fallbacks_stat);
+  SET_HANDLER(&CacheVC::openReadStartHead);
+  return openReadStartHead(EVENT_IMMEDIATE, 0);
+}
+
+// The copy is in the aggregation buffer of the fast stripe, the fast stripe lock is held.
+int
+CacheVC::tierPromoteDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  dir_insert(&key, vol, &dir);
+  CACHE_SUM_DYN_STAT(cache_tier_promoted_bytes_stat, ((Doc *)buf->data())->len);
+  return free_CacheVC(this);
+}
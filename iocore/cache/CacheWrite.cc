@@ -24,6 +24,8 @@
 
 #include "P_Cache.h"
 
+extern ConfigVolumes config_volumes;
+
 #define IS_POWER_2(_x) (!((_x) & ((_x)-1)))
 #define UINT_WRAP_LTE(_x, _y) (((_y) - (_x)) < INT_MAX) // exploit overflow
 #define UINT_WRAP_GTE(_x, _y) (((_x) - (_y)) < INT_MAX) // exploit overflow
@@ -268,10 +270,11 @@ void
 Vol::scan_for_pinned_documents()
 {
   if (cache_config_permit_pinning) {
-    // we can't evacuate anything between header->write_pos and
-    // header->write_pos + AGG_SIZE.
-    int ps = offset_to_vol_offset(this, header->write_pos + AGG_SIZE);
-    int pe = offset_to_vol_offset(this, header->write_pos + 2 * EVACUATION_SIZE + (len / PIN_SCAN_EVERY));
+    // we can't evacuate anything between header->write_pos and the end
+    // of the aggregation buffers which may be written ahead of it.
+    off_t agg_end = header->write_pos + (off_t)agg_size * agg_nbuffers;
+    int ps = offset_to_vol_offset(this, agg_end);
+    int pe = offset_to_vol_offset(this, agg_end + 2 * EVACUATION_SIZE + (len / PIN_SCAN_EVERY));
     int vol_end_offset = offset_to_vol_offset(this, len + skip);
     int before_end_of_vol = pe < vol_end_offset;
     DDebug("cache_evac", "scan %d %d", ps, pe);
@@ -295,13 +298,19 @@ Vol::scan_for_pinned_documents()
   }
 }
 
+int
+AggBuffer::writeDone(int event, Event *e)
+{
+  return vol->aggWriteDone(this, event, e);
+}
+
 /* NOTE:: This state can be called by an AIO thread, so DON'T DON'T
    DON'T schedule any events on this thread using VC_SCHED_XXX or
    mutex->thread_holding->schedule_xxx_local(). ALWAYS use
    eventProcessor.schedule_xxx().
    */
 int
-Vol::aggWriteDone(int event, Event *e)
+Vol::aggWriteDone(AggBuffer *b, int event, Event *e)
 {
   cancel_trigger();
 
@@ -309,54 +318,59 @@ Vol::aggWriteDone(int event, Event *e)
   // retaking the current mutex recursively is a NOOP
   CACHE_TRY_LOCK(lock, dir_sync_waiting ? cacheDirSync->mutex : mutex, mutex->thread_holding);
   if (!lock.is_locked()) {
-    eventProcessor.schedule_in(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
+    eventProcessor.schedule_in(b, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
     return EVENT_CONT;
   }
-  if (io.ok()) {
-    header->last_write_pos = header->write_pos;
-    header->write_pos += io.aiocb.aio_nbytes;
-    ink_assert(header->write_pos >= start);
-    DDebug("cache_agg", "Dir %s, Write: %" PRIu64 ", last Write: %" PRIu64 "\n", hash_text.get(), header->write_pos,
-           header->last_write_pos);
-    ink_assert(header->write_pos == header->agg_pos);
-    if (header->write_pos + EVACUATION_SIZE > scan_pos)
-      periodic_scan();
-    agg_buf_pos = 0;
-    header->write_serial++;
-  } else {
-    // delete all the directory entries that we inserted
-    // for fragments is this aggregation buffer
-    Debug("cache_disk_error", "Write error on disk %s\n \
+  b->done = true;
+  // the writes complete in any order, they are done in the order they were issued
+  while ((b = agg_writing.head) && b->done) {
+    agg_writing.dequeue();
+    // the writers waiting on this buffer are let go either way, the entries of a failed write are gone
+    write_serial_done = b->write_serial + 1;
+    if (b->io.ok()) {
+      header->last_write_pos = b->io.aiocb.aio_offset;
+      DDebug("cache_agg", "Dir %s, Write: %" PRIu64 ", last Write: %" PRIu64 "\n", hash_text.get(), header->write_pos,
+             header->last_write_pos);
+    } else {
+      // delete all the directory entries that we inserted
+      // for fragments is this aggregation buffer
+      Debug("cache_disk_error", "Write error on disk %s\n \
               write range : [%" PRIu64 " - %" PRIu64 " bytes]  [%" PRIu64 " - %" PRIu64 " blocks] \n",
-          hash_text.get(), (uint64_t)io.aiocb.aio_offset, (uint64_t)io.aiocb.aio_offset + io.aiocb.aio_nbytes,
-          (uint64_t)io.aiocb.aio_offset / CACHE_BLOCK_SIZE,
-          (uint64_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) / CACHE_BLOCK_SIZE);
-    Dir del_dir;
-    dir_clear(&del_dir);
-    for (int done = 0; done < agg_buf_pos;) {
-      Doc *doc = (Doc *)(agg_buffer + done);
-      dir_set_offset(&del_dir, header->write_pos + done);
-      dir_delete(&doc->key, this, &del_dir);
-      done += round_to_approx_size(doc->len);
+            hash_text.get(), (uint64_t)b->io.aiocb.aio_offset, (uint64_t)b->io.aiocb.aio_offset + b->io.aiocb.aio_nbytes,
+            (uint64_t)b->io.aiocb.aio_offset / CACHE_BLOCK_SIZE,
+            (uint64_t)(b->io.aiocb.aio_offset + b->io.aiocb.aio_nbytes) / CACHE_BLOCK_SIZE);
+      Dir del_dir;
+      dir_clear(&del_dir);
+      for (int done = 0; done < (int)b->io.aiocb.aio_nbytes;) {
+        Doc *doc = (Doc *)(b->buf + done);
+        dir_set_offset(&del_dir, offset_to_vol_offset(this, b->io.aiocb.aio_offset + done));
+        dir_delete(&doc->key, this, &del_dir);
+        done += round_to_approx_size(doc->len);
+      }
     }
-    agg_buf_pos = 0;
+    b->done = false;
+    agg_free.enqueue(b);
+  }
+  if (!agg_buffer && agg_free.head) {
+    agg_fill = agg_free.dequeue();
+    agg_buffer = agg_fill->buf;
   }
-  set_io_not_in_progress();
   // callback ready sync CacheVCs
   CacheVC *c = 0;
   while ((c = sync.dequeue())) {
-    if (UINT_WRAP_LTE(c->write_serial + 2, header->write_serial))
+    if (UINT_WRAP_LTE(c->write_serial + 2, write_serial_done))
       c->initial_thread->schedule_imm_signal(c, AIO_EVENT_DONE);
     else {
       sync.push(c); // put it back on the front
       break;
     }
   }
-  if (dir_sync_waiting) {
+  if (dir_sync_waiting && !agg_writing.head) {
     dir_sync_waiting = 0;
     cacheDirSync->handleEvent(EVENT_IMMEDIATE, 0);
   }
-  if (agg.head || sync.head)
+  // unless an evacuation read is in progress, it calls aggWrite when done
+  if ((agg.head || sync.head) && !is_io_in_progress())
     return aggWrite(event, e);
   return EVENT_CONT;
 }
@@ -842,18 +856,19 @@ agg_copy(char *p, CacheVC *vc)
     // for evacuated documents, copy the data, and update directory
     Doc *doc = (Doc *)vc->buf->data();
     int l = vc->vol->round_to_approx_size(doc->len);
-    {
+    if (!vc->f.tier_promoter) {
       ProxyMutex *mutex ATS_UNUSED = vc->vol->mutex;
       ink_assert(mutex->thread_holding == this_ethread());
       CACHE_DEBUG_INCREMENT_DYN_STAT(cache_gc_frags_evacuated_stat);
       CACHE_DEBUG_SUM_DYN_STAT(cache_gc_bytes_evacuated_stat, l);
     }
 
+    // the buffer of a promoted fragment is shared with its readers, only the copy is updated
+    memcpy(p, doc, doc->len);
+    doc = (Doc *)p;
     doc->sync_serial = vc->vol->header->sync_serial;
     doc->write_serial = vc->vol->header->write_serial;
 
-    memcpy(p, doc, doc->len);
-
     vc->dir = vc->overwrite_dir;
     dir_set_offset(&vc->dir, offset_to_vol_offset(vc->vol, o));
     dir_set_phase(&vc->dir, vc->vol->header->phase);
@@ -932,6 +947,76 @@ Vol::agg_wrap()
   periodic_scan();
 }
 
+void
+Vol::agg_init()
+{
+  int64_t size = cache_config_agg_buffer_size;
+
+  agg_nbuffers = cache_config_agg_buffers;
+  for (ConfigVol *config_vol = config_volumes.cp_queue.head; cache_vol && config_vol; config_vol = config_vol->link.next) {
+    if (config_vol->number == cache_vol->vol_number) {
+      if (config_vol->agg_buffer_size)
+        size = (int64_t)config_vol->agg_buffer_size << 20;
+      if (config_vol->agg_buffers)
+        agg_nbuffers = config_vol->agg_buffers;
+    }
+  }
+  agg_size = ROUND_TO_STORE_BLOCK(MIN(MAX(size, (int64_t)AGG_SIZE), (int64_t)AGG_MAX_SIZE));
+  agg_alloc(agg_nbuffers);
+}
+
+void
+Vol::agg_alloc(int nbuffers)
+{
+  agg_nbuffers = MIN(MAX(nbuffers, 1), AGG_MAX_BUFFERS);
+  agg_buffers = new AggBuffer[agg_nbuffers];
+  for (int i = 0; i < agg_nbuffers; i++) {
+    AggBuffer *b = &agg_buffers[i];
+    b->vol = this;
+    b->mutex = mutex;
+    b->buf = (char *)ats_memalign(ats_pagesize(), agg_size);
+    memset(b->buf, 0, agg_size);
+    ink_aio_register_buffer(b->buf, agg_size);
+    agg_free.enqueue(b);
+  }
+  agg_fill = agg_free.dequeue();
+  agg_buffer = agg_fill->buf;
+}
+
+// Replaces the aggregation buffers by @a nbuffers of them, used by the regression tests.
+// Fails unless the stripe has nothing to write and nothing being written.
+bool
+Vol::agg_resize(int nbuffers)
+{
+  ink_assert(mutex->thread_holding == this_ethread());
+  if (is_io_in_progress() || agg_buf_pos || agg_writing.head || agg.head || sync.head)
+    return false;
+  while (agg_free.dequeue())
+    ;
+  for (int i = 0; i < agg_nbuffers; i++) {
+    ink_aio_unregister_buffer(agg_buffers[i].buf);
+    ats_memalign_free(agg_buffers[i].buf);
+  }
+  delete[] agg_buffers;
+  agg_alloc(nbuffers);
+  return true;
+}
+
+// The fragment of the entry in an aggregation buffer, NULL if it is on disk only.
+char *
+Vol::agg_data(Dir *e)
+{
+  off_t o = vol_offset(this, e);
+
+  if (dir_agg_buf_valid(this, e))
+    return agg_buffer + (o - header->write_pos);
+  for (AggBuffer *b = agg_writing.head; b; b = b->link.next) {
+    if (dir_phase(e) == b->phase && o >= b->io.aiocb.aio_offset && o < (off_t)(b->io.aiocb.aio_offset + b->io.aiocb.aio_nbytes))
+      return b->buf + (o - b->io.aiocb.aio_offset);
+  }
+  return NULL;
+}
+
 /* NOTE: This state can be called by an AIO thread, so DON'T DON'T
    DON'T schedule any events on this thread using VC_SCHED_XXX or
    mutex->thread_holding->schedule_xxx_local(). ALWAYS use
@@ -942,7 +1027,12 @@ Vol::agg_wrap()
 int
 Vol::aggWrite(int event, void * /* e ATS_UNUSED */)
 {
-  ink_assert(!is_io_in_progress());
+  // called again when the evacuation read or a write is done
+  if (is_io_in_progress())
+    return EVENT_CONT;
+  // a directory sync waits for the writes in progress, do not add to them
+  if (dir_sync_waiting && agg_writing.head)
+    return EVENT_CONT;
 
   Que(CacheVC, link) tocall;
   CacheVC *c;
@@ -955,7 +1045,7 @@ Lagain:
     int writelen = c->agg_len;
     // [amc] this is checked multiple places, on here was it strictly less.
     ink_assert(writelen <= AGG_SIZE);
-    if (agg_buf_pos + writelen > AGG_SIZE || header->write_pos + agg_buf_pos + writelen > (skip + len))
+    if (agg_buf_pos + writelen > agg_size || header->write_pos + agg_buf_pos + writelen > (skip + len))
       break;
     DDebug("agg_read", "copying: %d, %" PRIu64 ", key: %d", agg_buf_pos, header->write_pos + agg_buf_pos, c->first_key.slice32(0));
     int wrotelen = agg_copy(agg_buffer + agg_buf_pos, c);
@@ -1011,7 +1101,7 @@ Lagain:
 
   // if agg.head, then we are near the end of the disk, so
   // write down the aggregation in whatever size it is.
-  if (agg_buf_pos < AGG_HIGH_WATER && !agg.head && !sync.head && !dir_sync_waiting)
+  if (agg_buf_pos < AGG_HIGH_WATER(this) && !agg.head && !sync.head && !dir_sync_waiting)
     goto Lwait;
 
   // write sync marker
@@ -1030,19 +1120,34 @@ Lagain:
   // set write limit
   header->agg_pos = header->write_pos + agg_buf_pos;
 
-  io.aiocb.aio_fildes = fd;
-  io.aiocb.aio_offset = header->write_pos;
-  io.aiocb.aio_buf = agg_buffer;
-  io.aiocb.aio_nbytes = agg_buf_pos;
-  io.action = this;
-  /*
-    Callback on AIO thread so that we can issue a new write ASAP
-    as all writes are serialized in the volume.  This is not necessary
-    for reads proceed independently.
-   */
-  io.thread = AIO_CALLBACK_THREAD_AIO;
-  SET_HANDLER(&Vol::aggWriteDone);
-  ink_aio_write(&io);
+  {
+    AggBuffer *b = agg_fill;
+    b->io.aiocb.aio_fildes = fd;
+    b->io.aiocb.aio_offset = header->write_pos;
+    b->io.aiocb.aio_buf = agg_buffer;
+    b->io.aiocb.aio_nbytes = agg_buf_pos;
+    b->io.action = b;
+    /*
+      Callback on AIO thread so that we can issue a new write ASAP
+      as all writes are serialized in the volume.  This is not necessary
+      for reads proceed independently.
+     */
+    b->io.thread = AIO_CALLBACK_THREAD_AIO;
+    b->phase = header->phase;
+    b->write_serial = header->write_serial;
+    agg_writing.enqueue(b);
+
+    // the next buffer is filled while this one is written
+    header->write_pos += agg_buf_pos;
+    ink_assert(header->write_pos == header->agg_pos);
+    header->write_serial++;
+    agg_buf_pos = 0;
+    agg_fill = agg_free.dequeue();
+    agg_buffer = agg_fill ? agg_fill->buf : NULL;
+    if (header->write_pos + EVACUATION_SIZE > scan_pos)
+      periodic_scan();
+    ink_aio_write(&b->io);
+  }
 
 Lwait:
   int ret = EVENT_CONT;
@@ -1622,6 +1727,7 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheFragType frag_ty
   }
   if (res < 0) {
     SET_CONTINUATION_HANDLER(c, &CacheVC::openWriteStartBegin);
+    CACHE_LOCK_MISS_STAT(c->mutex->thread_holding, c->vol);
     c->trigger = CONT_SCHED_LOCK_RETRY(c);
     return &c->_action;
   }
@@ -1747,6 +1853,7 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheHTTPInfo *info,
     }
     // missed lock
     SET_CONTINUATION_HANDLER(c, &CacheVC::openWriteStartDone);
+    CACHE_LOCK_MISS_STAT(c->mutex->thread_holding, c->vol);
     CONT_SCHED_LOCK_RETRY(c);
     return &c->_action;
   }
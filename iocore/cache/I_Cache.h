@@ -43,11 +43,14 @@
 
 #define RAM_CACHE_ALGORITHM_CLFUS 0
 #define RAM_CACHE_ALGORITHM_LRU 1
+#define RAM_CACHE_ALGORITHM_TINYLFU 2
 
 #define CACHE_COMPRESSION_NONE 0
 #define CACHE_COMPRESSION_FASTLZ 1
 #define CACHE_COMPRESSION_LIBZ 2
 #define CACHE_COMPRESSION_LIBLZMA 3
+#define CACHE_COMPRESSION_ZSTD 4
+#define CACHE_COMPRESSION_LZ4 5
 
 struct CacheVC;
 struct CacheDisk;
@@ -98,6 +101,13 @@ struct CacheProcessor : public Processor {
   Action *remove(Continuation *cont, const HttpCacheKey *key, bool cluster_cache_local,
                  CacheFragType frag_type = CACHE_FRAG_TYPE_HTTP);
 #endif
+  /// Count a lookup of @a key for the admission of the objects missed, once per transaction.
+  void admission_record(const CacheKey *key);
+  /** Whether an object of @a size bytes (-1 if not known) missed under @a key
+      is worth writing to the cache.
+  */
+  bool admit(const CacheKey *key, int64_t size);
+
   Action *link(Continuation *cont, CacheKey *from, CacheKey *to, bool cluster_cache_local,
                CacheFragType frag_type = CACHE_FRAG_TYPE_HTTP, char *hostname = 0, int host_len = 0);
 
@@ -203,6 +213,18 @@ struct CacheVConnection : public VConnection {
   */
   virtual bool is_pread_capable() = 0;
 
+  /** Let the read append blocks referring to ranges of the cache disk
+      (IOBufferFileData) instead of copies of the data, for the fragments
+      which are not in memory. The buffer must be written to a
+      NetVConnection which is sendfile capable. Call before @c do_io_read.
+      @return @c true if the VC may append such blocks.
+  */
+  virtual bool
+  enable_sendfile()
+  {
+    return false;
+  }
+
   CacheVConnection();
 };
 
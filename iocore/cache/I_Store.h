@@ -68,6 +68,7 @@ struct Span {
   unsigned alignment;
   span_diskid_t disk_id;
   int forced_volume_num; ///< Force span in to specific volume.
+  bool fast_tier;        ///< Span is in the fast storage tier.
 private:
   bool is_mmapable_internal;
 
@@ -145,10 +146,12 @@ public:
   void hash_base_string_set(char const *s);
   /// Set the volume number.
   void volume_number_set(int n);
+  /// Put the span in the fast storage tier.
+  void fast_tier_set(bool fast);
 
   Span()
     : blocks(0), offset(0), hw_sector_size(DEFAULT_HW_SECTOR_SIZE), alignment(0), forced_volume_num(-1),
-      is_mmapable_internal(false), file_pathname(false)
+      fast_tier(false), is_mmapable_internal(false), file_pathname(false)
   {
     disk_id[0] = disk_id[1] = 0;
   }
@@ -253,6 +256,7 @@ struct Store {
   /// Additional configuration key values.
   static char const VOLUME_KEY[];
   static char const HASH_BASE_STRING_KEY[];
+  static char const TIER_KEY[];
 };
 
 // store either free or in the cache, can be stolen for reconfiguration
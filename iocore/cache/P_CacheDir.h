@@ -39,6 +39,7 @@ struct CacheVC;
 
 #define DIR_TAG_WIDTH 12
 #define DIR_MASK_TAG(_t) ((_t) & ((1 << DIR_TAG_WIDTH) - 1))
+#define DIR_TAG_INDEX_SLOTS 8 // tags of a bucket in the tag index, one 16 byte vector
 #define SIZEOF_DIR 10
 #define ESTIMATED_OBJECT_SIZE 8000
 
@@ -56,6 +57,10 @@ struct CacheVC;
 
 #define SYNC_MAX_WRITE (2 * 1024 * 1024)
 #define SYNC_DELAY HRTIME_MSECONDS(500)
+#define DIR_READ_SIZE (8 * 1024 * 1024)
+// Vol::dir_dirty, the copies of the directory on disk a segment has to be written to
+#define DIR_DIRTY_A 1
+#define DIR_DIRTY_B 2
 #define DO_NOT_REMOVE_THIS 0
 
 // Debugging Options
@@ -255,6 +260,7 @@ struct OpenDir : public Continuation {
   int open_write(CacheVC *c, int allow_if_writers, int max_writers);
   int close_write(CacheVC *c);
   OpenDirEntry *open_read(const CryptoHash *key);
+  bool may_be_open(const CryptoHash *key);
   int signal_readers(int event, Event *e);
 
   OpenDir();
@@ -266,6 +272,10 @@ struct CacheSync : public Continuation {
   size_t buflen;
   bool buf_huge;
   off_t writepos;
+  uint8_t *segs; // segments written by the sync in progress
+  int segslen;
+  int seg;
+  bool failed;
   AIOCallbackInternal io;
   Event *trigger;
   ink_hrtime start_time;
@@ -273,7 +283,8 @@ struct CacheSync : public Continuation {
   void aio_write(int fd, char *b, int n, off_t o);
 
   CacheSync()
-    : Continuation(new_ProxyMutex()), vol_idx(0), buf(0), buflen(0), buf_huge(false), writepos(0), trigger(0), start_time(0)
+    : Continuation(new_ProxyMutex()), vol_idx(0), buf(0), buflen(0), buf_huge(false), writepos(0), segs(0), segslen(0), seg(0),
+      failed(false), trigger(0), start_time(0)
   {
     SET_HANDLER(&CacheSync::mainEvent);
   }
@@ -282,6 +293,10 @@ struct CacheSync : public Continuation {
 // Global Functions
 
 void vol_init_dir(Vol *d);
+void dir_tag_index_init(Vol *d);
+void dir_tag_index_clear(Vol *d);
+void dir_lock_init(Vol *d);
+int dir_group_probe(const CacheKey *key, Vol *d);
 int dir_token_probe(const CacheKey *, Vol *, Dir *);
 int dir_probe(const CacheKey *, Vol *, Dir *, Dir **);
 int dir_insert(const CacheKey *key, Vol *d, Dir *to_part);
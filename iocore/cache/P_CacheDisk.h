@@ -90,6 +90,7 @@ struct CacheDisk : public Continuation {
   off_t num_usable_blocks;
   int hw_sector_size;
   int fd;
+  int sendfile_fd; // buffered descriptor for sending fragments with sendfile(), or -1
   off_t free_space;
   off_t wasted_space;
   DiskVol **disk_vols;
@@ -100,12 +101,13 @@ struct CacheDisk : public Continuation {
 
   // Extra configuration values
   int forced_volume_num;           ///< Volume number for this disk.
+  bool fast_tier;                  ///< Disk is in the fast storage tier.
   ats_scoped_str hash_base_string; ///< Base string for hash seed.
 
   CacheDisk()
     : Continuation(new_ProxyMutex()), header(NULL), path(NULL), header_len(0), len(0), start(0), skip(0), num_usable_blocks(0),
-      fd(-1), free_space(0), wasted_space(0), disk_vols(NULL), free_blocks(NULL), num_errors(0), cleared(0), read_only_p(false),
-      forced_volume_num(-1)
+      fd(-1), sendfile_fd(-1), free_space(0), wasted_space(0), disk_vols(NULL), free_blocks(NULL), num_errors(0), cleared(0),
+      read_only_p(false), forced_volume_num(-1), fast_tier(false)
   {
   }
 
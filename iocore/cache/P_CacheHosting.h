@@ -177,6 +177,8 @@ struct ConfigVol {
   off_t size;
   bool in_percent;
   int percent;
+  int agg_buffer_size; // MB, 0 for proxy.config.cache.agg_buffer_size
+  int agg_buffers;     // 0 for proxy.config.cache.agg_buffers
   CacheVol *cachep;
   LINK(ConfigVol, link);
 };
@@ -72,14 +72,24 @@ struct EvacuationBlock;
 #endif
 
 
+// an operation rescheduled because a lock was busy
+#define CACHE_LOCK_MISS_STAT(_t, _v)                                                \
+  do {                                                                              \
+    RecIncrRawStat(cache_rsb, (_t), (int)cache_lock_miss_stat, 1);                  \
+    if (_v)                                                                         \
+      RecIncrRawStat((_v)->cache_vol->vol_rsb, (_t), (int)cache_lock_miss_stat, 1); \
+  } while (0)
+
 #define VC_LOCK_RETRY_EVENT()                                                                                         \
   do {                                                                                                                \
+    CACHE_LOCK_MISS_STAT(mutex->thread_holding, vol);                                                                 \
     trigger = mutex->thread_holding->schedule_in_local(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay), event); \
     return EVENT_CONT;                                                                                                \
   } while (0)
 
 #define VC_SCHED_LOCK_RETRY()                                                                                  \
   do {                                                                                                         \
+    CACHE_LOCK_MISS_STAT(mutex->thread_holding, vol);                                                          \
     trigger = mutex->thread_holding->schedule_in_local(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay)); \
     return EVENT_CONT;                                                                                         \
   } while (0)
@@ -158,6 +168,29 @@ enum {
   cache_directory_sync_count_stat,
   cache_directory_sync_time_stat,
   cache_directory_sync_bytes_stat,
+  cache_directory_sync_segments_stat,
+  cache_directory_sync_segments_skipped_stat,
+  cache_tier_fast_hits_stat,
+  cache_tier_fast_bytes_stat,
+  cache_tier_slow_hits_stat,
+  cache_tier_slow_bytes_stat,
+  cache_tier_promotions_stat,
+  cache_tier_promoted_bytes_stat,
+  cache_tier_fallbacks_stat,
+  cache_lock_miss_stat,
+  cache_dir_group_miss_stat,
+  cache_ram_cache_compress_in_bytes_stat,
+  cache_ram_cache_compress_out_bytes_stat,
+  cache_ram_cache_compress_time_stat,
+  cache_ram_cache_decompress_time_stat,
+  cache_read_ahead_issued_stat,
+  cache_read_ahead_used_stat,
+  cache_read_ahead_wasted_stat,
+  cache_read_ahead_wasted_bytes_stat,
+  cache_admission_admitted_stat,
+  cache_admission_admitted_bytes_stat,
+  cache_admission_rejected_stat,
+  cache_admission_rejected_bytes_stat,
   cache_stat_count
 };
 
@@ -202,12 +235,17 @@ extern RecRawStatBlock *cache_rsb;
 
 // Configuration
 extern int cache_config_dir_sync_frequency;
+extern int cache_config_dir_tag_index;
+extern int cache_config_dir_lock_groups;
+extern int cache_config_init_dir_reads;
 extern int cache_config_http_max_alts;
 extern int cache_config_permit_pinning;
 extern int cache_config_select_alternate;
 extern int cache_config_max_doc_size;
 extern int cache_config_min_average_object_size;
 extern int cache_config_agg_write_backlog;
+extern int cache_config_agg_buffer_size;
+extern int cache_config_agg_buffers;
 extern int cache_config_enable_checksum;
 extern int cache_config_alt_rewrite_max_size;
 extern int cache_config_read_while_writer;
@@ -222,6 +260,44 @@ extern int cache_config_force_sector_size;
 extern int cache_config_target_fragment_size;
 extern int cache_config_mutex_retry_delay;
 extern int cache_config_read_while_writer_max_retries;
+extern int64_t cache_config_sendfile_min_size;
+extern int cache_config_tier_promote_hits;
+extern int64_t cache_config_tier_promote_max_size;
+extern int cache_config_read_ahead_fragments;
+extern int cache_config_admission_min_hits;
+extern int64_t cache_config_admission_small_size;
+
+void cache_admission_init();
+
+// A part of a fragment handed out as a range of the disk instead of being
+// read, see CacheVC::enable_sendfile().
+struct CacheSendfileData : public IOBufferFileData {
+  CacheSendfileData(Vol *v, Dir *e, int64_t pos, int64_t size);
+  bool is_valid();
+
+  Vol *vol;
+  off_t fragment_offset;    // offset of the fragment on the disk
+  uint32_t overwrite_cycle; // write cycle of the volume which overwrites the fragment
+};
+
+struct CacheVC;
+
+// A fragment read from the disk ahead of a sequential reader, see CacheVC::read_ahead().
+struct CacheReadAhead : public Continuation {
+  CacheVC *vc; // NULL once the reader has dropped it
+  Vol *vol;
+  CacheKey key;
+  Dir dir;
+  Ptr<IOBufferData> buf;
+  AIOCallbackInternal io;
+  bool done;    // the read is complete
+  bool waiting; // the reader waits for the read to complete
+  LINK(CacheReadAhead, link);
+
+  int readDone(int event, Event *e);
+};
+
+extern ClassAllocator<CacheReadAhead> cacheReadAheadAllocator;
 
 // CacheVC
 struct CacheVC : public CacheVConnection {
@@ -347,6 +423,14 @@ struct CacheVC : public CacheVConnection {
   }
   int evacuateDocDone(int event, Event *e);
   int evacuateReadHead(int event, Event *e);
+  void tier_promote(const CacheKey *akey, Dir *adir, IOBufferData *data);
+  void tier_promote_head();
+  int tier_read_fallback(bool drop_copy);
+  int tierPromoteDone(int event, Event *e);
+  void read_ahead(Doc *doc);
+  CacheReadAhead *read_ahead_match();
+  void read_ahead_use(CacheReadAhead *r);
+  void read_ahead_drop(CacheReadAhead *r);
 
   void cancel_trigger();
   virtual int64_t get_object_size();
@@ -364,6 +448,7 @@ struct CacheVC : public CacheVConnection {
   virtual uint32_t load_http_info(CacheHTTPInfoVector *info, struct Doc *doc, RefCountObj *block_ptr = NULL);
 #endif
   virtual bool is_pread_capable();
+  virtual bool enable_sendfile();
   virtual bool set_pin_in_cache(time_t time_pin);
   virtual time_t get_pin_in_cache();
   virtual bool set_disk_io_priority(int priority);
@@ -433,6 +518,7 @@ struct CacheVC : public CacheVConnection {
   uint32_t agg_len;      // for communicating with aggWrite
   uint32_t write_serial; // serial of the final write for SYNC
   Vol *vol;
+  Vol *tier_vol; // the stripe of the document while its copy is read from the fast tier
   Dir *last_collision;
   Event *trigger;
   CacheKey *read_key;
@@ -481,6 +567,10 @@ struct CacheVC : public CacheVConnection {
       unsigned int readers : 1;
       unsigned int doc_from_ram_cache : 1;
       unsigned int hit_evacuate : 1;
+      unsigned int sendfile : 1;        // data fragments may be handed out as ranges of the disk
+      unsigned int doc_header_only : 1; // only the Doc header of the fragment was read into 'buf'
+      unsigned int tier_promote : 1;    // copy the fragments read into the fast tier
+      unsigned int tier_promoter : 1;   // copy of a fragment on its way to the fast tier
 #ifdef HTTP_CACHE
       unsigned int allow_empty_doc : 1; // used for cache empty http document
 #endif
@@ -489,6 +579,7 @@ struct CacheVC : public CacheVConnection {
   // BTF optimization used to skip reading stuff in cache partition that doesn't contain any
   // dir entries.
   char *scan_vol_map;
+  Que(CacheReadAhead, link) read_ahead_frags; // fragments read ahead, in the order of the keys
   // BTF fix to handle objects that overlapped over two different reads,
   // this is how much we need to back up the buffer to get the start of the overlapping object.
   off_t scan_fix_buffer_offset;
@@ -598,6 +689,8 @@ free_CacheVC(CacheVC *cont)
   cont->alternate_index = CACHE_ALT_INDEX_DEFAULT;
   if (cont->scan_vol_map)
     ats_free(cont->scan_vol_map);
+  while (cont->read_ahead_frags.head)
+    cont->read_ahead_drop(cont->read_ahead_frags.head);
   memset((char *)&cont->vio, 0, cont->size_to_init);
 #ifdef CACHE_STAT_PAGES
   ink_assert(!cont->stat_link.next && !cont->stat_link.prev);
@@ -984,6 +1077,7 @@ struct Cache {
   int open_done();
 
   Vol *key_to_vol(const CacheKey *key, char const *hostname, int host_len);
+  void tier_init();
 
   Cache()
     : cache_read_done(0), total_good_nvol(0), total_nvol(0), ready(CACHE_INITIALIZING), cache_size(0), // in store block size
@@ -36,8 +36,10 @@
 #define VOL_MAGIC 0xF1D0F00D
 #define START_BLOCKS 16 // 8k, STORE_BLOCK_SIZE
 #define START_POS ((off_t)START_BLOCKS * CACHE_BLOCK_SIZE)
-#define AGG_SIZE (4 * 1024 * 1024)     // 4MB
-#define AGG_HIGH_WATER (AGG_SIZE / 2)  // 2MB
+#define AGG_SIZE (4 * 1024 * 1024)     // 4MB, the smallest aggregation buffer
+#define AGG_MAX_SIZE (64 * 1024 * 1024) // 64MB
+#define AGG_MAX_BUFFERS 16
+#define AGG_HIGH_WATER(_v) ((_v)->agg_size / 2)
 #define EVACUATION_SIZE (2 * AGG_SIZE) // 8MB
 #define MAX_VOL_SIZE ((off_t)512 * 1024 * 1024 * 1024 * 1024)
 #define STORE_BLOCKS_PER_CACHE_BLOCK (STORE_BLOCK_SIZE / CACHE_BLOCK_SIZE)
@@ -123,6 +125,25 @@ struct EvacuationBlock {
   LINK(EvacuationBlock, link);
 };
 
+// An aggregation buffer. While one is written the next one is filled, the fragments are read from
+// the buffer until the write is done.
+struct AggBuffer : public Continuation {
+  Vol *vol;
+  char *buf;
+  AIOCallbackInternal io;
+  uint32_t phase;
+  uint32_t write_serial;
+  bool done; // written, waiting for the writes of the buffers before it
+  LINK(AggBuffer, link);
+
+  int writeDone(int event, Event *e);
+
+  AggBuffer() : Continuation(NULL), vol(NULL), buf(NULL), phase(0), write_serial(0), done(false)
+  {
+    SET_HANDLER(&AggBuffer::writeDone);
+  }
+};
+
 
 struct Vol : public Continuation {
   char *path;
@@ -132,6 +153,11 @@ struct Vol : public Continuation {
 
   char *raw_dir;
   Dir *dir;
+  uint16_t *tag_index; // tags of the entries of each bucket, to skip the buckets without the tag probed
+  Ptr<ProxyMutex> *dir_mutex; // locks of the segment groups of the directory, taken under the stripe lock
+  int dir_mutexes;
+  uint8_t *dir_dirty; // DIR_DIRTY_A/B of each segment, the copies of the directory which do not have its changes yet
+  ink_hrtime init_time;
   VolHeaderFooter *header;
   VolHeaderFooter *footer;
   int segments;
@@ -149,9 +175,16 @@ struct Vol : public Continuation {
   Queue<CacheVC, Continuation::Link_link> agg;
   Queue<CacheVC, Continuation::Link_link> stat_cache_vcs;
   Queue<CacheVC, Continuation::Link_link> sync;
-  char *agg_buffer;
+  char *agg_buffer; // being filled, NULL while all the buffers are written
   int agg_todo_size;
   int agg_buf_pos;
+  int agg_size; // of each buffer
+  int agg_nbuffers;
+  AggBuffer *agg_buffers;
+  AggBuffer *agg_fill;
+  Queue<AggBuffer> agg_free;
+  Queue<AggBuffer> agg_writing; // oldest first
+  uint32_t write_serial_done;   // header->write_serial once the writes in progress are done
 
   Event *trigger;
 
@@ -179,6 +212,10 @@ struct Vol : public Continuation {
   int64_t first_fragment_offset;
   Ptr<IOBufferData> first_fragment_data;
 
+  Vol *fast_vol;      // stripe of the fast tier holding copies of the hot documents of this one
+  uint8_t *tier_hits; // hits on the documents of this stripe, by key, to pick the ones to promote
+  int tier_hits_count;
+
 
   void cancel_trigger();
 
@@ -198,11 +235,14 @@ struct Vol : public Continuation {
   int close_read_lock(CacheVC *cont);
 
   int clear_dir();
+  void read_dir(off_t pos);
+  bool read_dir_part(AIOCallback *op);
 
   int init(char *s, off_t blocks, off_t dir_skip, bool clear);
 
   int handle_dir_clear(int event, void *data);
   int handle_dir_read(int event, void *data);
+  int handle_dir_read_part(int event, void *data);
   int handle_recover_from_data(int event, void *data);
   int handle_recover_write_dir(int event, void *data);
   int handle_header_read(int event, void *data);
@@ -213,10 +253,11 @@ struct Vol : public Continuation {
   int dir_check(bool fix);
   int db_check(bool fix);
 
+  // An evacuation read is in progress or all the aggregation buffers are being written.
   int
   is_io_in_progress()
   {
-    return io.aiocb.aio_fildes != AIO_NOT_IN_PROGRESS;
+    return io.aiocb.aio_fildes != AIO_NOT_IN_PROGRESS || !agg_buffer;
   }
   int
   increment_generation()
@@ -234,7 +275,11 @@ struct Vol : public Continuation {
     io.aiocb.aio_fildes = AIO_NOT_IN_PROGRESS;
   }
 
-  int aggWriteDone(int event, Event *e);
+  void agg_init();
+  void agg_alloc(int nbuffers);
+  bool agg_resize(int nbuffers);
+  char *agg_data(Dir *e);
+  int aggWriteDone(AggBuffer *b, int event, Event *e);
   int aggWrite(int event, void *e);
   void agg_wrap();
 
@@ -251,19 +296,35 @@ struct Vol : public Continuation {
   int within_hit_evacuate_window(Dir *dir);
   uint32_t round_to_approx_size(uint32_t l);
 
+  Vol *read_tier(const CacheKey *key, EThread *t);
+  bool tier_promote_due(const CacheKey *key);
+  void tier_evict(const CacheKey *key);
+
   Vol()
-    : Continuation(new_ProxyMutex()), path(NULL), fd(-1), dir(0), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0),
-      skip(0), start(0), len(0), data_blocks(0), hit_evacuate_window(0), agg_todo_size(0), agg_buf_pos(0), trigger(0),
-      evacuate_size(0), disk(NULL), last_sync_serial(0), last_write_serial(0), recover_wrapped(false), dir_sync_waiting(0),
-      dir_sync_in_progress(0), writing_end_marker(0)
+    : Continuation(new_ProxyMutex()), path(NULL), fd(-1), dir(0), tag_index(NULL), dir_mutex(NULL), dir_mutexes(0),
+      dir_dirty(NULL), init_time(0), buckets(0), recover_pos(0), prev_recover_pos(0), scan_pos(0), skip(0), start(0), len(0),
+      data_blocks(0), hit_evacuate_window(0), agg_buffer(NULL), agg_todo_size(0), agg_buf_pos(0), agg_size(AGG_SIZE),
+      agg_nbuffers(0), agg_buffers(NULL), agg_fill(NULL), write_serial_done(0), trigger(0), evacuate_size(0), disk(NULL),
+      last_sync_serial(0), last_write_serial(0), recover_wrapped(false), dir_sync_waiting(0), dir_sync_in_progress(0),
+      writing_end_marker(0), fast_vol(NULL), tier_hits(NULL), tier_hits_count(0)
   {
     open_dir.mutex = mutex;
-    agg_buffer = (char *)ats_memalign(ats_pagesize(), AGG_SIZE);
-    memset(agg_buffer, 0, AGG_SIZE);
     SET_HANDLER(&Vol::aggWrite);
   }
 
-  ~Vol() { ats_memalign_free(agg_buffer); }
+  ~Vol()
+  {
+    for (int i = 0; i < agg_nbuffers; i++) {
+      ink_aio_unregister_buffer(agg_buffers[i].buf);
+      ats_memalign_free(agg_buffers[i].buf);
+    }
+    delete[] agg_buffers;
+    ats_free(tier_hits);
+    if (tag_index)
+      ats_memalign_free(tag_index);
+    delete[] dir_mutex;
+    ats_free(dir_dirty);
+  }
 };
 
 struct AIO_Callback_handler : public Continuation {
@@ -279,11 +340,12 @@ struct CacheVol {
   int num_vols;
   Vol **vols;
   DiskVol **disk_vols;
+  bool fast_tier; // only holds copies of the documents of the other volumes
   LINK(CacheVol, link);
   // per volume stats
   RecRawStatBlock *vol_rsb;
 
-  CacheVol() : vol_number(-1), scheme(0), size(0), num_vols(0), vols(NULL), disk_vols(0), vol_rsb(0) {}
+  CacheVol() : vol_number(-1), scheme(0), size(0), num_vols(0), vols(NULL), disk_vols(0), fast_tier(false), vol_rsb(0) {}
 };
 
 // Note : hdr() needs to be 8 byte aligned.
@@ -351,7 +413,7 @@ vol_out_of_phase_valid(Vol *d, Dir *e)
 TS_INLINE int
 vol_out_of_phase_agg_valid(Vol *d, Dir *e)
 {
-  return (dir_offset(e) - 1 >= ((d->header->agg_pos - d->start + AGG_SIZE) / CACHE_BLOCK_SIZE));
+  return (dir_offset(e) - 1 >= ((d->header->agg_pos - d->start + d->agg_size) / CACHE_BLOCK_SIZE));
 }
 
 TS_INLINE int
@@ -489,7 +551,7 @@ TS_INLINE int
 Vol::within_hit_evacuate_window(Dir *xdir)
 {
   off_t oft = dir_offset(xdir) - 1;
-  off_t write_off = (header->write_pos + AGG_SIZE - start) / CACHE_BLOCK_SIZE;
+  off_t write_off = (header->write_pos + agg_size - start) / CACHE_BLOCK_SIZE;
   off_t delta = oft - write_off;
   if (delta >= 0)
     return delta < hit_evacuate_window;
@@ -32,12 +32,21 @@
 #if TS_HAS_LZMA
 #include <lzma.h>
 #endif
+#if TS_HAS_ZSTD
+#include <zstd.h>
+#endif
+#if TS_HAS_LZ4
+#include <lz4.h>
+#endif
 
 #define REQUIRED_COMPRESSION 0.9 // must get to this size or declared incompressible
 #define REQUIRED_SHRINK 0.8      // must get to this size or keep orignal buffer (with padding)
 #define HISTORY_HYSTERIA 10      // extra temporary history
 #define ENTRY_OVERHEAD 256       // per-entry overhead to consider when computing cache value/size
 #define LZMA_BASE_MEMLIMIT (64 * 1024 * 1024)
+#define ZSTD_LEVEL 1                    // fast, the compression is of the whole RAM cache
+#define COMPRESS_BATCH 64               // entries compressed before giving the task thread back
+#define COMPRESS_YIELD HRTIME_MSECONDS(1) // before the next batch
 //#define CHECK_ACOUNTING 1 // very expensive double checking of all sizes
 
 #define REQUEUE_HITS(_h) ((_h) ? 1 : 0)
@@ -88,7 +97,7 @@ struct RamCacheCLFUS : public RamCache {
   uint16_t *seen;
   int ncompressed;
   RamCacheCLFUSEntry *compressed; // first uncompressed lru[0] entry
-  void compress_entries(EThread *thread, int do_at_most = INT_MAX);
+  bool compress_entries(EThread *thread, int do_at_most = INT_MAX);
   void resize_hashtable();
   void victimize(RamCacheCLFUSEntry *e);
   void move_compressed(RamCacheCLFUSEntry *e);
@@ -128,11 +137,24 @@ RamCacheCLFUSCompressor::mainEvent(int /* event ATS_UNUSED */, Event *e)
   case CACHE_COMPRESSION_LIBLZMA:
 #if !TS_HAS_LZMA
     Warning("lzma not available for RAM cache compression");
+#endif
+    break;
+  case CACHE_COMPRESSION_ZSTD:
+#if !TS_HAS_ZSTD
+    Warning("zstd not available for RAM cache compression");
+#endif
+    break;
+  case CACHE_COMPRESSION_LZ4:
+#if !TS_HAS_LZ4
+    Warning("lz4 not available for RAM cache compression");
 #endif
     break;
   }
-  if (cache_config_ram_cache_compress_percent)
-    rc->compress_entries(e->ethread);
+  // in batches, so that the RAM caches of all the volumes share the task threads
+  if (cache_config_ram_cache_compress_percent && rc->compress_entries(e->ethread, COMPRESS_BATCH))
+    e->schedule_in(COMPRESS_YIELD);
+  else
+    e->schedule_in(HRTIME_SECOND);
   return EVENT_CONT;
 }
 
@@ -178,7 +200,7 @@ RamCacheCLFUS::init(int64_t abytes, Vol *avol)
   if (!max_bytes)
     return;
   resize_hashtable();
-  eventProcessor.schedule_every(new RamCacheCLFUSCompressor(this), HRTIME_SECOND, ET_TASK);
+  eventProcessor.schedule_in(new RamCacheCLFUSCompressor(this), HRTIME_SECOND, ET_TASK);
 }
 
 #ifdef CHECK_ACOUNTING
@@ -221,6 +243,7 @@ RamCacheCLFUS::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1,
       if (!e->flag_bits.lru) { // in memory
         e->hits++;
         if (e->flag_bits.compressed) {
+          ink_hrtime start = ink_get_hrtime_internal();
           b = (char *)ats_malloc(e->len);
           switch (e->flag_bits.compressed) {
           default:
@@ -248,8 +271,21 @@ RamCacheCLFUS::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1,
               goto Lfailed;
             break;
           }
+#endif
+#if TS_HAS_ZSTD
+          case CACHE_COMPRESSION_ZSTD:
+            if (ZSTD_decompress(b, e->len, e->data->data(), e->compressed_len) != e->len)
+              goto Lfailed;
+            break;
+#endif
+#if TS_HAS_LZ4
+          case CACHE_COMPRESSION_LZ4:
+            if (LZ4_decompress_safe(e->data->data(), b, e->compressed_len, e->len) != (int)e->len)
+              goto Lfailed;
+            break;
 #endif
           }
+          CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_decompress_time_stat, ink_hrtime_to_usec(ink_get_hrtime_internal() - start));
           IOBufferData *data = new_xmalloc_IOBufferData(b, e->len);
           data->_mem_type = DEFAULT_ALLOC;
           if (!e->flag_bits.copy) { // don't bother if we have to copy anyway
@@ -361,27 +397,33 @@ RamCacheCLFUS::destroy(RamCacheCLFUSEntry *e)
   return ret;
 }
 
-void
+// Returns true when there are entries left to compress.
+bool
 RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
 {
   if (!cache_config_ram_cache_compress)
-    return;
+    return false;
   ink_assert(vol != 0);
-  MUTEX_TAKE_LOCK(vol->mutex, thread);
+  // the task thread is not to wait on the volume, it comes back shortly
+  if (!MUTEX_TAKE_TRY_LOCK(vol->mutex, thread))
+    return true;
   if (!compressed) {
     compressed = lru[0].head;
     ncompressed = 0;
   }
   float target = (cache_config_ram_cache_compress_percent / 100.0) * objects;
   int n = 0;
+  bool more = false;
   char *b = 0, *bb = 0;
   while (compressed && target > ncompressed) {
     RamCacheCLFUSEntry *e = compressed;
     if (e->flag_bits.incompressible || e->flag_bits.compressed)
       goto Lcontinue;
     n++;
-    if (do_at_most < n)
+    if (do_at_most < n) {
+      more = true;
       break;
+    }
     {
       e->compressed_len = e->size;
       uint32_t l = 0;
@@ -401,6 +443,16 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
       case CACHE_COMPRESSION_LIBLZMA:
         l = e->len;
         break;
+#endif
+#if TS_HAS_ZSTD
+      case CACHE_COMPRESSION_ZSTD:
+        l = (uint32_t)ZSTD_compressBound(e->len);
+        break;
+#endif
+#if TS_HAS_LZ4
+      case CACHE_COMPRESSION_LZ4:
+        l = (uint32_t)LZ4_compressBound(e->len);
+        break;
 #endif
       }
       // store transient data for lock release
@@ -408,6 +460,7 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
       uint32_t elen = e->len;
       INK_MD5 key = e->key;
       MUTEX_UNTAKE_LOCK(vol->mutex, thread);
+      ink_hrtime start = ink_get_hrtime_internal();
       b = (char *)ats_malloc(l);
       bool failed = false;
       switch (ctype) {
@@ -438,6 +491,29 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
         break;
       }
 #endif
+#if TS_HAS_ZSTD
+      case CACHE_COMPRESSION_ZSTD: {
+        size_t ll = ZSTD_compress(b, l, edata->data(), elen, ZSTD_LEVEL);
+        if (ZSTD_isError(ll))
+          failed = true;
+        l = (uint32_t)ll;
+        break;
+      }
+#endif
+#if TS_HAS_LZ4
+      case CACHE_COMPRESSION_LZ4: {
+        int ll = LZ4_compress_default(edata->data(), b, elen, l);
+        if (ll <= 0)
+          failed = true;
+        l = (uint32_t)ll;
+        break;
+      }
+#endif
+      }
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_time_stat, ink_hrtime_to_usec(ink_get_hrtime_internal() - start));
+      if (!failed) {
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_in_bytes_stat, elen);
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_out_bytes_stat, l);
       }
       MUTEX_TAKE_LOCK(vol->mutex, thread);
       // see if the entry is till around
@@ -499,7 +575,7 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
     ncompressed++;
   }
   MUTEX_UNTAKE_LOCK(vol->mutex, thread);
-  return;
+  return more;
 }
 
 void RamCacheCLFUS::requeue_victims(Que(RamCacheCLFUSEntry, lru_link) & victims)
@@ -0,0 +1,354 @@
+/** @file
+
+  W-TinyLFU RAM cache
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  @section details Details
+
+  New objects go into a small LRU window. The objects pushed out of the window
+  compete for the main area with its least recently used object: the one looked
+  up more often recently wins, as counted by a count-min sketch of the lookups
+  which is halved from time to time. A burst of objects seen once goes through
+  the window without displacing anything from the main area.
+
+  The sketch has 4 rows of byte-wide counters saturating at 15, a counter per
+  8KB of RAM cache in each row. It is halved a slice at a time by the lookups
+  which follow, so that no lookup walks all of it under the lock of the stripe.
+
+  The main area is a segmented LRU: the objects admitted start in probation and
+  move to the protected segment when they are hit again, the protected segment
+  being limited to a share of the main area, the rest falling back to probation.
+ */
+
+#include "P_Cache.h"
+
+#define ENTRY_OVERHEAD 128 // per-entry overhead to consider when computing sizes
+
+#define TINYLFU_WINDOW_PERCENT 1     // of the RAM cache
+#define TINYLFU_PROTECTED_PERCENT 80 // of the main area
+#define TINYLFU_SKETCH_ROWS 4
+#define TINYLFU_SKETCH_MAX 15        // counts saturate
+#define TINYLFU_SKETCH_MIN_WIDTH 1024
+#define TINYLFU_AVERAGE_OBJECT_SIZE 8192 // to size the sketch
+#define TINYLFU_SAMPLE_FACTOR 10     // lookups per counter before the counts are halved
+#define TINYLFU_AGE_SLICE 64         // counters halved by each lookup while aging, divides the sketch size
+
+enum { TINYLFU_WINDOW, TINYLFU_PROBATION, TINYLFU_PROTECTED, TINYLFU_AREAS };
+
+struct RamCacheTinyLFUEntry {
+  INK_MD5 key;
+  uint32_t auxkey1;
+  uint32_t auxkey2;
+  uint32_t size; // including ENTRY_OVERHEAD
+  int area;
+  LINK(RamCacheTinyLFUEntry, lru_link);
+  LINK(RamCacheTinyLFUEntry, hash_link);
+  Ptr<IOBufferData> data;
+};
+
+struct RamCacheTinyLFU : public RamCache {
+  int64_t max_bytes;
+  int64_t bytes;
+  int64_t objects;
+
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
+  int get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool copy = false, uint32_t auxkey1 = 0, uint32_t auxkey2 = 0);
+  int fixup(const INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1, uint32_t new_auxkey2);
+
+  void init(int64_t max_bytes, Vol *vol);
+
+  // private
+  Que(RamCacheTinyLFUEntry, lru_link) lru[TINYLFU_AREAS];
+  int64_t area_bytes[TINYLFU_AREAS];
+  int64_t window_max;
+  int64_t protected_max;
+  DList(RamCacheTinyLFUEntry, hash_link) * bucket;
+  int nbuckets;
+  int ibuckets;
+  uint8_t *sketch;
+  uint32_t sketch_mask;
+  uint32_t sketch_adds;
+  uint32_t sketch_age; // the next counter to halve, the size of the sketch when done
+  Vol *vol;
+
+  void resize_hashtable();
+  void record(const INK_MD5 *key);
+  int frequency(const INK_MD5 *key);
+  void move(RamCacheTinyLFUEntry *e, int area);
+  void admit(RamCacheTinyLFUEntry *e);
+  RamCacheTinyLFUEntry *remove(RamCacheTinyLFUEntry *e);
+
+  RamCacheTinyLFU()
+    : max_bytes(0), bytes(0), objects(0), window_max(0), protected_max(0), bucket(0), nbuckets(0), ibuckets(0), sketch(0),
+      sketch_mask(0), sketch_adds(0), sketch_age(0), vol(NULL)
+  {
+    memset(area_bytes, 0, sizeof(area_bytes));
+  }
+  ~RamCacheTinyLFU()
+  {
+    ats_free(bucket);
+    ats_free(sketch);
+  }
+};
+
+ClassAllocator<RamCacheTinyLFUEntry> ramCacheTinyLFUEntryAllocator("RamCacheTinyLFUEntry");
+
+static const int bucket_sizes[] = {127,     251,      509,      1021,     2039,      4093,      8191,     16381,
+                                   32749,   65521,    131071,   262139,   524287,    1048573,   2097143,  4194301,
+                                   8388593, 16777213, 33554393, 67108859, 134217689, 268435399, 536870909};
+
+void
+RamCacheTinyLFU::resize_hashtable()
+{
+  int anbuckets = bucket_sizes[ibuckets];
+  DDebug("ram_cache", "resize hashtable %d", anbuckets);
+  int64_t s = anbuckets * sizeof(DList(RamCacheTinyLFUEntry, hash_link));
+  DList(RamCacheTinyLFUEntry, hash_link) *new_bucket = (DList(RamCacheTinyLFUEntry, hash_link) *)ats_malloc(s);
+  memset(new_bucket, 0, s);
+  if (bucket) {
+    for (int64_t i = 0; i < nbuckets; i++) {
+      RamCacheTinyLFUEntry *e = 0;
+      while ((e = bucket[i].pop()))
+        new_bucket[e->key.slice32(3) % anbuckets].push(e);
+    }
+    ats_free(bucket);
+  }
+  bucket = new_bucket;
+  nbuckets = anbuckets;
+}
+
+void
+RamCacheTinyLFU::init(int64_t abytes, Vol *avol)
+{
+  vol = avol;
+  max_bytes = abytes;
+  DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
+  if (!max_bytes)
+    return;
+  window_max = max_bytes * TINYLFU_WINDOW_PERCENT / 100;
+  protected_max = (max_bytes - window_max) * TINYLFU_PROTECTED_PERCENT / 100;
+  // a counter per object which fits, rounded to a power of 2
+  uint32_t width = TINYLFU_SKETCH_MIN_WIDTH;
+  while (width < (uint64_t)max_bytes / TINYLFU_AVERAGE_OBJECT_SIZE && width < (1U << 30))
+    width <<= 1;
+  sketch_mask = width - 1;
+  sketch_age = TINYLFU_SKETCH_ROWS * width;
+  sketch = (uint8_t *)ats_malloc(TINYLFU_SKETCH_ROWS * width);
+  memset(sketch, 0, TINYLFU_SKETCH_ROWS * width);
+  resize_hashtable();
+}
+
+// The four words of the key are the hashes of the rows.
+void
+RamCacheTinyLFU::record(const INK_MD5 *key)
+{
+  int f = frequency(key);
+  if (f < TINYLFU_SKETCH_MAX) {
+    // only the counts at the minimum, the others overestimate already
+    for (int r = 0; r < TINYLFU_SKETCH_ROWS; r++) {
+      uint8_t *c = &sketch[r * (sketch_mask + 1) + (key->slice32(r) & sketch_mask)];
+      if (*c == f)
+        ++*c;
+    }
+  }
+  ++sketch_adds;
+  if (sketch_age < TINYLFU_SKETCH_ROWS * (sketch_mask + 1)) {
+    uint32_t end = sketch_age + TINYLFU_AGE_SLICE;
+    for (; sketch_age < end; sketch_age++)
+      sketch[sketch_age] >>= 1;
+  } else if (sketch_adds >= TINYLFU_SAMPLE_FACTOR * (sketch_mask + 1)) {
+    sketch_age = 0;
+    sketch_adds /= 2;
+  }
+}
+
+int
+RamCacheTinyLFU::frequency(const INK_MD5 *key)
+{
+  int f = TINYLFU_SKETCH_MAX;
+  for (int r = 0; r < TINYLFU_SKETCH_ROWS; r++) {
+    int c = sketch[r * (sketch_mask + 1) + (key->slice32(r) & sketch_mask)];
+    if (c < f)
+      f = c;
+  }
+  return f;
+}
+
+void
+RamCacheTinyLFU::move(RamCacheTinyLFUEntry *e, int area)
+{
+  lru[e->area].remove(e);
+  area_bytes[e->area] -= e->size;
+  e->area = area;
+  lru[area].enqueue(e);
+  area_bytes[area] += e->size;
+}
+
+int
+RamCacheTinyLFU::get(INK_MD5 *key, Ptr<IOBufferData> *ret_data, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  record(key);
+  uint32_t i = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+      if (e->area == TINYLFU_WINDOW) {
+        move(e, TINYLFU_WINDOW);
+      } else {
+        // hit again in the main area, protect it
+        move(e, TINYLFU_PROTECTED);
+        while (area_bytes[TINYLFU_PROTECTED] > protected_max) {
+          RamCacheTinyLFUEntry *ee = lru[TINYLFU_PROTECTED].head;
+          if (ee == e)
+            break;
+          move(ee, TINYLFU_PROBATION);
+        }
+      }
+      (*ret_data) = e->data;
+      DDebug("ram_cache", "get %X %d %d HIT", key->slice32(3), auxkey1, auxkey2);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  DDebug("ram_cache", "get %X %d %d MISS", key->slice32(3), auxkey1, auxkey2);
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  return 0;
+}
+
+RamCacheTinyLFUEntry *
+RamCacheTinyLFU::remove(RamCacheTinyLFUEntry *e)
+{
+  RamCacheTinyLFUEntry *ret = e->hash_link.next;
+  uint32_t b = e->key.slice32(3) % nbuckets;
+  bucket[b].remove(e);
+  lru[e->area].remove(e);
+  area_bytes[e->area] -= e->size;
+  bytes -= e->size;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -(int64_t)e->size);
+  DDebug("ram_cache", "put %X %d %d FREED", e->key.slice32(3), e->auxkey1, e->auxkey2);
+  e->data = NULL;
+  THREAD_FREE(e, ramCacheTinyLFUEntryAllocator, this_thread());
+  objects--;
+  return ret;
+}
+
+// An object out of the window gets into the main area if it is looked up more
+// often than those it would push out.
+void
+RamCacheTinyLFU::admit(RamCacheTinyLFUEntry *e)
+{
+  int64_t main_max = max_bytes - window_max;
+  int f = -1;
+
+  while (area_bytes[TINYLFU_PROBATION] + area_bytes[TINYLFU_PROTECTED] + e->size > main_max) {
+    RamCacheTinyLFUEntry *victim = lru[TINYLFU_PROBATION].head;
+    if (!victim)
+      victim = lru[TINYLFU_PROTECTED].head;
+    if (!victim)
+      break;
+    if (f < 0)
+      f = frequency(&e->key);
+    if (f <= frequency(&victim->key)) {
+      DDebug("ram_cache", "put %X %d %d REJECTED", e->key.slice32(3), e->auxkey1, e->auxkey2);
+      remove(e);
+      return;
+    }
+    remove(victim);
+  }
+  move(e, TINYLFU_PROBATION);
+}
+
+// ignore 'copy' since we don't touch the data
+int
+RamCacheTinyLFU::put(INK_MD5 *key, IOBufferData *data, uint32_t len, bool, uint32_t auxkey1, uint32_t auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key) {
+      if (e->auxkey1 == auxkey1 && e->auxkey2 == auxkey2) {
+        move(e, e->area);
+        return 1;
+      } else { // discard when aux keys conflict
+        e = remove(e);
+        continue;
+      }
+    }
+    e = e->hash_link.next;
+  }
+  uint32_t size = ENTRY_OVERHEAD + data->block_size();
+  if (size > max_bytes - window_max) {
+    DDebug("ram_cache", "put %X %d %d len %d TOO BIG", key->slice32(3), auxkey1, auxkey2, len);
+    return 0;
+  }
+  e = THREAD_ALLOC(ramCacheTinyLFUEntryAllocator, this_ethread());
+  e->key = *key;
+  e->auxkey1 = auxkey1;
+  e->auxkey2 = auxkey2;
+  e->data = data;
+  e->size = size;
+  e->area = TINYLFU_WINDOW;
+  bucket[i].push(e);
+  lru[TINYLFU_WINDOW].enqueue(e);
+  area_bytes[TINYLFU_WINDOW] += size;
+  bytes += size;
+  objects++;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, size);
+  DDebug("ram_cache", "put %X %d %d INSERTED", key->slice32(3), auxkey1, auxkey2);
+  // the window keeps at least the object just put
+  while (area_bytes[TINYLFU_WINDOW] > window_max && lru[TINYLFU_WINDOW].head != e)
+    admit(lru[TINYLFU_WINDOW].head);
+  if (objects > nbuckets) {
+    ++ibuckets;
+    resize_hashtable();
+  }
+  return 1;
+}
+
+int
+RamCacheTinyLFU::fixup(const INK_MD5 *key, uint32_t old_auxkey1, uint32_t old_auxkey2, uint32_t new_auxkey1,
+                       uint32_t new_auxkey2)
+{
+  if (!max_bytes)
+    return 0;
+  uint32_t i = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey1 == old_auxkey1 && e->auxkey2 == old_auxkey2) {
+      e->auxkey1 = new_auxkey1;
+      e->auxkey2 = new_auxkey2;
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  return 0;
+}
+
+RamCache *
+new_RamCacheTinyLFU()
+{
+  return new RamCacheTinyLFU;
+}
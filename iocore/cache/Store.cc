@@ -35,6 +35,7 @@
 
 char const Store::VOLUME_KEY[] = "volume";
 char const Store::HASH_BASE_STRING_KEY[] = "id";
+char const Store::TIER_KEY[] = "tier";
 
 static span_error_t
 make_span_error(int error)
@@ -244,6 +245,12 @@ Span::volume_number_set(int n)
   forced_volume_num = n;
 }
 
+void
+Span::fast_tier_set(bool fast)
+{
+  fast_tier = fast;
+}
+
 void
 Store::delete_all()
 {
@@ -353,6 +360,7 @@ Store::read_config()
 
     int64_t size = -1;
     int volume_num = -1;
+    bool fast_tier = false;
     char const *e;
     while (0 != (e = tokens.getNext())) {
       if (ParseRules::is_digit(*e)) {
@@ -374,13 +382,23 @@ Store::read_config()
           err = "error parsing volume number";
           goto Lfail;
         }
+      } else if (0 == strncasecmp(TIER_KEY, e, sizeof(TIER_KEY) - 1)) {
+        e += sizeof(TIER_KEY) - 1;
+        if ('=' == *e)
+          ++e;
+        if (0 == strcasecmp(e, "fast")) {
+          fast_tier = true;
+        } else if (0 != strcasecmp(e, "slow")) {
+          err = "error parsing storage tier";
+          goto Lfail;
+        }
       }
     }
 
     char *pp = Layout::get()->relative(path);
     ns = new Span;
-    Debug("cache_init", "Store::read_config - ns = new Span; ns->init(\"%s\",%" PRId64 "), forced volume=%d%s%s", pp, size,
-          volume_num, seed ? " id=" : "", seed ? seed : "");
+    Debug("cache_init", "Store::read_config - ns = new Span; ns->init(\"%s\",%" PRId64 "), forced volume=%d%s%s%s", pp, size,
+          volume_num, seed ? " id=" : "", seed ? seed : "", fast_tier ? " tier=fast" : "");
     if ((err = ns->init(pp, size))) {
       RecSignalWarning(REC_SIGNAL_SYSTEM_ERROR, "could not initialize storage \"%s\" [%s]", pp, err);
       Debug("cache_init", "Store::read_config - could not initialize storage \"%s\" [%s]", pp, err);
@@ -396,6 +414,7 @@ Store::read_config()
       ns->hash_base_string_set(seed);
     if (volume_num > 0)
       ns->volume_number_set(volume_num);
+    ns->fast_tier_set(fast_tier);
 
     // new Span
     {
@@ -55,6 +55,7 @@ char *dns_resolv_conf = NULL;
 char *dns_local_ipv6 = NULL;
 char *dns_local_ipv4 = NULL;
 int dns_thread = 0;
+int dns_threads = 1;
 int dns_prefer_ipv6 = 0;
 namespace
 {
@@ -191,16 +192,28 @@ DNSProcessor::start(int, size_t stacksize)
   REC_ReadConfigStringAlloc(dns_local_ipv6, "proxy.config.dns.local_ipv6");
   REC_ReadConfigStringAlloc(dns_resolv_conf, "proxy.config.dns.resolv_conf");
   REC_EstablishStaticConfigInt32(dns_thread, "proxy.config.dns.dedicated_thread");
+  REC_EstablishStaticConfigInt32(dns_threads, "proxy.config.dns.threads");
+  dns_threads = MAX(1, MIN(dns_threads, MAX_DNS_THREADS));
 
   if (dns_thread > 0) {
-    // TODO: Hmmm, should we just get a single thread some other way?
-    ET_DNS = eventProcessor.spawn_event_threads(1, "ET_DNS", stacksize);
-    initialize_thread_for_net(eventProcessor.eventthread[ET_DNS][0]);
+    ET_DNS = eventProcessor.spawn_event_threads(dns_threads, "ET_DNS", stacksize);
+    for (int i = 0; i < dns_threads; i++)
+      initialize_thread_for_net(eventProcessor.eventthread[ET_DNS][i]);
   } else {
-    // Initialize the first event thread for DNS.
+    // Initialize the first event threads for DNS.
     ET_DNS = ET_CALL;
+    dns_threads = MIN(dns_threads, eventProcessor.n_threads_for_type[ET_CALL]);
   }
   thread = eventProcessor.eventthread[ET_DNS][0];
+  Debug("dns", "%d DNS handler threads", dns_threads);
+
+  // Per handler query counters, to see how the queries are balanced across the DNS threads.
+  dns_handler_rsb = RecAllocateRawStatBlock(dns_threads);
+  for (int i = 0; i < dns_threads; i++) {
+    char name[64];
+    snprintf(name, sizeof(name), "proxy.process.dns.queries.thread_%d", i);
+    RecRegisterRawStat(dns_handler_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i, RecRawStatSyncSum);
+  }
 
   dns_failover_try_period = dns_timeout + 1; // Modify the "default" accordingly
 
@@ -209,7 +222,7 @@ DNSProcessor::start(int, size_t stacksize)
     SplitDNSConfig::reconfigure();
   }
 
-  // Setup the default DNSHandler, it's used both by normal DNS, and SplitDNS (for PTR lookups etc.)
+  // Setup the default DNSHandlers, they are used both by normal DNS, and SplitDNS (for PTR lookups etc.)
   dns_init();
   open();
 
@@ -219,23 +232,41 @@ DNSProcessor::start(int, size_t stacksize)
 void
 DNSProcessor::open(sockaddr const *target)
 {
-  DNSHandler *h = new DNSHandler;
-
-  h->mutex = thread->mutex;
-  h->m_res = &l_res;
-  ats_ip_copy(&h->local_ipv4.sa, &local_ipv4.sa);
-  ats_ip_copy(&h->local_ipv6.sa, &local_ipv6.sa);
+  // Each handler has its own sockets on its own thread.
+  for (int i = 0; i < dns_threads; i++) {
+    DNSHandler *h = new DNSHandler;
+
+    h->thread = eventProcessor.eventthread[ET_DNS][i];
+    h->index = i;
+    h->mutex = h->thread->mutex;
+    h->m_res = &l_res;
+    ats_ip_copy(&h->local_ipv4.sa, &local_ipv4.sa);
+    ats_ip_copy(&h->local_ipv6.sa, &local_ipv6.sa);
+
+    if (target)
+      ats_ip_copy(&h->ip, target);
+    else
+      ats_ip_invalidate(&h->ip); // marked to use default.
 
-  if (target)
-    ats_ip_copy(&h->ip, target);
-  else
-    ats_ip_invalidate(&h->ip); // marked to use default.
+    if (!dns_handler_initialized)
+      handlers[i] = h;
 
-  if (!dns_handler_initialized)
-    handler = h;
+    SET_CONTINUATION_HANDLER(h, &DNSHandler::startEvent);
+    h->thread->schedule_imm(h);
+  }
+  if (!dns_handler_initialized) {
+    n_handlers = dns_threads;
+    handler = handlers[0];
+  }
+}
 
-  SET_CONTINUATION_HANDLER(h, &DNSHandler::startEvent);
-  thread->schedule_imm(h);
+DNSHandler *
+DNSProcessor::handler_for(const char *qname, int qtype)
+{
+  if (n_handlers <= 1)
+    return handler;
+  DNSQueryHashing::Query q = {qname, qtype};
+  return handlers[DNSQueryHashing::hash(q) % n_handlers];
 }
 
 //
@@ -347,8 +378,9 @@ ink_dn_expand(const u_char *msg, const u_char *eom, const u_char *comp_dn, u_cha
   return ::dn_expand((unsigned char *)msg, (unsigned char *)eom, (unsigned char *)comp_dn, (char *)exp_dn, length);
 }
 
-DNSProcessor::DNSProcessor() : thread(NULL), handler(NULL)
+DNSProcessor::DNSProcessor() : thread(NULL), handler(NULL), n_handlers(0)
 {
+  ink_zero(handlers);
   ink_zero(l_res);
   ink_zero(local_ipv6);
   ink_zero(local_ipv4);
@@ -371,20 +403,6 @@ DNSEntry::init(const char *x, int len, int qtype_arg, Continuation *acont, DNSPr
   action = acont;
   submit_thread = acont->mutex->thread_holding;
 
-#ifdef SPLIT_DNS
-  if (SplitDNSConfig::gsplit_dns_enabled) {
-    dnsH = opt.handler ? opt.handler : dnsProcessor.handler;
-  } else {
-    dnsH = dnsProcessor.handler;
-  }
-#else
-  dnsH = dnsProcessor.handler;
-#endif // SPLIT_DNS
-
-  dnsH->txn_lookup_timeout = opt.timeout;
-
-  mutex = dnsH->mutex;
-
   if (is_addr_query(qtype) || qtype == T_SRV) {
     if (len) {
       len = len > (MAXDNAME - 1) ? (MAXDNAME - 1) : len;
@@ -405,6 +423,20 @@ DNSEntry::init(const char *x, int len, int qtype_arg, Continuation *acont, DNSPr
       ink_assert(!"T_PTR query to DNS must be IP address.");
   }
 
+#ifdef SPLIT_DNS
+  if (SplitDNSConfig::gsplit_dns_enabled) {
+    dnsH = opt.handler ? opt.handler : dnsProcessor.handler_for(qname, qtype);
+  } else {
+    dnsH = dnsProcessor.handler_for(qname, qtype);
+  }
+#else
+  dnsH = dnsProcessor.handler_for(qname, qtype);
+#endif // SPLIT_DNS
+
+  dnsH->txn_lookup_timeout = opt.timeout;
+
+  mutex = dnsH->mutex;
+
   SET_HANDLER((DNSEntryHandler)&DNSEntry::mainEvent);
 }
 
@@ -417,7 +449,7 @@ void
 DNSHandler::open_con(sockaddr const *target, bool failed, int icon)
 {
   ip_port_text_buffer ip_text;
-  PollDescriptor *pd = get_PollDescriptor(dnsProcessor.thread);
+  PollDescriptor *pd = get_PollDescriptor(thread);
 
   if (!icon && target) {
     ats_ip_copy(&ip, target);
@@ -484,39 +516,35 @@ DNSHandler::startEvent(int /* event ATS_UNUSED */, Event *e)
 
   this->validate_ip();
 
-  if (!dns_handler_initialized) {
-    //
-    // If we are THE handler, open connection and configure for
-    // periodic execution.
-    //
-    dns_handler_initialized = 1;
-    SET_HANDLER(&DNSHandler::mainEvent);
-    if (dns_ns_rr) {
-      int max_nscount = m_res->nscount;
-      if (max_nscount > MAX_NAMED)
-        max_nscount = MAX_NAMED;
-      n_con = 0;
-      for (int i = 0; i < max_nscount; i++) {
-        ip_port_text_buffer buff;
-        sockaddr *sa = &m_res->nsaddr_list[i].sa;
-        if (ats_is_ip(sa)) {
-          open_con(sa, false, n_con);
-          ++n_con;
-          Debug("dns_pas", "opened connection to %s, n_con = %d", ats_ip_nptop(sa, buff, sizeof(buff)), n_con);
-        }
+  //
+  // We are one of THE handlers, open connection and configure for
+  // periodic execution.
+  //
+  ink_assert(dnsProcessor.handlers[index] == this);
+  dns_handler_initialized = 1;
+  SET_HANDLER(&DNSHandler::mainEvent);
+  if (dns_ns_rr) {
+    int max_nscount = m_res->nscount;
+    if (max_nscount > MAX_NAMED)
+      max_nscount = MAX_NAMED;
+    n_con = 0;
+    for (int i = 0; i < max_nscount; i++) {
+      ip_port_text_buffer buff;
+      sockaddr *sa = &m_res->nsaddr_list[i].sa;
+      if (ats_is_ip(sa)) {
+        open_con(sa, false, n_con);
+        ++n_con;
+        Debug("dns_pas", "opened connection to %s, n_con = %d", ats_ip_nptop(sa, buff, sizeof(buff)), n_con);
       }
-      dns_ns_rr_init_down = 0;
-    } else {
-      open_con(0); // use current target address.
-      n_con = 1;
     }
-    e->ethread->schedule_every(this, DNS_PERIOD);
-
-    return EVENT_CONT;
+    dns_ns_rr_init_down = 0;
   } else {
-    ink_assert(false); // I.e. this should never really happen
-    return EVENT_DONE;
+    open_con(0); // use current target address.
+    n_con = 1;
   }
+  e->ethread->schedule_every(this, DNS_PERIOD);
+
+  return EVENT_CONT;
 }
 
 /**
@@ -790,11 +818,53 @@ DNSHandler::recv_dns(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   }
 }
 
+/** Put @a e on the timer wheel, to time out after @a delay. */
+void
+DNSHandler::timer_schedule(DNSEntry *e, ink_hrtime delay)
+{
+  timer_cancel(e);
+  e->timeout_at = ink_get_hrtime() + delay;
+  timer_wheel[(e->timeout_at / DNS_TIMER_TICK) % DNS_TIMER_SLOTS].push(e);
+}
+
+void
+DNSHandler::timer_cancel(DNSEntry *e)
+{
+  if (e->timeout_at) {
+    timer_wheel[(e->timeout_at / DNS_TIMER_TICK) % DNS_TIMER_SLOTS].remove(e);
+    e->timeout_at = 0;
+  }
+}
+
+/** Time out the entries due by @a now. The timeouts more than a turn of the wheel away are passed over. */
+void
+DNSHandler::timer_expire(ink_hrtime now)
+{
+  int64_t tick = now / DNS_TIMER_TICK;
+
+  if (!timer_tick || tick - timer_tick >= DNS_TIMER_SLOTS)
+    timer_tick = tick - DNS_TIMER_SLOTS + 1;
+  for (; timer_tick <= tick; timer_tick++) {
+    DList(DNSEntry, timer_link) &slot = timer_wheel[timer_tick % DNS_TIMER_SLOTS];
+    // a timeout may reschedule or end any entry, look again from the start after each one
+    for (DNSEntry *e = slot.head; e;) {
+      if (e->timeout_at > now) {
+        e = e->timer_link.next;
+        continue;
+      }
+      timer_cancel(e);
+      e->handleEvent(EVENT_INTERVAL, NULL);
+      e = slot.head;
+    }
+  }
+}
+
 /** Main event for the DNSHandler. Attempt to read from and write to named. */
 int
 DNSHandler::mainEvent(int event, Event *e)
 {
   recv_dns(event, e);
+  timer_expire(ink_get_hrtime());
   if (dns_ns_rr) {
     ink_hrtime t = ink_get_hrtime();
     if (t - last_primary_retry > DNS_PRIMARY_RETRY_PERIOD) {
@@ -842,36 +912,29 @@ DNSHandler::mainEvent(int event, Event *e)
 inline static DNSEntry *
 get_dns(DNSHandler *h, uint16_t id)
 {
-  for (DNSEntry *e = h->entries.head; e; e = (DNSEntry *)e->link.next) {
-    if (e->once_written_flag) {
-      for (int j = 0; j < MAX_DNS_RETRIES; j++) {
-        if (e->id[j] == id) {
-          return e;
-        } else if (e->id[j] < 0) {
-          goto Lnext;
-        }
-      }
-    }
-  Lnext:
-    ;
-  }
-  return NULL;
+  DNSEntry *e = h->qid_entries[id];
+  return e && e->once_written_flag ? e : NULL;
 }
 
 /** Find a DNSEntry by query name and type. */
 inline static DNSEntry *
 get_entry(DNSHandler *h, char *qname, int qtype)
 {
-  for (DNSEntry *e = h->entries.head; e; e = (DNSEntry *)e->link.next) {
-    if (e->qtype == qtype) {
-      if (is_addr_query(qtype)) {
-        if (!strcmp(qname, e->qname))
-          return e;
-      } else if (0 == memcmp(qname, e->qname, e->qname_len))
-        return e;
-    }
-  }
-  return NULL;
+  DNSQueryHashing::Query q = {qname, qtype};
+  return h->queries.find(q);
+}
+
+// The entry is renamed, as the query name is its key in the table of the handler.
+static inline void
+rename_begin(DNSHandler *h, DNSEntry *e)
+{
+  h->queries.remove(h->queries.find(e));
+}
+
+static inline void
+rename_end(DNSHandler *h, DNSEntry *e)
+{
+  h->queries.insert(e);
 }
 
 /** Write up to dns_max_dns_in_flight entries. */
@@ -972,6 +1035,9 @@ write_dns_event(DNSHandler *h, DNSEntry *e)
     h->release_query_id(e->id[dns_retries - e->retries]);
   }
   e->id[dns_retries - e->retries] = i;
+  h->qid_entries[i] = e;
+  if (h->index >= 0)
+    RecIncrRawStatSum(dns_handler_rsb, h->mutex->thread_holding, h->index, 1);
   Debug("dns", "send query (qtype=%d) for %s to fd %d", e->qtype, e->qname, h->con[h->name_server].fd);
 
   int s = socketManager.send(h->con[h->name_server].fd, blob._b, r, 0);
@@ -995,13 +1061,15 @@ write_dns_event(DNSHandler *h, DNSEntry *e)
 
   e->send_time = ink_get_hrtime();
 
-  if (e->timeout)
+  if (e->timeout) {
     e->timeout->cancel();
+    e->timeout = NULL;
+  }
 
   if (h->txn_lookup_timeout) {
-    e->timeout = h->mutex->thread_holding->schedule_in(e, HRTIME_MSECONDS(h->txn_lookup_timeout)); // this is in msec
+    h->timer_schedule(e, HRTIME_MSECONDS(h->txn_lookup_timeout)); // this is in msec
   } else {
-    e->timeout = h->mutex->thread_holding->schedule_in(e, HRTIME_SECONDS(dns_timeout));
+    h->timer_schedule(e, HRTIME_SECONDS(dns_timeout));
   }
 
   Debug("dns", "sent qname = %s, id = %u, nameserver = %d", e->qname, e->id[dns_retries - e->retries], h->name_server);
@@ -1060,6 +1128,7 @@ DNSEntry::mainEvent(int event, Event *e)
     } else {
       Debug("dns", "adding first to collapsing queue");
       dnsH->entries.enqueue(this);
+      dnsH->queries.insert(this);
       write_dns(dnsH);
     }
     return EVENT_DONE;
@@ -1095,7 +1164,7 @@ DNSProcessor::getby(const char *x, int len, int type, Continuation *cont, Option
   e->init(x, len, type, cont, opt);
   MUTEX_TRY_LOCK(lock, e->mutex, this_ethread());
   if (!lock.is_locked())
-    thread->schedule_imm(e);
+    e->dnsH->thread->schedule_imm(e);
   else
     e->handleEvent(EVENT_IMMEDIATE, 0);
   return &e->action;
@@ -1129,9 +1198,11 @@ dns_result(DNSHandler *h, DNSEntry *e, HostEnt *ent, bool retry)
         if (e->orig_qname_len + strlen(*e->domains) + 2 > MAXDNAME) {
           Debug("dns", "domain too large %.*s + %s", e->orig_qname_len, e->qname, *e->domains);
         } else {
+          rename_begin(h, e);
           e->qname[e->orig_qname_len] = '.';
           e->qname_len =
             e->orig_qname_len + 1 + ink_strlcpy(e->qname + e->orig_qname_len + 1, *e->domains, MAXDNAME - (e->orig_qname_len + 1));
+          rename_end(h, e);
           ++(e->domains);
           e->retries = dns_retries;
           Debug("dns", "new name = %s retries = %d", e->qname, e->retries);
@@ -1144,7 +1215,9 @@ dns_result(DNSHandler *h, DNSEntry *e, HostEnt *ent, bool retry)
         ++(e->domains);
       } while (*e->domains);
     } else {
+      rename_begin(h, e);
       e->qname[e->qname_len] = 0;
+      rename_end(h, e);
       if (!strchr(e->qname, '.') && !e->last) {
         e->last = true;
         write_dns(h);
@@ -1165,6 +1238,8 @@ dns_result(DNSHandler *h, DNSEntry *e, HostEnt *ent, bool retry)
     }
   }
   h->entries.remove(e);
+  h->queries.remove(h->queries.find(e));
+  h->timer_cancel(e);
 
   if (is_debug_tag_set("dns")) {
     if (is_addr_query(e->qtype)) {
@@ -1231,6 +1306,7 @@ dns_result(DNSHandler *h, DNSEntry *e, HostEnt *ent, bool retry)
 Lretry:
   e->result_ent = ent;
   e->retries = 0;
+  h->timer_cancel(e);
   if (e->timeout)
     e->timeout->cancel();
   e->timeout = h->mutex->thread_holding->schedule_in(e, DNS_PERIOD);
@@ -1595,6 +1671,7 @@ Lerror:
 
 
 RecRawStatBlock *dns_rsb;
+RecRawStatBlock *dns_handler_rsb;
 
 void
 ink_dns_init(ModuleVersion v)
@@ -1700,4 +1777,112 @@ REGRESSION_TEST(DNS)(RegressionTest *t, int atype, int *pstatus)
   eventProcessor.schedule_in(new DNSRegressionContinuation(4, 4, dns_test_hosts, t, atype, pstatus), HRTIME_SECONDS(1));
 }
 
+#define DNS_TEST_QUERIES 2048
+#define DNS_TEST_LOOKUPS (64 * DNS_TEST_QUERIES)
+
+// The lookups of the queries in flight by a handler, as they were done before the handler indexed them.
+static DNSEntry *
+dns_test_scan_id(DNSHandler *h, int id)
+{
+  for (DNSEntry *e = h->entries.head; e; e = (DNSEntry *)e->link.next) {
+    if (e->once_written_flag && e->id[0] == id)
+      return e;
+  }
+  return NULL;
+}
+
+static DNSEntry *
+dns_test_scan_name(DNSHandler *h, const char *qname, int qtype)
+{
+  for (DNSEntry *e = h->entries.head; e; e = (DNSEntry *)e->link.next) {
+    if (e->qtype == qtype && !strcmp(qname, e->qname))
+      return e;
+  }
+  return NULL;
+}
+
+// Fills a handler with queries in flight and compares the rates of their lookups to the linear scans.
+EXCLUSIVE_REGRESSION_TEST(DNS_entries)(RegressionTest *t, int /* atype ATS_UNUSED */, int *status)
+{
+  DNSHandler *h = new DNSHandler;
+  DNSEntry *entries = new DNSEntry[DNS_TEST_QUERIES];
+  int ret = REGRESSION_TEST_PASSED;
+  ink_hrtime ttime;
+  uint64_t us;
+  int i;
+
+  for (i = 0; i < DNS_TEST_QUERIES; i++) {
+    DNSEntry *e = &entries[i];
+    e->qtype = T_A;
+    e->qname_len = snprintf(e->qname, MAXDNAME, "host%d.example.com", i);
+    e->id[0] = (i * 7919) & USHRT_MAX;
+    e->once_written_flag = true;
+    h->entries.enqueue(e);
+    h->queries.insert(e);
+    h->qid_entries[e->id[0]] = e;
+    h->timer_schedule(e, HRTIME_MSECONDS(i));
+  }
+
+  ttime = ink_get_hrtime_internal();
+  for (i = 0; i < DNS_TEST_LOOKUPS; i++) {
+    DNSEntry *e = &entries[(i * 31) % DNS_TEST_QUERIES];
+    if (get_dns(h, e->id[0]) != e)
+      ret = REGRESSION_TEST_FAILED;
+  }
+  us = (ink_get_hrtime_internal() - ttime) / HRTIME_USECOND;
+  if (us)
+    rprintf(t, "lookup by id rate = %d / second\n", (int)((DNS_TEST_LOOKUPS * (uint64_t)1000000) / us));
+  ttime = ink_get_hrtime_internal();
+  for (i = 0; i < DNS_TEST_LOOKUPS; i++) {
+    DNSEntry *e = &entries[(i * 31) % DNS_TEST_QUERIES];
+    if (get_entry(h, e->qname, e->qtype) != e)
+      ret = REGRESSION_TEST_FAILED;
+  }
+  us = (ink_get_hrtime_internal() - ttime) / HRTIME_USECOND;
+  if (us)
+    rprintf(t, "lookup by name rate = %d / second\n", (int)((DNS_TEST_LOOKUPS * (uint64_t)1000000) / us));
+
+  // the scans are slow enough to take a fraction of the lookups
+  ttime = ink_get_hrtime_internal();
+  for (i = 0; i < DNS_TEST_QUERIES; i++) {
+    DNSEntry *e = &entries[(i * 31) % DNS_TEST_QUERIES];
+    if (dns_test_scan_id(h, e->id[0]) != e)
+      ret = REGRESSION_TEST_FAILED;
+  }
+  us = (ink_get_hrtime_internal() - ttime) / HRTIME_USECOND;
+  if (us)
+    rprintf(t, "scan by id rate = %d / second\n", (int)((DNS_TEST_QUERIES * (uint64_t)1000000) / us));
+  ttime = ink_get_hrtime_internal();
+  for (i = 0; i < DNS_TEST_QUERIES; i++) {
+    DNSEntry *e = &entries[(i * 31) % DNS_TEST_QUERIES];
+    if (dns_test_scan_name(h, e->qname, e->qtype) != e)
+      ret = REGRESSION_TEST_FAILED;
+  }
+  us = (ink_get_hrtime_internal() - ttime) / HRTIME_USECOND;
+  if (us)
+    rprintf(t, "scan by name rate = %d / second\n", (int)((DNS_TEST_QUERIES * (uint64_t)1000000) / us));
+
+  // a query of another type is not collapsed into these
+  if (get_entry(h, entries[0].qname, T_AAAA))
+    ret = REGRESSION_TEST_FAILED;
+  for (i = 0; i < DNS_TEST_QUERIES; i++) {
+    DNSEntry *e = &entries[i];
+    h->timer_cancel(e);
+    h->queries.remove(h->queries.find(e));
+    h->entries.remove(e);
+    h->release_query_id(e->id[0]);
+    if (get_dns(h, e->id[0]) || get_entry(h, e->qname, e->qtype))
+      ret = REGRESSION_TEST_FAILED;
+  }
+  for (i = 0; i < DNS_TIMER_SLOTS; i++) {
+    if (h->timer_wheel[i].head)
+      ret = REGRESSION_TEST_FAILED;
+  }
+
+  delete[] entries;
+  ats_free(h->qid_entries);
+  delete h;
+  *status = ret;
+}
+
 #endif
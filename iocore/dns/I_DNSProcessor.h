@@ -62,6 +62,9 @@ struct HostEnt : RefCountObj {
 
 extern EventType ET_DNS;
 
+// the maximum of proxy.config.dns.threads
+#define MAX_DNS_THREADS 64
+
 struct DNSHandler;
 
 struct DNSProcessor : public Processor {
@@ -124,12 +127,18 @@ struct DNSProcessor : public Processor {
   //
   void open(sockaddr const *ns = 0);
 
+  // The handler of the queries for @a qname, the queries of a name all go to the same one so that they collapse.
+  DNSHandler *handler_for(const char *qname, int qtype);
+
   DNSProcessor();
 
   // private:
   //
   EThread *thread;
   DNSHandler *handler;
+  // A handler on each of the first n_handlers threads of ET_DNS, handler is the first one.
+  int n_handlers;
+  DNSHandler *handlers[MAX_DNS_THREADS];
   ts_imp_res_state l_res;
   IpEndpoint local_ipv6;
   IpEndpoint local_ipv4;
@@ -68,6 +68,9 @@ extern unsigned int dns_sequence_number;
 #define DNS_SEQUENCE_NUMBER_RESTART_OFFSET 4000
 #define DNS_PRIMARY_RETRY_PERIOD HRTIME_SECONDS(5)
 #define DNS_PRIMARY_REOPEN_PERIOD HRTIME_SECONDS(60)
+// the lookup timeouts are kept on a wheel of DNS_TIMER_SLOTS slots of DNS_TIMER_TICK
+#define DNS_TIMER_SLOTS 1024
+#define DNS_TIMER_TICK HRTIME_MSECONDS(10)
 #define BAD_DNS_RESULT ((HostEnt *)(uintptr_t)-1)
 #define DEFAULT_NUM_TRY_SERVER 8
 
@@ -109,6 +112,8 @@ struct DNSHandler;
 
 struct RecRawStatBlock;
 extern RecRawStatBlock *dns_rsb;
+// the queries sent by each handler of the DNSProcessor
+extern RecRawStatBlock *dns_handler_rsb;
 
 // Stat Macros
 
@@ -152,7 +157,8 @@ struct DNSEntry : public Continuation {
   char **domains;
   EThread *submit_thread;
   Action action;
-  Event *timeout;
+  Event *timeout;        ///< Retry of the result, the lookup timeout is on the handler's timer wheel.
+  ink_hrtime timeout_at; ///< When the lookup times out, 0 if it is not on the timer wheel.
   Ptr<HostEnt> result_ent;
   DNSHandler *dnsH;
   bool written_flag;
@@ -160,6 +166,8 @@ struct DNSEntry : public Continuation {
   bool last;
   LINK(DNSEntry, dup_link);
   Que(DNSEntry, dup_link) dups;
+  LINK(DNSEntry, name_link);
+  LINK(DNSEntry, timer_link);
 
   int mainEvent(int event, Event *e);
   int delayEvent(int event, Event *e);
@@ -169,7 +177,7 @@ struct DNSEntry : public Continuation {
 
   DNSEntry()
     : Continuation(NULL), qtype(0), host_res_style(HOST_RES_NONE), retries(DEFAULT_DNS_RETRIES), which_ns(NO_NAMESERVER_SELECTED),
-      submit_time(0), send_time(0), qname_len(0), orig_qname_len(0), domains(0), timeout(0), result_ent(0), dnsH(0),
+      submit_time(0), send_time(0), qname_len(0), orig_qname_len(0), domains(0), timeout(0), timeout_at(0), result_ent(0), dnsH(0),
       written_flag(false), once_written_flag(false), last(false)
   {
     for (int i = 0; i < MAX_DNS_RETRIES; i++)
@@ -181,7 +189,40 @@ struct DNSEntry : public Continuation {
 
 typedef int (DNSEntry::*DNSEntryHandler)(int, void *);
 
-struct DNSEntry;
+/// Interface class for the table of the entries by query name and type.
+struct DNSQueryHashing {
+  struct Query {
+    const char *qname;
+    int qtype;
+  };
+
+  typedef uint32_t ID;
+  typedef Query Key;
+  typedef DNSEntry Value;
+  typedef DList(DNSEntry, name_link) ListHead;
+
+  static ID
+  hash(Key key)
+  {
+    ID h = 2166136261U; // FNV-1a
+    for (const char *c = key.qname; *c; c++)
+      h = (h ^ (unsigned char)*c) * 16777619U;
+    return h ^ key.qtype;
+  }
+  static Key
+  key(Value const *value)
+  {
+    Key k = {value->qname, value->qtype};
+    return k;
+  }
+  static bool
+  equal(Key lhs, Key rhs)
+  {
+    return lhs.qtype == rhs.qtype && !strcmp(lhs.qname, rhs.qname);
+  }
+};
+
+typedef TSHashTable<DNSQueryHashing> DNSQueryTable;
 
 /**
   One DNSHandler is allocated to handle all DNS traffic by polling a
@@ -193,10 +234,16 @@ struct DNSHandler : public Continuation {
   IpEndpoint ip;
   IpEndpoint local_ipv6; ///< Local V6 address if set.
   IpEndpoint local_ipv4; ///< Local V4 address if set.
+  EThread *thread;       ///< The thread the handler runs on.
+  int index;             ///< Index of the handler in the DNSProcessor, -1 for the split DNS ones.
   int ifd[MAX_NAMED];
   int n_con;
   DNSConnection con[MAX_NAMED];
   Queue<DNSEntry> entries;
+  DNSQueryTable queries;  ///< The entries by query name and type, to collapse the queries.
+  DNSEntry **qid_entries; ///< The entries by the query ids in use.
+  DList(DNSEntry, timer_link) timer_wheel[DNS_TIMER_SLOTS];
+  int64_t timer_tick; ///< The next tick of the timer wheel to expire.
   Queue<DNSConnection> triggered;
   int in_flight;
   int name_server;
@@ -265,10 +312,15 @@ struct DNSHandler : public Continuation {
   void switch_named(int ndx);
   uint16_t get_query_id();
 
+  void timer_schedule(DNSEntry *e, ink_hrtime delay);
+  void timer_cancel(DNSEntry *e);
+  void timer_expire(ink_hrtime now);
+
   void
   release_query_id(uint16_t qid)
   {
     qid_in_flight[qid >> 6] &= (uint64_t) ~(0x1ULL << (qid & 0x3F));
+    qid_entries[qid] = NULL;
   };
 
   void
@@ -317,8 +369,9 @@ struct DNSServer {
 
 TS_INLINE
 DNSHandler::DNSHandler()
-  : Continuation(NULL), n_con(0), in_flight(0), name_server(0), in_write_dns(0), hostent_cache(0), last_primary_retry(0),
-    last_primary_reopen(0), m_res(0), txn_lookup_timeout(0), generator((uint32_t)((uintptr_t)time(NULL) ^ (uintptr_t) this))
+  : Continuation(NULL), thread(NULL), index(-1), n_con(0), qid_entries((DNSEntry **)ats_calloc(USHRT_MAX + 1, sizeof(DNSEntry *))),
+    timer_tick(0), in_flight(0), name_server(0), in_write_dns(0), hostent_cache(0), last_primary_retry(0), last_primary_reopen(0),
+    m_res(0), txn_lookup_timeout(0), generator((uint32_t)((uintptr_t)time(NULL) ^ (uintptr_t) this))
 {
   ats_ip_invalidate(&ip);
   for (int i = 0; i < MAX_NAMED; i++) {
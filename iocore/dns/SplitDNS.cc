@@ -505,13 +505,14 @@ SplitDNSRecord::Init(matcher_line *line_info)
   }
 
   dnsH->m_res = res;
+  dnsH->thread = eventProcessor.eventthread[ET_DNS][0];
   dnsH->mutex = SplitDNSConfig::dnsHandler_mutex;
   ats_ip_invalidate(&dnsH->ip.sa); // Mark to use default DNS.
 
   m_servers.x_dnsH = dnsH;
 
   SET_CONTINUATION_HANDLER(dnsH, &DNSHandler::startEvent_sdns);
-  (eventProcessor.eventthread[ET_DNS][0])->schedule_imm(dnsH);
+  dnsH->thread->schedule_imm(dnsH);
 
   /* -----------------------------------------------------
      Process any modifiers to the directive, if they exist
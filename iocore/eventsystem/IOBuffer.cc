@@ -39,6 +39,10 @@ int64_t default_large_iobuffer_size = DEFAULT_LARGE_BUFFER_SIZE;
 int64_t default_small_iobuffer_size = DEFAULT_SMALL_BUFFER_SIZE;
 int64_t max_iobuffer_size = DEFAULT_BUFFER_SIZES - 1;
 
+// Inaccessible address range the blocks of an IOBufferFileData point into.
+static const int64_t FILE_RANGE_AREA_SIZE = (int64_t)1 << 30;
+static char *file_range_area = NULL;
+
 //
 // Initialization
 //
@@ -63,6 +67,25 @@ init_buffer_allocators()
     snprintf(name, 64, "ioBufAllocator[%d]", i);
     ioBufAllocator[i].re_init(name, s, n, a, advice);
   }
+
+  void *area = mmap(NULL, FILE_RANGE_AREA_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (area != MAP_FAILED) {
+    file_range_area = (char *)area;
+  }
+}
+
+IOBufferFileData::IOBufferFileData(int fd, int64_t offset, int64_t size) : _fd(fd), _file_offset(offset)
+{
+  ink_release_assert(file_range_area && size <= FILE_RANGE_AREA_SIZE);
+  _size_index = BUFFER_SIZE_INDEX_FOR_CONSTANT_SIZE(size);
+  _mem_type = FILE_RANGE;
+  _data = file_range_area;
+}
+
+void
+IOBufferFileData::free()
+{
+  delete this;
 }
 
 int64_t
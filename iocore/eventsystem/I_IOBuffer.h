@@ -66,6 +66,7 @@ enum AllocType {
   MEMALIGNED,
   DEFAULT_ALLOC,
   CONSTANT,
+  FILE_RANGE,
 };
 
 #define DEFAULT_BUFFER_NUMBER 128
@@ -163,6 +164,10 @@ void init_buffer_allocators();
       <td>CONSTANT</td>
       <td></td>
     </tr>
+    <tr>
+      <td>FILE_RANGE</td>
+      <td>IOBufferFileData, the data is in a file</td>
+    </tr>
   </table>
 
  */
@@ -273,6 +278,52 @@ private:
 
 inkcoreapi extern ClassAllocator<IOBufferData> ioDataAllocator;
 
+/**
+  A range of a file standing in for memory, so that it can be written
+  to a socket with sendfile() instead of being read into a buffer first.
+
+  The blocks referring to it span a reserved range of inaccessible
+  addresses: the usual buffer accounting works on them, but the data
+  must never be touched. Such blocks may only be appended to a buffer
+  whose reader is written to a NetVConnection which is sendfile
+  capable, see NetVConnection::is_sendfile_capable().
+
+*/
+class IOBufferFileData : public IOBufferData
+{
+public:
+  IOBufferFileData(int fd, int64_t offset, int64_t size);
+  virtual ~IOBufferFileData() {}
+
+  /**
+    Checks that the file still holds the data. Called right before the
+    data is sent; the connection is aborted if it returns false.
+
+  */
+  virtual bool
+  is_valid()
+  {
+    return true;
+  }
+
+  /// Offset in the file of the byte at @a p, a pointer into a block referring to this.
+  int64_t
+  file_offset(const char *p) const
+  {
+    return _file_offset + (p - _data);
+  }
+
+  virtual void free();
+
+  int _fd;
+  int64_t _file_offset;
+
+private:
+  // declaration only
+  IOBufferFileData(const IOBufferFileData &);
+  IOBufferFileData &operator=(const IOBufferFileData &);
+};
+
 /**
   A linkable portion of IOBufferData. IOBufferBlock is a chainable
   buffer block descriptor. The IOBufferBlock represents both the used
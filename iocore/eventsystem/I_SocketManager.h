@@ -70,6 +70,9 @@ struct SocketManager {
   int64_t writev(int fd, struct iovec *vector, size_t count);
   int64_t write_vector(int fd, struct iovec *vector, size_t count, void *pOLP = 0);
   int64_t pwrite(int fd, void *buf, int len, off_t offset, char *tag = NULL);
+#ifdef HAVE_SYS_SENDFILE_H
+  int64_t sendfile(int fd, int in_fd, off_t offset, size_t count);
+#endif
 
   int send(int fd, void *buf, int len, int flags);
   int sendto(int fd, void *buf, int len, int flags, struct sockaddr const *to, int tolen);
@@ -230,6 +230,20 @@ SocketManager::writev(int fd, struct iovec *vector, size_t count)
   return r;
 }
 
+#ifdef HAVE_SYS_SENDFILE_H
+TS_INLINE int64_t
+SocketManager::sendfile(int fd, int in_fd, off_t offset, size_t count)
+{
+  int64_t r;
+  do {
+    if (likely((r = ::sendfile(fd, in_fd, &offset, count)) >= 0))
+      break;
+    r = -errno;
+  } while (transient_error());
+  return r;
+}
+#endif
+
 TS_INLINE int64_t
 SocketManager::write_vector(int fd, struct iovec *vector, size_t count, void *pOLP)
 {
@@ -64,9 +64,49 @@ char hostdb_hostfile_path[PATH_NAME_MAX] = "";
 int hostdb_sync_frequency = 120;
 int hostdb_srv_enabled = 0;
 int hostdb_disable_reverse_lookup = 0;
+int hostdb_prefetch_entries = 0;
+int hostdb_prefetch_lead_time = 5;
+int hostdb_prefetch_rate = 10;
+int hostdb_backend = HOSTDB_BACKEND_MULTICACHE;
 
 ClassAllocator<HostDBContinuation> hostDBContAllocator("hostDBContAllocator");
 
+//
+// Prefetch of the popular names.
+// The lookups by name are counted in a table of hostdb_prefetch_entries slots, where
+// a name keeps its slot against the others hashed there as long as it is hit more
+// often, so that the table holds about the most popular names. Once a second the
+// names whose record is about to expire are looked up again, the most popular ones
+// first, at most hostdb_prefetch_rate of them.
+//
+#define HOSTDB_PREFETCH_DECAY_INTERVAL 60 // seconds between the halvings of the hits
+#define HOSTDB_PREFETCH_MAX_ENTRIES 65536 // the table is scanned every second
+
+struct HostDBPrefetchEntry {
+  uint64_t folded_md5;
+  unsigned int expires; ///< hostdb_current_interval when the record times out.
+  unsigned int hits;
+  bool refreshed; ///< The name was looked up again since it was last hit.
+  HostDBMark db_mark;
+  in_port_t port;
+  char *name; ///< Copied when the name takes the slot, so that the scans stay small.
+};
+
+struct HostDBPrefetcher : public Continuation {
+  HostDBPrefetchEntry *entries;
+  int n_entries;
+  int *due;
+  int ticks;
+
+  int mainEvent(int event, Event *e);
+  void record(ProxyMutex *bucket_mutex, HostDBMD5 const &md5, HostDBInfo *r);
+  void expired(ProxyMutex *bucket_mutex, HostDBMD5 const &md5);
+
+  HostDBPrefetcher(int n);
+};
+
+static HostDBPrefetcher *hostdb_prefetcher = NULL;
+
 // Static configuration information
 
 HostDBCache hostDB;
@@ -232,7 +272,7 @@ HostDBMD5::~HostDBMD5()
     SplitDNSConfig::release(pSD);
 }
 
-HostDBCache::HostDBCache()
+HostDBCache::HostDBCache() : map(NULL)
 {
   tag_bits = HOST_DB_TAG_BITS;
   max_hits = (1 << HOST_DB_HITS_BITS) - 1;
@@ -252,7 +292,7 @@ HostDBCache::rebuild_callout(HostDBInfo *e, RebuildMC &r)
     if (e->data.hostname_offset > 0) {
       if (!valid_offset(e->data.hostname_offset - 1))
         return corrupt_debugging_callout(e, r);
-      char *p = (char *)ptr(&e->data.hostname_offset, r.partition);
+      char *p = (char *)ptr(e, &e->data.hostname_offset, r.partition);
       if (!p)
         return corrupt_debugging_callout(e, r);
       char *s = p;
@@ -270,7 +310,7 @@ HostDBCache::rebuild_callout(HostDBInfo *e, RebuildMC &r)
       return 0;
     if (!valid_offset(e->app.rr.offset - 1))
       return corrupt_debugging_callout(e, r);
-    HostDBRoundRobin *rr = (HostDBRoundRobin *)ptr(&e->app.rr.offset, r.partition);
+    HostDBRoundRobin *rr = (HostDBRoundRobin *)ptr(e, &e->app.rr.offset, r.partition);
     if (!rr)
       return corrupt_debugging_callout(e, r);
     if (rr->rrcount > HOST_DB_MAX_ROUND_ROBIN_INFO || rr->rrcount <= 0 || rr->good > HOST_DB_MAX_ROUND_ROBIN_INFO ||
@@ -430,6 +470,7 @@ HostDBCache::start(int flags)
   REC_ReadConfigInt32(hostdb_srv_enabled, "proxy.config.srv_enabled");
   REC_ReadConfigString(storage_path, "proxy.config.hostdb.storage_path", sizeof(storage_path));
   REC_ReadConfigInt32(storage_size, "proxy.config.hostdb.storage_size");
+  REC_ReadConfigInt32(hostdb_backend, "proxy.config.hostdb.backend");
 
   // If proxy.config.hostdb.storage_path is not set, use the local state dir. If it is set to
   // a relative path, make it relative to the prefix.
@@ -447,6 +488,19 @@ HostDBCache::start(int flags)
     Warning("Please set 'proxy.config.hostdb.storage_path' or 'proxy.config.local_state_dir'");
   }
 
+  // The map grows as needed, a stripe per partition, each guarded by the lock of the partition.
+  if (hostdb_backend == HOSTDB_BACKEND_MAP) {
+    char map_path[PATH_NAME_MAX];
+    buckets = MULTI_CACHE_PARTITIONS;
+    buckets_per_partitionF8 = 256;
+    if (!map)
+      map = new HostDBMap;
+    snprintf(map_path, sizeof(map_path), "%s/%s.map", storage_path, hostdb_filename);
+    Debug("hostdb", "Loading %s", map_path);
+    totalelements = map->load(map_path);
+    return 0;
+  }
+
   hostDBStore = new Store;
   hostDBSpan = new Span;
   hostDBSpan->init(storage_path, storage_size);
@@ -520,6 +574,9 @@ HostDBProcessor::start(int, size_t)
   REC_EstablishStaticConfigInt32U(hostdb_serve_stale_but_revalidate, "proxy.config.hostdb.serve_stale_for");
   REC_EstablishStaticConfigInt32(hostdb_sync_frequency, "proxy.config.cache.hostdb.sync_frequency");
   REC_EstablishStaticConfigInt32U(hostdb_hostfile_check_interval, "proxy.config.hostdb.host_file.interval");
+  REC_EstablishStaticConfigInt32(hostdb_prefetch_entries, "proxy.config.hostdb.prefetch.entries");
+  REC_EstablishStaticConfigInt32(hostdb_prefetch_lead_time, "proxy.config.hostdb.prefetch.lead_time");
+  REC_EstablishStaticConfigInt32(hostdb_prefetch_rate, "proxy.config.hostdb.prefetch.rate");
 
   //
   // Set up hostdb_current_interval
@@ -531,6 +588,20 @@ HostDBProcessor::start(int, size_t)
   b->mutex = new_ProxyMutex();
   eventProcessor.schedule_every(b, HOST_DB_TIMEOUT_INTERVAL, ET_DNS);
 
+  //
+  // Free the records removed from the map and drop the timed out ones.
+  //
+  if (hostDB.map)
+    hostDB.map->start_sweep();
+
+  //
+  // Refresh the popular names before they expire, if we've asked for it.
+  //
+  if (hostdb_prefetch_entries > 0) {
+    hostdb_prefetcher = new HostDBPrefetcher(MIN(hostdb_prefetch_entries, HOSTDB_PREFETCH_MAX_ENTRIES));
+    eventProcessor.schedule_every(hostdb_prefetcher, HOST_DB_TIMEOUT_INTERVAL, ET_DNS);
+  }
+
   //
   // Sync HostDB, if we've asked for it.
   //
@@ -656,6 +727,111 @@ db_mark_for(IpAddr const &ip)
   return ip.isIp6() ? HOSTDB_MARK_IPV6 : HOSTDB_MARK_IPV4;
 }
 
+HostDBPrefetcher::HostDBPrefetcher(int n) : Continuation(new_ProxyMutex()), n_entries(n), ticks(0)
+{
+  entries = (HostDBPrefetchEntry *)ats_calloc(n_entries, sizeof(HostDBPrefetchEntry));
+  due = (int *)ats_malloc(n_entries * sizeof(int));
+  SET_HANDLER(&HostDBPrefetcher::mainEvent);
+}
+
+// A hit on @a r, the counts are only sampled while the table is busy.
+void
+HostDBPrefetcher::record(ProxyMutex *bucket_mutex, HostDBMD5 const &md5, HostDBInfo *r)
+{
+  if (!md5.host_len || md5.host_len > MAXDNAME || r->reverse_dns || r->is_srv || r->failed() || !r->ip_timeout_interval)
+    return;
+  MUTEX_TRY_LOCK(lock, mutex, bucket_mutex->thread_holding);
+  if (!lock.is_locked())
+    return;
+  uint64_t folded_md5 = fold_md5(md5.hash);
+  HostDBPrefetchEntry *p = &entries[folded_md5 % n_entries];
+  if (p->folded_md5 != folded_md5) {
+    if (p->hits && --p->hits)
+      return;
+    if (is_dotted_form_hostname(md5.host_name))
+      return;
+    p->folded_md5 = folded_md5;
+    p->refreshed = false;
+    p->db_mark = md5.db_mark;
+    p->port = md5.port;
+    ats_free(p->name);
+    p->name = ats_strndup(md5.host_name, md5.host_len);
+  } else if (p->refreshed) {
+    RecIncrRawStatSum(hostdb_rsb, bucket_mutex->thread_holding, (int)hostdb_prefetch_hits_stat, 1);
+    p->refreshed = false;
+  }
+  if (p->hits < UINT_MAX)
+    p->hits++;
+  p->expires = r->ip_timestamp + r->ip_timeout_interval;
+}
+
+// The record of @a md5 timed out before it was hit.
+void
+HostDBPrefetcher::expired(ProxyMutex *bucket_mutex, HostDBMD5 const &md5)
+{
+  MUTEX_TRY_LOCK(lock, mutex, bucket_mutex->thread_holding);
+  if (!lock.is_locked())
+    return;
+  HostDBPrefetchEntry *p = &entries[fold_md5(md5.hash) % n_entries];
+  if (p->folded_md5 == fold_md5(md5.hash) && p->hits) {
+    RecIncrRawStatSum(hostdb_rsb, bucket_mutex->thread_holding, (int)hostdb_prefetch_misses_stat, 1);
+    p->refreshed = false;
+  }
+}
+
+struct HostDBPrefetchMoreHits {
+  HostDBPrefetchEntry *entries;
+  bool
+  operator()(int a, int b) const
+  {
+    return entries[a].hits > entries[b].hits;
+  }
+};
+
+int
+HostDBPrefetcher::mainEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  bool decay = ++ticks * (HOST_DB_TIMEOUT_INTERVAL / HRTIME_SECOND) >= HOSTDB_PREFETCH_DECAY_INTERVAL;
+  int rate = MAX(hostdb_prefetch_rate, 0); // reloadable, read it once
+  int ndue = 0;
+
+  if (decay)
+    ticks = 0;
+  for (int i = 0; i < n_entries; i++) {
+    HostDBPrefetchEntry *p = &entries[i];
+    if (decay)
+      p->hits >>= 1;
+    if (p->hits && !p->refreshed && static_cast<int>(p->expires - hostdb_current_interval) <= hostdb_prefetch_lead_time)
+      due[ndue++] = i;
+  }
+  if (ndue > rate) {
+    HostDBPrefetchMoreHits more_hits = {entries};
+    std::partial_sort(due, due + rate, due + ndue, more_hits);
+    ndue = rate;
+  }
+  for (int i = 0; i < ndue; i++) {
+    HostDBPrefetchEntry *p = &entries[due[i]];
+    HostDBMD5 md5;
+    HostDBContinuation::Options copt;
+    HostDBContinuation *c = hostDBContAllocator.alloc();
+
+    Debug("hostdb", "prefetch %s, %u hits, expires in %d", p->name, p->hits,
+          static_cast<int>(p->expires - hostdb_current_interval));
+    md5.set_host(p->name, strlen(p->name));
+    md5.port = p->port;
+    md5.db_mark = p->db_mark;
+    md5.refresh();
+    copt.host_res_style = host_res_style_for(p->db_mark);
+    c->init(md5, copt);
+    c->force_dns = true;
+    SET_CONTINUATION_HANDLER(c, (HostDBContHandler)&HostDBContinuation::probeEvent);
+    eventProcessor.schedule_imm(c, ET_DNS);
+    p->refreshed = true;
+    HOSTDB_INCREMENT_DYN_STAT(hostdb_prefetch_refreshes_stat);
+  }
+  return EVENT_CONT;
+}
+
 HostDBInfo *
 probe(ProxyMutex *mutex, HostDBMD5 const &md5, bool ignore_timeout)
 {
@@ -680,6 +856,8 @@ probe(ProxyMutex *mutex, HostDBMD5 const &md5, bool ignore_timeout)
       } else if (!ignore_timeout && r->is_ip_timeout() && !r->serve_stale_but_revalidate()) {
         Debug("hostdb", "timeout %u %u %u", r->ip_interval(), r->ip_timestamp, r->ip_timeout_interval);
         HOSTDB_INCREMENT_DYN_STAT(hostdb_ttl_expires_stat);
+        if (hostdb_prefetcher)
+          hostdb_prefetcher->expired(mutex, md5);
         return NULL;
       }
       // error conditions
@@ -712,6 +890,8 @@ probe(ProxyMutex *mutex, HostDBMD5 const &md5, bool ignore_timeout)
       r->hits++;
       if (!r->hits)
         r->hits--;
+      if (hostdb_prefetcher && !ignore_timeout)
+        hostdb_prefetcher->record(mutex, md5, r);
       return r;
     }
   }
@@ -1289,7 +1469,7 @@ HostDBContinuation::lookup_done(IpAddr const &ip, char const *aname, bool around
     } else {
       Debug("hostdb", "done '%s' TTL %d", aname, ttl_seconds);
       const size_t s_size = strlen(aname) + 1;
-      void *s = hostDB.alloc(&i->data.hostname_offset, s_size);
+      void *s = hostDB.alloc(i, &i->data.hostname_offset, s_size);
       if (s) {
         ink_strlcpy((char *)s, aname, s_size);
         i->round_robin = false;
@@ -1472,7 +1652,7 @@ HostDBContinuation::dnsEvent(int event, HostEnt *e)
 
     if (rr) {
       const int rrsize = HostDBRoundRobin::size(n, e->srv_hosts.srv_hosts_length);
-      HostDBRoundRobin *rr_data = (HostDBRoundRobin *)hostDB.alloc(&r->app.rr.offset, rrsize);
+      HostDBRoundRobin *rr_data = (HostDBRoundRobin *)hostDB.alloc(r, &r->app.rr.offset, rrsize);
 
       Debug("hostdb", "allocating %d bytes for %d RR at %p %d", rrsize, n, rr_data, r->app.rr.offset);
 
@@ -2189,7 +2369,7 @@ HostDBInfo::hostname()
   if (!reverse_dns)
     return NULL;
 
-  return (char *)hostDB.ptr(&data.hostname_offset, hostDB.ptr_to_partition((char *)this));
+  return (char *)hostDB.ptr(this, &data.hostname_offset, hostDB.ptr_to_partition((char *)this));
 }
 
 
@@ -2199,7 +2379,7 @@ HostDBInfo::rr()
   if (!round_robin)
     return NULL;
 
-  HostDBRoundRobin *r = (HostDBRoundRobin *)hostDB.ptr(&app.rr.offset, hostDB.ptr_to_partition((char *)this));
+  HostDBRoundRobin *r = (HostDBRoundRobin *)hostDB.ptr(this, &app.rr.offset, hostDB.ptr_to_partition((char *)this));
 
   if (r &&
       (r->rrcount > HOST_DB_MAX_ROUND_ROBIN_INFO || r->rrcount <= 0 || r->good > HOST_DB_MAX_ROUND_ROBIN_INFO || r->good <= 0)) {
@@ -2501,6 +2681,15 @@ ink_hostdb_init(ModuleVersion v)
   RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.re_dns_on_reload", RECD_INT, RECP_PERSISTENT,
                      (int)hostdb_re_dns_on_reload_stat, RecRawStatSyncSum);
 
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.prefetch.refreshes", RECD_INT, RECP_PERSISTENT,
+                     (int)hostdb_prefetch_refreshes_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.prefetch.hits", RECD_INT, RECP_PERSISTENT,
+                     (int)hostdb_prefetch_hits_stat, RecRawStatSyncSum);
+
+  RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.prefetch.misses", RECD_INT, RECP_PERSISTENT,
+                     (int)hostdb_prefetch_misses_stat, RecRawStatSyncSum);
+
   RecRegisterRawStat(hostdb_rsb, RECT_PROCESS, "proxy.process.hostdb.bytes", RECD_INT, RECP_PERSISTENT, (int)hostdb_bytes_stat,
                      RecRawStatSyncCount);
 
@@ -2646,7 +2835,7 @@ HostDBFileContinuation::insertEvent(int, void *)
   if (k > 1) {
     // multiple entries, need round robin
     int s = HostDBRoundRobin::size(k, false);
-    HostDBRoundRobin *rr_data = static_cast<HostDBRoundRobin *>(hostDB.alloc(&r->app.rr.offset, s));
+    HostDBRoundRobin *rr_data = static_cast<HostDBRoundRobin *>(hostDB.alloc(r, &r->app.rr.offset, s));
     if (rr_data) {
       int dst = 0; // index of destination RR item.
       for (int src = idx; src < last; ++src, ++dst) {
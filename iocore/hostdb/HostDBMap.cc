@@ -0,0 +1,579 @@
+/** @file
+
+  HostDB storage in a lock-striped hash map.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "libts.h"
+#include "P_HostDB.h"
+#include <sys/mman.h>
+
+#define HOSTDB_MAP_MAGIC_NUMBER 0x484D4150
+
+struct HostDBMapFileHeader {
+  unsigned int magic;
+  VersionNumber version;
+  int records;
+};
+
+struct HostDBMapFileRecord {
+  uint64_t folded_md5;
+  HostDBInfo info;
+  int heap_size; // followed by the heap data
+};
+
+HostDBMap::HostDBMap()
+{
+  memset(stripes, 0, sizeof(stripes));
+  for (int i = 0; i < MULTI_CACHE_PARTITIONS; i++) {
+    stripes[i].n_buckets = HOSTDB_MAP_INITIAL_BUCKETS;
+    stripes[i].buckets = (HostDBMapEntry **)ats_calloc(HOSTDB_MAP_INITIAL_BUCKETS, sizeof(HostDBMapEntry *));
+  }
+  path[0] = 0;
+  synced = false;
+}
+
+HostDBMap::~HostDBMap()
+{
+  clear();
+  for (int i = 0; i < MULTI_CACHE_PARTITIONS; i++) {
+    HostDBMapHeap &h = stripes[i].heap;
+    for (int c = 0; c < HOSTDB_MAP_HEAP_CHUNKS; c++)
+      ats_free(h.chunks[c]);
+    ats_free(h.free_ids);
+    ats_free(stripes[i].buckets);
+  }
+}
+
+HostDBInfo *
+HostDBMap::lookup(uint64_t folded_md5)
+{
+  HostDBMapStripe &s = stripe_of(folded_md5);
+
+  for (HostDBMapEntry *e = bucket_of(s, folded_md5); e; e = e->next)
+    if (e->folded_md5 == folded_md5)
+      return &e->info;
+  return NULL;
+}
+
+HostDBInfo *
+HostDBMap::insert(uint64_t folded_md5)
+{
+  HostDBMapStripe &s = stripe_of(folded_md5);
+  HostDBMapEntry **pe = &bucket_of(s, folded_md5);
+
+  for (; *pe; pe = &(*pe)->next) {
+    if ((*pe)->folded_md5 == folded_md5) {
+      HostDBMapEntry *old = *pe;
+      *pe = old->next;
+      s.count--;
+      retire(s, old);
+      break;
+    }
+  }
+  if (s.count >= 2 * s.n_buckets)
+    grow(s);
+
+  HostDBMapEntry *e = (HostDBMapEntry *)ats_calloc(1, sizeof(HostDBMapEntry));
+  e->folded_md5 = folded_md5;
+  e->info.reset();
+  e->info.set_full(folded_md5, MULTI_CACHE_PARTITIONS);
+  HostDBMapEntry *&b = bucket_of(s, folded_md5);
+  e->next = b;
+  b = e;
+  s.count++;
+  return &e->info;
+}
+
+void
+HostDBMap::remove(HostDBInfo *r)
+{
+  HostDBMapEntry *e = (HostDBMapEntry *)r;
+  HostDBMapStripe &s = stripe_of(e->folded_md5);
+
+  // a record already removed is only marked empty again
+  for (HostDBMapEntry **pe = &bucket_of(s, e->folded_md5); *pe; pe = &(*pe)->next) {
+    if (*pe == e) {
+      *pe = e->next;
+      s.count--;
+      retire(s, e);
+      return;
+    }
+  }
+  r->set_empty();
+}
+
+void
+HostDBMap::retire(HostDBMapStripe &s, HostDBMapEntry *e)
+{
+  e->info.set_empty();
+  e->next = s.retired;
+  s.retired = e;
+}
+
+void
+HostDBMap::grow(HostDBMapStripe &s)
+{
+  int n = s.n_buckets * 2;
+  HostDBMapEntry **buckets = (HostDBMapEntry **)ats_calloc(n, sizeof(HostDBMapEntry *));
+
+  for (int i = 0; i < s.n_buckets; i++) {
+    HostDBMapEntry *next = NULL;
+    for (HostDBMapEntry *e = s.buckets[i]; e; e = next) {
+      next = e->next;
+      HostDBMapEntry *&b = buckets[(e->folded_md5 / MULTI_CACHE_PARTITIONS) & (n - 1)];
+      e->next = b;
+      b = e;
+    }
+  }
+  ats_free(s.buckets);
+  s.buckets = buckets;
+  s.n_buckets = n;
+  Debug("hostdb", "map stripe %d grown to %d buckets", (int)(&s - stripes), n);
+}
+
+void *
+HostDBMap::alloc(HostDBInfo *r, int *poffset, int size)
+{
+  HostDBMapEntry *e = (HostDBMapEntry *)r;
+  int stripe = e->folded_md5 % MULTI_CACHE_PARTITIONS;
+  HostDBMapStripe &s = stripes[stripe];
+  HostDBMapHeap &h = s.heap;
+  int local;
+
+  *poffset = 0;
+  if (e->heap_id) {
+    free_heap(s, e->heap_id);
+    e->heap_id = 0;
+    e->heap_size = 0;
+  }
+  if (h.n_free) {
+    local = h.free_ids[--h.n_free];
+  } else {
+    local = h.n_ids;
+    int c = local >> HOSTDB_MAP_HEAP_CHUNK_BITS;
+    if (c >= HOSTDB_MAP_HEAP_CHUNKS)
+      return NULL;
+    if (!h.chunks[c])
+      h.chunks[c] = (HostDBMapHeapBlock **)ats_calloc(HOSTDB_MAP_HEAP_CHUNK, sizeof(HostDBMapHeapBlock *));
+    h.n_ids++;
+  }
+  HostDBMapHeapBlock *b = (HostDBMapHeapBlock *)ats_malloc(sizeof(HostDBMapHeapBlock) + size);
+  b->tag = e->info.tag();
+  b->next = NULL;
+  e->heap_id = local * MULTI_CACHE_PARTITIONS + stripe + 1;
+  e->heap_size = size;
+  heap_slot(h, e->heap_id) = b;
+  *poffset = e->heap_id;
+  return b + 1;
+}
+
+HostDBMapHeapBlock *&
+HostDBMap::heap_slot(HostDBMapHeap &h, int id)
+{
+  int local = (id - 1) / MULTI_CACHE_PARTITIONS;
+  return h.chunks[local >> HOSTDB_MAP_HEAP_CHUNK_BITS][local & (HOSTDB_MAP_HEAP_CHUNK - 1)];
+}
+
+void *
+HostDBMap::ptr(HostDBInfo *r, int id)
+{
+  if (id <= 0)
+    return NULL;
+  HostDBMapHeap &h = stripes[(id - 1) % MULTI_CACHE_PARTITIONS].heap;
+  int c = ((id - 1) / MULTI_CACHE_PARTITIONS) >> HOSTDB_MAP_HEAP_CHUNK_BITS;
+  if (c >= HOSTDB_MAP_HEAP_CHUNKS || !h.chunks[c])
+    return NULL;
+  HostDBMapHeapBlock *b = heap_slot(h, id);
+  // a copy of a record replaced since may hold an id handed out again
+  if (!b || b->tag != r->tag())
+    return NULL;
+  return b + 1;
+}
+
+void
+HostDBMap::free_heap(HostDBMapStripe &s, int id)
+{
+  HostDBMapHeap &h = s.heap;
+  int local = (id - 1) / MULTI_CACHE_PARTITIONS;
+  HostDBMapHeapBlock *&b = heap_slot(h, id);
+
+  // released by the second sweep from now, like the records
+  b->next = h.retired;
+  h.retired = b;
+  b = NULL;
+  if (h.n_free >= h.max_free) {
+    h.max_free = h.max_free ? h.max_free * 2 : HOSTDB_MAP_HEAP_CHUNK;
+    h.free_ids = (int *)ats_realloc(h.free_ids, h.max_free * sizeof(int));
+  }
+  h.free_ids[h.n_free++] = local;
+}
+
+void
+HostDBMap::free_entry(HostDBMapStripe &s, HostDBMapEntry *e)
+{
+  if (e->heap_id)
+    free_heap(s, e->heap_id);
+  ats_free(e);
+}
+
+int
+HostDBMap::count()
+{
+  int n = 0;
+
+  for (int i = 0; i < MULTI_CACHE_PARTITIONS; i++)
+    n += stripes[i].count;
+  return n;
+}
+
+void
+HostDBMap::clear()
+{
+  for (int i = 0; i < MULTI_CACHE_PARTITIONS; i++) {
+    HostDBMapStripe &s = stripes[i];
+    for (int b = 0; b < s.n_buckets; b++) {
+      while (HostDBMapEntry *e = s.buckets[b]) {
+        s.buckets[b] = e->next;
+        retire(s, e);
+      }
+    }
+    s.count = 0;
+    // the records, then their heap blocks
+    sweep(i);
+    sweep(i);
+    sweep(i);
+  }
+}
+
+void
+HostDBMap::sweep(int stripe)
+{
+  HostDBMapStripe &s = stripes[stripe];
+  HostDBMapEntry *e = NULL, *next = NULL;
+
+  for (e = s.retiring; e; e = next) {
+    next = e->next;
+    free_entry(s, e);
+  }
+  s.retiring = s.retired;
+  s.retired = NULL;
+
+  HostDBMapHeapBlock *b = NULL, *bnext = NULL;
+  for (b = s.heap.retiring; b; b = bnext) {
+    bnext = b->next;
+    ats_free(b);
+  }
+  s.heap.retiring = s.heap.retired;
+  s.heap.retired = NULL;
+
+  for (int i = 0; i < HOSTDB_MAP_SWEEP_BUCKETS && i < s.n_buckets; i++) {
+    HostDBMapEntry **pe = &s.buckets[s.sweep_cursor];
+    while ((e = *pe)) {
+      HostDBInfo &r = e->info;
+      if (r.failed() ? r.is_ip_fail_timeout() : (r.is_ip_timeout() && !r.serve_stale_but_revalidate())) {
+        *pe = e->next;
+        s.count--;
+        retire(s, e);
+      } else {
+        pe = &e->next;
+      }
+    }
+    s.sweep_cursor = (s.sweep_cursor + 1) & (s.n_buckets - 1);
+  }
+}
+
+//
+// Sweep a stripe at a time, all of them every HOST_DB_TIMEOUT_INTERVAL.
+//
+struct HostDBMapSweeper : public Continuation {
+  HostDBMap *map;
+  int stripe;
+
+  int
+  sweepEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    map->sweep(stripe);
+    if (++stripe >= MULTI_CACHE_PARTITIONS) {
+      stripe = 0;
+      HOSTDB_SET_DYN_COUNT(hostdb_total_entries_stat, map->count());
+    }
+    // a new event, the one running holds the lock of the last stripe
+    mutex = hostDB.locks[stripe];
+    eventProcessor.schedule_in(this, HOST_DB_TIMEOUT_INTERVAL / MULTI_CACHE_PARTITIONS, ET_DNS);
+    return EVENT_DONE;
+  }
+
+  HostDBMapSweeper(HostDBMap *m) : Continuation(hostDB.locks[0]), map(m), stripe(0)
+  {
+    SET_HANDLER(&HostDBMapSweeper::sweepEvent);
+  }
+};
+
+void
+HostDBMap::start_sweep()
+{
+  eventProcessor.schedule_in(new HostDBMapSweeper(this), HOST_DB_TIMEOUT_INTERVAL / MULTI_CACHE_PARTITIONS, ET_DNS);
+}
+
+//
+// Persistence
+//
+
+int
+HostDBMap::save_stripe(int stripe, char *&buf, int &len, int &size)
+{
+  HostDBMapStripe &s = stripes[stripe];
+  int n = 0;
+
+  for (int b = 0; b < s.n_buckets; b++) {
+    for (HostDBMapEntry *e = s.buckets[b]; e; e = e->next) {
+      HostDBMapFileRecord rec;
+      char *heap = e->heap_id ? (char *)ptr(&e->info, e->heap_id) : NULL;
+      rec.folded_md5 = e->folded_md5;
+      rec.info = e->info;
+      rec.heap_size = heap ? e->heap_size : 0;
+      int need = sizeof(rec) + rec.heap_size;
+      if (len + need > size) {
+        size = MAX(size * 2, len + need);
+        buf = (char *)ats_realloc(buf, size);
+      }
+      memcpy(buf + len, &rec, sizeof(rec));
+      if (heap)
+        memcpy(buf + len + sizeof(rec), heap, rec.heap_size);
+      len += need;
+      n++;
+    }
+  }
+  return n;
+}
+
+struct HostDBMapSync;
+typedef int (HostDBMapSync::*HostDBMapSyncHandler)(int, void *);
+
+//
+// Copy out the stripes one at a time under their lock, then write the
+// file out of the lock of the caller.
+//
+struct HostDBMapSync : public Continuation {
+  HostDBMap *map;
+  Continuation *cont;
+  int stripe;
+  int records;
+  char *buf;
+  int len;
+  int size;
+
+  int
+  stripeEvent(int /* event ATS_UNUSED */, void * /* e ATS_UNUSED */)
+  {
+    records += map->save_stripe(stripe, buf, len, size);
+    if (++stripe < MULTI_CACHE_PARTITIONS) {
+      mutex = hostDB.locks[stripe];
+      eventProcessor.schedule_imm(this, ET_CALL);
+    } else {
+      // the write and the fsync block, keep them off the net threads
+      mutex = new_ProxyMutex();
+      SET_HANDLER((HostDBMapSyncHandler)&HostDBMapSync::writeEvent);
+      eventProcessor.schedule_imm(this, ET_TASK);
+    }
+    return EVENT_DONE;
+  }
+
+  int
+  writeEvent(int /* event ATS_UNUSED */, void * /* e ATS_UNUSED */)
+  {
+    char tmp[PATH_NAME_MAX];
+    HostDBMapFileHeader *h = (HostDBMapFileHeader *)buf;
+    int fd = -1;
+
+    h->records = records;
+    snprintf(tmp, sizeof(tmp), "%s.tmp", map->path);
+    if ((fd = ::open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+      Warning("unable to open '%s' for the host database: %s", tmp, strerror(errno));
+    } else {
+      int done = 0;
+      while (done < len) {
+        int w = ::write(fd, buf + done, len - done);
+        if (w < 0 && errno == EINTR)
+          continue;
+        if (w <= 0)
+          break;
+        done += w;
+      }
+      if (done < len || fsync(fd) < 0 || ::close(fd) < 0 || rename(tmp, map->path) < 0) {
+        Warning("unable to write the host database to '%s': %s", map->path, strerror(errno));
+        if (done < len)
+          ::close(fd);
+        unlink(tmp);
+      } else {
+        Debug("hostdb", "saved %d records, %d bytes to %s", records, len, map->path);
+      }
+    }
+    mutex = cont->mutex;
+    SET_HANDLER((HostDBMapSyncHandler)&HostDBMapSync::doneEvent);
+    eventProcessor.schedule_imm(this, ET_CALL);
+    return EVENT_DONE;
+  }
+
+  int
+  doneEvent(int /* event ATS_UNUSED */, void * /* e ATS_UNUSED */)
+  {
+    cont->handleEvent(MULTI_CACHE_EVENT_SYNC, 0);
+    delete this;
+    return EVENT_DONE;
+  }
+
+  HostDBMapSync(Continuation *acont, HostDBMap *m)
+    : Continuation(hostDB.locks[0]), map(m), cont(acont), stripe(0), records(0), len(sizeof(HostDBMapFileHeader)),
+      size(1 << 20)
+  {
+    HostDBMapFileHeader h;
+    h.magic = HOSTDB_MAP_MAGIC_NUMBER;
+    h.version.ink_major = HOST_DB_CACHE_MAJOR_VERSION;
+    h.version.ink_minor = HOST_DB_CACHE_MINOR_VERSION;
+    h.records = 0;
+    buf = (char *)ats_malloc(size);
+    memcpy(buf, &h, sizeof(h));
+    SET_HANDLER((HostDBMapSyncHandler)&HostDBMapSync::stripeEvent);
+  }
+
+  ~HostDBMapSync() { ats_free(buf); }
+};
+
+void
+HostDBMap::sync(Continuation *cont)
+{
+  if (!path[0])
+    return;
+  // the file was just loaded, and the task threads may not be running yet
+  if (!synced) {
+    synced = true;
+    eventProcessor.schedule_imm(cont, ET_CALL, MULTI_CACHE_EVENT_SYNC);
+    return;
+  }
+  eventProcessor.schedule_imm(new HostDBMapSync(cont, this), ET_CALL);
+}
+
+// Load the records saved by sync(), before the processor starts.
+int
+HostDBMap::load(const char *filename)
+{
+  struct stat st;
+  int n = 0;
+
+  ink_strlcpy(path, filename, sizeof(path));
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    return 0;
+  if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(HostDBMapFileHeader)) {
+    ::close(fd);
+    return 0;
+  }
+  char *data = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    Warning("unable to map the host database '%s': %s", path, strerror(errno));
+    return 0;
+  }
+
+  HostDBMapFileHeader h;
+  memcpy(&h, data, sizeof(h));
+  if (h.magic != HOSTDB_MAP_MAGIC_NUMBER || h.version.ink_major != HOST_DB_CACHE_MAJOR_VERSION ||
+      h.version.ink_minor != HOST_DB_CACHE_MINOR_VERSION) {
+    Note("host database '%s' is of another version, starting empty", path);
+  } else {
+    char *p = data + sizeof(h), *end = data + st.st_size;
+    for (int i = 0; i < h.records && end - p >= (ptrdiff_t)sizeof(HostDBMapFileRecord); i++) {
+      HostDBMapFileRecord rec;
+      memcpy(&rec, p, sizeof(rec));
+      p += sizeof(rec);
+      if (rec.heap_size < 0 || rec.heap_size > end - p)
+        break;
+      HostDBInfo *r = insert(rec.folded_md5);
+      *r = rec.info;
+      int *poffset = r->heap_offset_ptr();
+      if (poffset) {
+        void *heap = rec.heap_size ? alloc(r, poffset, rec.heap_size) : NULL;
+        if (!heap) {
+          remove(r);
+          p += rec.heap_size;
+          continue;
+        }
+        memcpy(heap, p, rec.heap_size);
+      }
+      p += rec.heap_size;
+      n++;
+    }
+    Note("loaded %d host database records from '%s'", n, path);
+  }
+  munmap(data, st.st_size);
+  return n;
+}
+
+#if TS_HAS_TESTS
+REGRESSION_TEST(HostDBMap)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  HostDBMap *m = new HostDBMap;
+  int n = 8 * MULTI_CACHE_PARTITIONS * HOSTDB_MAP_INITIAL_BUCKETS;
+  int ok = 1;
+
+  for (int i = 0; i < n; i++) {
+    HostDBInfo *r = m->insert((uint64_t)i * 0x9E3779B97F4A7C15ULL);
+    r->md5_high = i;
+    if (i % 2) {
+      r->round_robin = 1;
+      int *s = (int *)m->alloc(r, &r->app.rr.offset, sizeof(int));
+      if (s)
+        *s = i;
+    }
+  }
+  ok = ok && m->count() == n && m->stripes[0].n_buckets > HOSTDB_MAP_INITIAL_BUCKETS;
+  for (int i = 0; ok && i < n; i++) {
+    HostDBInfo *r = m->lookup((uint64_t)i * 0x9E3779B97F4A7C15ULL);
+    HostDBInfo copy = *r;
+    int *s = (int *)m->ptr(&copy, copy.app.rr.offset);
+    ok = r->md5_high == (uint64_t)i && (i % 2 ? s && *s == i : !copy.round_robin);
+  }
+  for (int i = 0; ok && i < n; i += 2) {
+    uint64_t folded_md5 = (uint64_t)i * 0x9E3779B97F4A7C15ULL;
+    m->remove(m->lookup(folded_md5));
+    ok = !m->lookup(folded_md5);
+  }
+  ok = ok && m->count() == n / 2;
+  // a copy of a replaced record does not see the heap data its id now holds
+  if (ok) {
+    HostDBInfo copy = *m->lookup(0x9E3779B97F4A7C15ULL);
+    m->remove(m->lookup(0x9E3779B97F4A7C15ULL));
+    // its heap block is freed by the second sweep
+    m->sweep(0x9E3779B97F4A7C15ULL % MULTI_CACHE_PARTITIONS);
+    m->sweep(0x9E3779B97F4A7C15ULL % MULTI_CACHE_PARTITIONS);
+    HostDBInfo *r = m->insert(0x9E3779B97F4A7C15ULL + (uint64_t)MULTI_CACHE_PARTITIONS * n); // same stripe
+    r->round_robin = 1;
+    int *s = (int *)m->alloc(r, &r->app.rr.offset, sizeof(int));
+    ok = s && r->app.rr.offset == copy.app.rr.offset && !m->ptr(&copy, copy.app.rr.offset) &&
+         m->ptr(r, r->app.rr.offset) == s;
+  }
+  delete m;
+
+  rprintf(t, "%d records %s\n", n, ok ? "found" : "lost");
+  *pstatus = ok ? REGRESSION_TEST_PASSED : REGRESSION_TEST_FAILED;
+}
+#endif
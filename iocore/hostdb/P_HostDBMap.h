@@ -0,0 +1,141 @@
+/** @file
+
+  HostDB storage in a lock-striped hash map.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  @section details Details
+
+  With proxy.config.hostdb.backend set to 1 the records are kept in a hash map instead
+  of the fixed size MultiCache. The map is split in one stripe per MultiCache
+  partition, a chained hash table guarded by the lock of the partition, which the
+  callers of HostDB already hold. A stripe doubles its buckets under that lock alone
+  when it fills up, so the map grows with the names looked up instead of evicting them.
+
+  Each record is its own allocation, and so is its heap data (round robin, reverse
+  name). The record refers to its heap data by an id which stays valid in the copies
+  of the record, like the heap offsets of the MultiCache. The copies can outlive the
+  record by far (a transaction keeps one until it connects), so each block is tagged
+  with the record owning it, and a copy whose id was reused for another name gets no
+  heap data rather than the data of that name.
+
+  A removed record is freed only a second later, by the sweep of its stripe, since the
+  callers still read a record right after it is replaced. So are the heap blocks, a
+  pointer just got from a copy stays valid meanwhile. The sweep also drops the
+  records which have timed out. The records are saved to a file every
+  proxy.config.cache.hostdb.sync_frequency seconds, written on a task thread, and
+  loaded back at startup.
+ */
+
+#ifndef _P_HostDBMap_h_
+#define _P_HostDBMap_h_
+
+#include "I_HostDBProcessor.h"
+
+#define HOSTDB_MAP_INITIAL_BUCKETS 256 // per stripe
+#define HOSTDB_MAP_SWEEP_BUCKETS 128   // buckets of a stripe looked at by each sweep
+#define HOSTDB_MAP_HEAP_CHUNK_BITS 12
+#define HOSTDB_MAP_HEAP_CHUNK (1 << HOSTDB_MAP_HEAP_CHUNK_BITS)
+#define HOSTDB_MAP_HEAP_CHUNKS 1024 // so at most 4M records with heap data per stripe
+
+struct HostDBMapEntry {
+  HostDBInfo info; // first, the callers get a pointer to it
+  uint64_t folded_md5;
+  int heap_id;
+  int heap_size;
+  HostDBMapEntry *next;
+};
+
+// The header of a heap block, followed by the data.
+struct HostDBMapHeapBlock {
+  uint64_t tag;             // HostDBInfo::tag() of the record owning the block
+  HostDBMapHeapBlock *next; // once retired
+};
+
+// The heap data of the records of a stripe, by id. The chunks never move, so that the
+// data can be found from a copy of a record without the lock of the stripe.
+struct HostDBMapHeap {
+  HostDBMapHeapBlock **chunks[HOSTDB_MAP_HEAP_CHUNKS];
+  int n_ids; // ids handed out so far
+  int *free_ids;
+  int n_free;
+  int max_free;
+  HostDBMapHeapBlock *retired;  // freed since the last sweep
+  HostDBMapHeapBlock *retiring; // freed before the last sweep, released by the next one
+};
+
+struct HostDBMapStripe {
+  HostDBMapEntry **buckets;
+  int n_buckets; // a power of 2
+  int count;
+  int sweep_cursor;
+  HostDBMapEntry *retired;  // removed since the last sweep
+  HostDBMapEntry *retiring; // removed before the last sweep, freed by the next one
+  HostDBMapHeap heap;
+};
+
+struct HostDBMap {
+  HostDBMapStripe stripes[MULTI_CACHE_PARTITIONS];
+  char path[PATH_NAME_MAX];
+  bool synced; // the first sync, right after the load, is skipped
+
+  // The lock of the stripe of @a folded_md5, that is hostDB.lock_for_bucket(), must be held.
+  HostDBInfo *lookup(uint64_t folded_md5);
+  HostDBInfo *insert(uint64_t folded_md5);
+  void remove(HostDBInfo *r);
+  // The heap data of @a r, its id is stored in @a poffset.
+  void *alloc(HostDBInfo *r, int *poffset, int size);
+
+  // The heap data of @a r, or a copy of it, from its id. NULL if the block of @a id
+  // was freed or is now the one of another record. Does not need the lock.
+  void *ptr(HostDBInfo *r, int id);
+
+  int count();
+  void clear();
+  // Free the records retired and drop some of the timed out ones.
+  void sweep(int stripe);
+  void start_sweep();
+
+  int load(const char *filename);
+  void sync(Continuation *cont);
+  // Append the records of a stripe to @a buf, grown as needed. Returns how many.
+  int save_stripe(int stripe, char *&buf, int &len, int &size);
+
+  HostDBMap();
+  ~HostDBMap();
+
+private:
+  HostDBMapStripe &
+  stripe_of(uint64_t folded_md5)
+  {
+    return stripes[folded_md5 % MULTI_CACHE_PARTITIONS];
+  }
+  HostDBMapEntry *&
+  bucket_of(HostDBMapStripe &s, uint64_t folded_md5)
+  {
+    return s.buckets[(folded_md5 / MULTI_CACHE_PARTITIONS) & (s.n_buckets - 1)];
+  }
+  void grow(HostDBMapStripe &s);
+  void retire(HostDBMapStripe &s, HostDBMapEntry *e);
+  void free_entry(HostDBMapStripe &s, HostDBMapEntry *e);
+  void free_heap(HostDBMapStripe &s, int id);
+  HostDBMapHeapBlock *&heap_slot(HostDBMapHeap &h, int id);
+};
+
+#endif /* _P_HostDBMap_h_ */
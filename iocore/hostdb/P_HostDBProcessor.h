@@ -63,6 +63,12 @@ extern char hostdb_filename[PATH_NAME_MAX];
 extern int hostdb_sync_frequency;
 extern int hostdb_disable_reverse_lookup;
 
+enum {
+  HOSTDB_BACKEND_MULTICACHE,
+  HOSTDB_BACKEND_MAP,
+};
+extern int hostdb_backend;
+
 // Static configuration information
 extern HostDBCache hostDB;
 
@@ -160,6 +166,9 @@ enum HostDB_Stats {
   hostdb_ttl_expires_stat, // D == TTL Expires
   hostdb_re_dns_on_reload_stat,
   hostdb_bytes_stat,
+  hostdb_prefetch_refreshes_stat, // popular names looked up again before they expired
+  hostdb_prefetch_hits_stat,      // hits on a name after its prefetch
+  hostdb_prefetch_misses_stat,    // popular names which expired anyway
   HostDB_Stat_Count
 };
 
@@ -212,6 +221,60 @@ struct HostDBCache : public MultiCache<HostDBInfo> {
 
   Queue<HostDBContinuation, Continuation::Link_link> pending_dns[MULTI_CACHE_PARTITIONS];
   Queue<HostDBContinuation, Continuation::Link_link> &pending_dns_for_hash(INK_MD5 &md5);
+
+  // The records are in this map instead of the MultiCache with proxy.config.hostdb.backend 1.
+  HostDBMap *map;
+
+  HostDBInfo *
+  lookup_block(uint64_t folded_md5, unsigned int level)
+  {
+    return map ? map->lookup(folded_md5) : MultiCache<HostDBInfo>::lookup_block(folded_md5, level);
+  }
+  HostDBInfo *
+  insert_block(uint64_t folded_md5, HostDBInfo *new_block, unsigned int level)
+  {
+    return map ? map->insert(folded_md5) : MultiCache<HostDBInfo>::insert_block(folded_md5, new_block, level);
+  }
+  void
+  delete_block(HostDBInfo *block)
+  {
+    if (map)
+      map->remove(block);
+    else
+      MultiCache<HostDBInfo>::delete_block(block);
+  }
+  void *
+  alloc(HostDBInfo *r, int *poffset, int size)
+  {
+    return map ? map->alloc(r, poffset, size) : MultiCache<HostDBInfo>::alloc(poffset, size);
+  }
+  void *
+  ptr(HostDBInfo *r, int *poffset, int partition)
+  {
+    return map ? map->ptr(r, *poffset) : MultiCache<HostDBInfo>::ptr(poffset, partition);
+  }
+  int
+  ptr_to_partition(char *p)
+  {
+    return map ? -1 : MultiCache<HostDBInfo>::ptr_to_partition(p);
+  }
+  void
+  clear()
+  {
+    if (map)
+      map->clear();
+    else
+      MultiCache<HostDBInfo>::clear();
+  }
+  void
+  sync_partitions(Continuation *cont)
+  {
+    if (map)
+      map->sync(cont);
+    else
+      MultiCache<HostDBInfo>::sync_partitions(cont);
+  }
+
   HostDBCache();
 };
 
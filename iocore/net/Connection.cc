@@ -217,6 +217,12 @@ Server::setup_fd_for_listen(bool non_blocking, int recv_bufsize, int send_bufsiz
     goto Lerror;
   }
 
+#ifdef SO_REUSEPORT
+  if (f_reuseport && (res = safe_setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, SOCKOPT_ON, sizeof(int))) < 0) {
+    goto Lerror;
+  }
+#endif
+
   if ((sockopt_flag_in & NetVCOptions::SOCK_OPT_NO_DELAY) &&
       (res = safe_setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, SOCKOPT_ON, sizeof(int))) < 0) {
     goto Lerror;
@@ -248,6 +254,31 @@ Server::setup_fd_for_listen(bool non_blocking, int recv_bufsize, int send_bufsiz
   }
 #endif
 
+#ifdef TCP_DEFER_ACCEPT
+  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
+  // data on the socket ready to be read
+  {
+    int should_filter_int = 0;
+    REC_ReadConfigInteger(should_filter_int, "proxy.config.net.defer_accept");
+    if (should_filter_int > 0) {
+      setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
+    }
+  }
+#endif
+
+#ifdef TCP_INIT_CWND
+  {
+    int tcp_init_cwnd = 0;
+    REC_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
+    if (tcp_init_cwnd > 0) {
+      Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
+      if (setsockopt(fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
+        Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
+      }
+    }
+  }
+#endif
+
   if (non_blocking) {
     if ((res = safe_nonblocking(fd)) < 0) {
       goto Lerror;
@@ -58,6 +58,9 @@ extern int net_event_period;
 extern int net_accept_period;
 extern int net_retry_delay;
 extern int net_throttle_delay;
+extern int net_config_use_io_uring;
+extern int net_config_accept_reuseport;
+extern int net_config_zerocopy_min_size;
 
 #define NET_EVENT_OPEN (NET_EVENT_EVENTS_START)
 #define NET_EVENT_OPEN_FAILED (NET_EVENT_EVENTS_START + 1)
@@ -452,6 +452,16 @@ public:
    */
   virtual void trapWriteBufferEmpty(int event = VC_EVENT_WRITE_READY);
 
+  /** Whether the buffer written to this connection may hold blocks
+      referring to file ranges (IOBufferFileData), which are then sent
+      with sendfile() without being copied into memory.
+   */
+  virtual bool
+  is_sendfile_capable()
+  {
+    return false;
+  }
+
   /** Returns local sockaddr storage. */
   sockaddr const *get_local_addr();
 
@@ -32,6 +32,7 @@
 #include "P_Net.h"
 
 RecRawStatBlock *net_rsb = NULL;
+RecRawStatBlock *net_accept_rsb = NULL;
 
 // All in milli-seconds
 int net_config_poll_timeout = -1; // This will get set via either command line or records.config.
@@ -39,6 +40,9 @@ int net_event_period = 10;
 int net_accept_period = 10;
 int net_retry_delay = 10;
 int net_throttle_delay = 50; /* milliseconds */
+int net_config_use_io_uring = 0;
+int net_config_accept_reuseport = 0;
+int net_config_zerocopy_min_size = 0;
 
 static inline void
 configure_net(void)
@@ -52,6 +56,9 @@ configure_net(void)
   // These are not reloadable
   REC_ReadConfigInteger(net_event_period, "proxy.config.net.event_period");
   REC_ReadConfigInteger(net_accept_period, "proxy.config.net.accept_period");
+  REC_ReadConfigInteger(net_config_use_io_uring, "proxy.config.net.use_io_uring");
+  REC_ReadConfigInteger(net_config_accept_reuseport, "proxy.config.net.accept_reuseport");
+  REC_ReadConfigInteger(net_config_zerocopy_min_size, "proxy.config.net.zerocopy_min_size");
 }
 
 
@@ -135,6 +142,18 @@ register_net_stats()
   RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.default_inactivity_timeout_applied", RECD_INT, RECP_NON_PERSISTENT,
                      (int)default_inactivity_timeout_stat, RecRawStatSyncSum);
   NET_CLEAR_DYN_STAT(default_inactivity_timeout_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.zerocopy_sends", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)net_zerocopy_sends_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(net_zerocopy_sends_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.zerocopy_copied", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)net_zerocopy_copied_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(net_zerocopy_copied_stat);
+
+  RecRegisterRawStat(net_rsb, RECT_PROCESS, "proxy.process.net.zerocopy_fallbacks", RECD_INT, RECP_NON_PERSISTENT,
+                     (int)net_zerocopy_fallbacks_stat, RecRawStatSyncSum);
+  NET_CLEAR_DYN_STAT(net_zerocopy_fallbacks_stat);
 }
 
 void
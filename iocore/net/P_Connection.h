@@ -158,6 +158,9 @@ struct Server : public Connection {
   /// If set, a kernel HTTP accept filter
   bool http_accept_filter;
 
+  /// If set, the socket is opened with SO_REUSEPORT so that several sockets can listen on the same address.
+  bool f_reuseport;
+
   //
   // Use this call for the main proxy accept
   //
@@ -176,7 +179,7 @@ struct Server : public Connection {
                           bool transparent = false ///< Inbound transparent.
                           );
 
-  Server() : Connection(), f_inbound_transparent(false) { ink_zero(accept_addr); }
+  Server() : Connection(), f_inbound_transparent(false), http_accept_filter(false), f_reuseport(false) { ink_zero(accept_addr); }
 };
 
 #endif /*_Connection_h*/
@@ -53,11 +53,15 @@ enum Net_Stats {
   keep_alive_queue_timeout_total_stat,
   keep_alive_queue_timeout_count_stat,
   default_inactivity_timeout_stat,
+  net_zerocopy_sends_stat,
+  net_zerocopy_copied_stat,
+  net_zerocopy_fallbacks_stat,
   Net_Stat_Count
 };
 
 struct RecRawStatBlock;
 extern RecRawStatBlock *net_rsb;
+extern RecRawStatBlock *net_accept_rsb;
 #define SSL_HANDSHAKE_WANT_READ 6
 #define SSL_HANDSHAKE_WANT_WRITE 7
 #define SSL_HANDSHAKE_WANT_ACCEPT 8
@@ -87,6 +91,14 @@ extern RecRawStatBlock *net_rsb;
 #define NET_SUM_GLOBAL_DYN_STAT(_x, _r) RecIncrGlobalRawStatSum(net_rsb, (_x), (_r))
 #define NET_READ_GLOBAL_DYN_SUM(_x, _sum) RecGetGlobalRawStatSum(net_rsb, _x, &_sum)
 
+// Connections accepted by, or handed over to, each ET_NET thread. These threads are the first ones created by
+// the event processor, so the thread id is the index of the stat.
+#define NET_INCREMENT_THREAD_ACCEPTS(_t)                      \
+  do {                                                        \
+    if ((_t)->id < eventProcessor.n_threads_for_type[ET_NET]) \
+      RecIncrRawStatSum(net_accept_rsb, (_t), (_t)->id, 1);   \
+  } while (0)
+
 #include "libts.h"
 #include "P_EventSystem.h"
 #include "I_Net.h"
@@ -94,6 +94,7 @@ struct NetAccept : public Continuation {
   EventType etype;
   UnixNetVConnection *epoll_vc; // only storage for epoll events
   EventIO ep;
+  bool reuseport_socket; ///< Listens on a SO_REUSEPORT socket of its own, which is not closed by the action.
 
   virtual EventType getEtype() const;
   virtual NetProcessor *getNetProcessor() const;
@@ -101,6 +102,7 @@ struct NetAccept : public Continuation {
   void init_accept_loop(const char *);
   virtual void init_accept(EThread *t = NULL, bool isTransparent = false);
   virtual void init_accept_per_thread(bool isTransparent);
+  void start_accept_per_thread(EventType et, bool isTransparent);
   virtual NetAccept *clone() const;
   // 0 == success
   int do_listen(bool non_blocking, bool transparent = false);
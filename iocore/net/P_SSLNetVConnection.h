@@ -109,6 +109,11 @@ public:
   };
   int sslServerHandShakeEvent(int &err);
   int sslClientHandShakeEvent(int &err);
+  virtual bool
+  is_sendfile_capable()
+  {
+    return false;
+  }
   virtual void net_read_io(NetHandler *nh, EThread *lthread);
   virtual int64_t load_buffer_and_write(int64_t towrite, int64_t &wattempted, int64_t &total_written, MIOBufferAccessor &buf,
                                         int &needs);
@@ -25,6 +25,7 @@
 #define __P_UNIXNET_H__
 
 #include "libts.h"
+#include "P_UnixZeroCopy.h"
 
 #define USE_EDGE_TRIGGER_EPOLL 1
 #define USE_EDGE_TRIGGER_KQUEUE 1
@@ -49,6 +50,14 @@
 #define EVENTIO_ERROR (EPOLLERR | EPOLLPRI | EPOLLHUP)
 #endif
 
+// The io_uring poller relies on multishot polls, which behave like edge triggered epoll.
+#if TS_USE_EPOLL && defined(USE_EDGE_TRIGGER)
+#include "ink_io_uring.h"
+#if TS_HAS_IO_URING
+#define TS_USE_IO_URING_POLL 1
+#endif
+#endif
+
 #if TS_USE_KQUEUE
 #ifdef USE_EDGE_TRIGGER_KQUEUE
 #define USE_EDGE_TRIGGER 1
@@ -83,6 +92,9 @@ struct EventIO {
 #endif
   EventLoop event_loop;
   int type;
+#if TS_USE_IO_URING_POLL
+  int uring_slot; // index of the poll in the io_uring poller
+#endif
   union {
     Continuation *c;
     UnixNetVConnection *vc;
@@ -106,6 +118,9 @@ struct EventIO {
   {
     type = 0;
     data.c = 0;
+#if TS_USE_IO_URING_POLL
+    uring_slot = -1;
+#endif
   }
 };
 
@@ -191,6 +206,7 @@ public:
   uint32_t active_queue_size;
   uint32_t max_connections_per_thread_in;
   uint32_t max_connections_active_per_thread_in;
+  Que(ZeroCopyLinger, link) zerocopy_lingering;
 
   // configuration settings for managing the active and keep-alive queues
   uint32_t max_connections_in;
@@ -213,6 +229,8 @@ public:
   bool add_to_active_queue(UnixNetVConnection *vc);
   void remove_from_active_queue(UnixNetVConnection *vc);
   void configure_per_thread();
+  void zerocopy_linger(int fd, ZeroCopyQueue &queue);
+  void manage_zerocopy_lingering(ink_hrtime now);
 
   NetHandler();
 
@@ -495,6 +513,11 @@ EventIO::start(EventLoop l, int afd, Continuation *c, int e)
   data.c = c;
   fd = afd;
   event_loop = l;
+#if TS_USE_IO_URING_POLL
+  if (event_loop->use_io_uring) {
+    return event_loop->uring_add(this, e);
+  }
+#endif
 #if TS_USE_EPOLL
   struct epoll_event ev;
   memset(&ev, 0, sizeof(ev));
@@ -650,12 +673,19 @@ EventIO::stop()
 {
   if (event_loop) {
     int retval = 0;
+#if TS_USE_IO_URING_POLL
+    if (event_loop->use_io_uring) {
+      retval = event_loop->uring_remove(this);
+    } else
+#endif
+    {
 #if TS_USE_EPOLL
-    struct epoll_event ev;
-    memset(&ev, 0, sizeof(struct epoll_event));
-    ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
-    retval = epoll_ctl(event_loop->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+      struct epoll_event ev;
+      memset(&ev, 0, sizeof(struct epoll_event));
+      ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+      retval = epoll_ctl(event_loop->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
 #endif
+    }
 #if TS_USE_PORT
     retval = port_dissociate(event_loop->port_fd, PORT_SOURCE_FD, fd);
     Debug("iocore_eventio", "[EventIO::stop] %d[%s]=port_dissociate(%d,%d,%d)", retval, retval < 0 ? strerror(errno) : "ok",
@@ -130,6 +130,16 @@ public:
     return false;
   }
 
+  virtual bool
+  is_sendfile_capable()
+  {
+#ifdef HAVE_SYS_SENDFILE_H
+    return true;
+#else
+    return false;
+#endif
+  }
+
   virtual void do_io_close(int lerrno = -1);
   virtual void do_io_shutdown(ShutdownHowTo_t howto);
 
@@ -207,6 +217,8 @@ public:
     (void)state;
   }
   virtual void net_read_io(NetHandler *nh, EThread *lthread);
+  int64_t zerocopy_write(IOVec *iov, IOBufferBlock **blocks, int niov);
+  void reap_zerocopy();
   virtual int64_t load_buffer_and_write(int64_t towrite, int64_t &wattempted, int64_t &total_written, MIOBufferAccessor &buf,
                                         int &needs);
   void readDisable(NetHandler *nh);
@@ -250,12 +262,17 @@ public:
     unsigned int flags;
 #define NET_VC_SHUTDOWN_READ 1
 #define NET_VC_SHUTDOWN_WRITE 2
+#define NET_VC_ZEROCOPY_ON 1
+#define NET_VC_ZEROCOPY_OFF 2
     struct {
       unsigned int got_local_addr : 1;
       unsigned int shutdown : 2;
+      unsigned int zerocopy : 2;
     } f;
   };
 
+  ZeroCopyQueue zerocopy_sends; ///< MSG_ZEROCOPY sends the kernel may still read from.
+
   Connection con;
   int recursion;
   ink_hrtime submit_time;
@@ -45,6 +45,8 @@
 
 typedef struct pollfd Pollfd;
 
+struct EventIO;
+
 struct PollDescriptor {
   int result; // result of poll
 #if TS_USE_EPOLL
@@ -53,6 +55,30 @@ struct PollDescriptor {
   Pollfd pfd[POLL_DESCRIPTOR_SIZE];
   struct epoll_event ePoll_Triggered_Events[POLL_DESCRIPTOR_SIZE];
 #endif
+#if TS_USE_IO_URING_POLL
+  // io_uring poller, enabled by proxy.config.net.use_io_uring. Every EventIO is a multishot poll on the ring,
+  // and the completions are reported through ePoll_Triggered_Events, so the users of the descriptor can't
+  // tell the difference. The polls are armed and removed in batches, with the wait for the completions.
+  struct UringSlot {
+    EventIO *io;
+    uint32_t gen; // bumped when the slot is released, to ignore the completions of the removed poll
+    int events;
+    int next_free;
+  };
+
+  bool use_io_uring;
+  ink_io_uring uring;
+  ink_mutex uring_mutex; // polls may be started from other threads, e.g. by NetAccept::init_accept_per_thread()
+  ink_thread uring_owner;
+  UringSlot *uring_slots;
+  int uring_nslots;
+  int uring_free;
+
+  bool uring_init();
+  int uring_add(EventIO *io, int events);
+  int uring_remove(EventIO *io);
+  int uring_wait(int timeout);
+#endif
 #if TS_USE_KQUEUE
   int kqueue_fd;
 #endif
@@ -115,6 +141,20 @@ struct PollDescriptor {
     return 0;
 #endif
   }
+#if TS_USE_EPOLL
+  // Wait for events, and return how many are stored in ePoll_Triggered_Events.
+  int
+  wait(int timeout)
+  {
+#if TS_USE_IO_URING_POLL
+    if (use_io_uring) {
+      return uring_wait(timeout);
+    }
+#endif
+    return epoll_wait(epoll_fd, ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, timeout);
+  }
+#endif
+
   PollDescriptor *
   init()
   {
@@ -125,6 +165,15 @@ struct PollDescriptor {
     memset(ePoll_Triggered_Events, 0, sizeof(ePoll_Triggered_Events));
     memset(pfd, 0, sizeof(pfd));
 #endif
+#if TS_USE_IO_URING_POLL
+    use_io_uring = false;
+    uring_slots = NULL;
+    uring_nslots = 0;
+    uring_free = -1;
+    if (net_config_use_io_uring) {
+      use_io_uring = uring_init();
+    }
+#endif
 #if TS_USE_KQUEUE
     kqueue_fd = kqueue();
     memset(kq_Triggered_Events, 0, sizeof(kq_Triggered_Events));
@@ -136,6 +185,19 @@ struct PollDescriptor {
     return this;
   }
   PollDescriptor() { init(); }
+  ~PollDescriptor()
+  {
+#if TS_USE_EPOLL
+    close(epoll_fd);
+#endif
+#if TS_USE_IO_URING_POLL
+    if (use_io_uring) {
+      ink_io_uring_close(&uring);
+      ink_mutex_destroy(&uring_mutex);
+    }
+    ats_free(uring_slots);
+#endif
+  }
 };
 
 #endif
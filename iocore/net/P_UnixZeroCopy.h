@@ -0,0 +1,83 @@
+/** @file
+
+  Bookkeeping of the MSG_ZEROCOPY sends of a socket.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __P_UNIXZEROCOPY_H__
+#define __P_UNIXZEROCOPY_H__
+
+#include "libts.h"
+#include "P_EventSystem.h"
+
+#if defined(linux)
+#include <linux/errqueue.h>
+#endif
+
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define TS_USE_MSG_ZEROCOPY 1
+#else
+#define TS_USE_MSG_ZEROCOPY 0
+#endif
+
+// A send with MSG_ZEROCOPY. The kernel reads the data from the buffers after the send returns, so the blocks
+// sent are held until the kernel notifies on the error queue of the socket that it is done with them.
+struct ZeroCopySend {
+  uint32_t seq;              // number of the send on the socket
+  Ptr<IOBufferBlock> blocks; // clones of the blocks sent
+  LINK(ZeroCopySend, link);
+};
+
+extern ClassAllocator<ZeroCopySend> zeroCopySendAllocator;
+
+// The sends of a socket which the kernel may still be reading from.
+class ZeroCopyQueue
+{
+public:
+  ZeroCopyQueue() : next_seq(0) {}
+  ~ZeroCopyQueue() { release(); }
+
+  bool
+  empty() const
+  {
+    return sends.head == NULL;
+  }
+
+  // Record a send of @a len bytes out of the blocks of @a iov.
+  void add(IOBufferBlock **blocks, IOVec *iov, int niov, int64_t len);
+  // Release the sends the kernel is done with. Returns the number of them the kernel copied instead.
+  int reap(int fd);
+  // Release all the sends.
+  void release();
+
+  Que(ZeroCopySend, link) sends;
+  uint32_t next_seq;
+};
+
+// A closed socket kept open until the kernel is done with its sends, since their data could be reused
+// otherwise while it still goes out on the wire.
+struct ZeroCopyLinger {
+  int fd;
+  ink_hrtime timeout_at;
+  ZeroCopyQueue queue;
+  LINK(ZeroCopyLinger, link);
+};
+
+#endif /* __P_UNIXZEROCOPY_H__ */
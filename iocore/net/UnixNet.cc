@@ -22,6 +22,7 @@
  */
 
 #include "P_Net.h"
+#include "I_AIO.h"
 
 ink_hrtime last_throttle_warning;
 ink_hrtime last_shedding_warning;
@@ -106,6 +107,7 @@ public:
     // Cleanup the active and keep-alive queues periodically
     nh.manage_active_queue();
     nh.manage_keep_alive_queue();
+    nh.manage_zerocopy_lingering(now);
 
     return 0;
   }
@@ -185,8 +187,7 @@ PollCont::pollEvent(int event, Event *e)
   }
 // wait for fd's to tigger, or don't wait if timeout is 0
 #if TS_USE_EPOLL
-  pollDescriptor->result =
-    epoll_wait(pollDescriptor->epoll_fd, pollDescriptor->ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, poll_timeout);
+  pollDescriptor->result = pollDescriptor->wait(poll_timeout);
   NetDebug("iocore_net_poll", "[PollCont::pollEvent] epoll_fd: %d, timeout: %d, results: %d", pollDescriptor->epoll_fd,
            poll_timeout, pollDescriptor->result);
 #elif TS_USE_KQUEUE
@@ -421,10 +422,18 @@ NetHandler::mainNetEvent(int event, Event *e)
   else
     poll_timeout = net_config_poll_timeout;
 
+#if AIO_MODE == AIO_MODE_IO_URING
+  // Submit the disk IO issued on this thread since the last poll in one system call.
+  DiskHandler *dh = trigger_event->ethread->diskHandler;
+  if (dh) {
+    dh->submit();
+  }
+#endif
+
   PollDescriptor *pd = get_PollDescriptor(trigger_event->ethread);
   UnixNetVConnection *vc = NULL;
 #if TS_USE_EPOLL
-  pd->result = epoll_wait(pd->epoll_fd, pd->ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, poll_timeout);
+  pd->result = pd->wait(poll_timeout);
   NetDebug("iocore_net_main_poll", "[NetHandler::mainNetEvent] epoll_wait(%d,%d), result=%d", pd->epoll_fd, poll_timeout,
            pd->result);
 #elif TS_USE_KQUEUE
@@ -469,6 +478,10 @@ NetHandler::mainNetEvent(int event, Event *e)
     epd = (EventIO *)get_ev_data(pd, x);
     if (epd->type == EVENTIO_READWRITE_VC) {
       vc = epd->data.vc;
+      // the completions of MSG_ZEROCOPY sends are reported as errors
+      if ((get_ev_events(pd, x) & EVENTIO_ERROR) && !vc->zerocopy_sends.empty()) {
+        vc->reap_zerocopy();
+      }
       if (get_ev_events(pd, x) & (EVENTIO_READ | EVENTIO_ERROR)) {
         vc->read.triggered = 1;
         if (!read_ready_list.in(vc))
@@ -507,6 +520,12 @@ NetHandler::mainNetEvent(int event, Event *e)
 
   pd->result = 0;
 
+#if AIO_MODE == AIO_MODE_IO_URING
+  if (dh) {
+    dh->reap();
+  }
+#endif
+
 #if defined(USE_EDGE_TRIGGER)
   // UnixNetVConnection *
   while ((vc = read_ready_list.dequeue())) {
@@ -23,6 +23,10 @@
 
 #include "P_Net.h"
 
+#if defined(linux)
+#include <linux/filter.h>
+#endif
+
 #ifdef ROUNDUP
 #undef ROUNDUP
 #endif
@@ -72,6 +76,34 @@ send_throttle_message(NetAccept *na)
   return 0;
 }
 
+//
+// Steer each connection to the SO_REUSEPORT socket whose index is the CPU which received it, so that the
+// connection is handled on the CPU its packets arrive on. This only pays off when the net threads are bound
+// to the CPUs in order, one thread per CPU.
+//
+static void
+attach_reuseport_cpu_filter(int fd, int nsockets)
+{
+#if defined(SO_ATTACH_REUSEPORT_CBPF)
+  struct sock_filter code[] = {
+    {BPF_LD | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU)}, // A = CPU of the SYN
+    {BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t)nsockets},                 // A = A % nsockets
+    {BPF_RET | BPF_A, 0, 0, 0},                                            // index of the socket
+  };
+  struct sock_fprog prog;
+
+  prog.len = countof(code);
+  prog.filter = code;
+  if (safe_setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (char *)&prog, sizeof(prog)) < 0) {
+    Warning("unable to attach the CPU steering filter to the listen socket: %s", strerror(errno));
+  }
+#else
+  (void)fd;
+  (void)nsockets;
+  Warning("CPU steering of the accepted connections is not supported on this platform");
+#endif
+}
+
 
 //
 // General case network connection accept code
@@ -178,8 +210,6 @@ NetAccept::init_accept(EThread *t, bool isTransparent)
 void
 NetAccept::init_accept_per_thread(bool isTransparent)
 {
-  int i, n;
-
   if (do_listen(NON_BLOCKING, isTransparent))
     return;
   if (accept_fn == net_accept)
@@ -188,20 +218,57 @@ NetAccept::init_accept_per_thread(bool isTransparent)
     SET_HANDLER((NetAcceptHandler)&NetAccept::acceptEvent);
   period = -HRTIME_MSECONDS(net_accept_period);
 
-  NetAccept *a;
-  n = eventProcessor.n_threads_for_type[ET_NET];
-  for (i = 0; i < n; i++) {
-    if (i < n - 1)
-      a = clone();
-    else
-      a = this;
-    EThread *t = eventProcessor.eventthread[ET_NET][i];
+  start_accept_per_thread(ET_NET, isTransparent);
+}
+
+//
+// Start an accept on every thread of type et, this one on the first thread and clones of it on the others.
+// If the listen socket was opened with SO_REUSEPORT, each clone listens on a socket of its own and the
+// kernel balances the connections across the sockets, instead of waking up every thread on a shared one.
+//
+void
+NetAccept::start_accept_per_thread(EventType et, bool isTransparent)
+{
+  int n = eventProcessor.n_threads_for_type[et];
+  NetAccept **accepts = (NetAccept **)ats_malloc(n * sizeof(NetAccept *));
+
+  // Clone before starting, the clones must not copy a started EventIO.
+  accepts[0] = this;
+  for (int i = 1; i < n; i++) {
+    accepts[i] = clone();
+  }
+
+  // The sockets join the SO_REUSEPORT group in the order of the threads, which the CPU steering relies on.
+  if (server.f_reuseport) {
+    for (int i = 1; i < n; i++) {
+      NetAccept *a = accepts[i];
+
+      a->server.fd = NO_FD;
+      if (a->server.listen(NON_BLOCKING, recv_bufsize, send_bufsize, isTransparent) == 0) {
+        a->reuseport_socket = true;
+      } else {
+        Warning("unable to open a SO_REUSEPORT socket on port %d, thread %d will share the main listen socket",
+                ats_ip_port_host_order(&server.accept_addr), i);
+        a->server.fd = server.fd;
+      }
+    }
+    if (net_config_accept_reuseport > 1) {
+      attach_reuseport_cpu_filter(server.fd, n);
+    }
+  }
+
+  for (int i = 0; i < n; i++) {
+    NetAccept *a = accepts[i];
+    EThread *t = eventProcessor.eventthread[et][i];
     PollDescriptor *pd = get_PollDescriptor(t);
+
     if (a->ep.start(pd, a, EVENTIO_READ) < 0)
-      Warning("[NetAccept::init_accept_per_thread]:error starting EventIO");
+      Warning("[NetAccept::start_accept_per_thread]:error starting EventIO");
     a->mutex = get_NetHandler(t)->mutex;
     t->schedule_every(a, period, etype);
   }
+
+  ats_free(accepts);
 }
 
 int
@@ -317,6 +384,10 @@ NetAccept::acceptEvent(int event, void *ep)
   MUTEX_TRY_LOCK(lock, m, e->ethread);
   if (lock.is_locked()) {
     if (action_->cancelled) {
+      if (reuseport_socket) {
+        this->ep.stop();
+        server.close();
+      }
       e->cancel();
       NET_DECREMENT_DYN_STAT(net_accepts_currently_open_stat);
       delete this;
@@ -357,6 +428,15 @@ NetAccept::acceptFastEvent(int event, void *ep)
   UnixNetVConnection *vc = NULL;
   int loop = accept_till_done;
 
+  // NetAcceptAction::cancel() only closes the main listen socket.
+  if (reuseport_socket && action_->cancelled) {
+    this->ep.stop();
+    server.close();
+    e->cancel();
+    delete this;
+    return EVENT_DONE;
+  }
+
   do {
     if (!backdoor && check_net_throttle(ACCEPT, ink_get_hrtime())) {
       ifd = -1;
@@ -442,6 +522,7 @@ NetAccept::acceptFastEvent(int event, void *ep)
     vc->thread = e->ethread;
 
     vc->nh = get_NetHandler(e->ethread);
+    NET_INCREMENT_THREAD_ACCEPTS(e->ethread);
 
     SET_CONTINUATION_HANDLER(vc, (NetVConnHandler)&UnixNetVConnection::mainEvent);
 
@@ -506,7 +587,7 @@ NetAccept::acceptLoopEvent(int event, Event *e)
 
 NetAccept::NetAccept()
   : Continuation(NULL), period(0), alloc_cache(0), ifd(-1), callback_on_open(false), backdoor(false), recv_bufsize(0),
-    send_bufsize(0), sockopt_flags(0), packet_mark(0), packet_tos(0), etype(0)
+    send_bufsize(0), sockopt_flags(0), packet_mark(0), packet_tos(0), etype(0), reuseport_socket(false)
 {
 }
 
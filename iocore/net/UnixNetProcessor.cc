@@ -167,29 +167,15 @@ UnixNetProcessor::accept_internal(Continuation *cont, int fd, AcceptOptions cons
 #endif // TS_USE_POSIX_CAP
       }
     } else {
+#ifdef SO_REUSEPORT
+      na->server.f_reuseport = net_config_accept_reuseport > 0;
+#endif
       na->init_accept_per_thread(opt.f_inbound_transparent);
     }
   } else {
     na->init_accept(NULL, opt.f_inbound_transparent);
   }
 
-#ifdef TCP_DEFER_ACCEPT
-  // set tcp defer accept timeout if it is configured, this will not trigger an accept until there is
-  // data on the socket ready to be read
-  if (should_filter_int > 0) {
-    setsockopt(na->server.fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &should_filter_int, sizeof(int));
-  }
-#endif
-#ifdef TCP_INIT_CWND
-  int tcp_init_cwnd = 0;
-  REC_ReadConfigInteger(tcp_init_cwnd, "proxy.config.http.server_tcp_init_cwnd");
-  if (tcp_init_cwnd > 0) {
-    Debug("net", "Setting initial congestion window to %d", tcp_init_cwnd);
-    if (setsockopt(na->server.fd, IPPROTO_TCP, TCP_INIT_CWND, &tcp_init_cwnd, sizeof(int)) != 0) {
-      Error("Cannot set initial congestion window to %d", tcp_init_cwnd);
-    }
-  }
-#endif
   return na->action_;
 }
 
@@ -411,6 +397,16 @@ UnixNetProcessor::start(int, size_t)
     initialize_thread_for_http_sessions(netthreads[i], i);
   }
 
+  // Per thread accept counters, to see how the connections are balanced across the net threads.
+  if (etype == ET_NET && !net_accept_rsb) {
+    net_accept_rsb = RecAllocateRawStatBlock(n_netthreads);
+    for (int i = 0; i < n_netthreads; ++i) {
+      char name[64];
+      snprintf(name, sizeof(name), "proxy.process.net.accepts.thread_%d", i);
+      RecRegisterRawStat(net_accept_rsb, RECT_PROCESS, name, RECD_INT, RECP_NON_PERSISTENT, i, RecRawStatSyncSum);
+    }
+  }
+
   RecData d;
   d.rec_int = 0;
   change_net_connections_throttle(NULL, RECD_INT, d, NULL);
@@ -97,6 +97,13 @@ close_UnixNetVConnection(UnixNetVConnection *vc, EThread *t)
   NetHandler *nh = vc->nh;
   vc->cancel_OOB();
   vc->ep.stop();
+  if (!vc->zerocopy_sends.empty()) {
+    vc->reap_zerocopy();
+  }
+  if (!vc->zerocopy_sends.empty()) {
+    nh->zerocopy_linger(vc->con.fd, vc->zerocopy_sends);
+    vc->con.fd = NO_FD;
+  }
   vc->con.close();
 #ifdef INACTIVITY_TIMEOUT
   if (vc->inactivity_timeout) {
@@ -893,13 +900,20 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
 {
   int64_t r = 0;
 
+  if (!zerocopy_sends.empty()) {
+    reap_zerocopy();
+  }
+
   // XXX Rather than dealing with the block directly, we should use the IOBufferReader API.
   int64_t offset = buf.reader()->start_offset;
   IOBufferBlock *b = buf.reader()->block;
 
   do {
     IOVec tiovec[NET_MAX_IOV];
+    IOBufferBlock *tblock[NET_MAX_IOV];
     int niov = 0;
+    IOBufferFileData *fdata = NULL;
+    off_t foffset = 0;
     int64_t total_written_last = total_written;
     while (b && niov < NET_MAX_IOV) {
       // check if we have done this block
@@ -916,17 +930,37 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
         l = wavail;
       if (!l)
         break;
+      // a file range is sent on its own, once the blocks before it are out
+      if (b->data->_mem_type == FILE_RANGE) {
+        if (!niov) {
+          fdata = static_cast<IOBufferFileData *>(b->data.m_ptr);
+          foffset = fdata->file_offset(b->start() + offset);
+          total_written += l;
+          offset = 0;
+          b = b->next;
+        }
+        break;
+      }
       total_written += l;
       // build an iov entry
       tiovec[niov].iov_len = l;
       tiovec[niov].iov_base = b->start() + offset;
+      tblock[niov] = b;
       niov++;
       // on to the next block
       offset = 0;
       b = b->next;
     }
     wattempted = total_written - total_written_last;
-    if (niov == 1)
+    if (fdata) {
+#ifdef HAVE_SYS_SENDFILE_H
+      r = fdata->is_valid() ? socketManager.sendfile(con.fd, fdata->_fd, foffset, wattempted) : -EIO;
+#else
+      r = -ENOTSUP;
+#endif
+    } else if (net_config_zerocopy_min_size > 0 && wattempted >= net_config_zerocopy_min_size)
+      r = zerocopy_write(tiovec, tblock, niov);
+    else if (niov == 1)
       r = socketManager.write(con.fd, tiovec[0].iov_base, tiovec[0].iov_len);
     else
       r = socketManager.writev(con.fd, &tiovec[0], niov);
@@ -939,6 +973,56 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, int64_t &wattempted,
   return (r);
 }
 
+// Send with MSG_ZEROCOPY, holding on to the blocks until the kernel is done with them.
+int64_t
+UnixNetVConnection::zerocopy_write(IOVec *iov, IOBufferBlock **blocks, int niov)
+{
+  ProxyMutex *mutex = thread->mutex;
+
+#if TS_USE_MSG_ZEROCOPY
+  if (!f.zerocopy) {
+    int one = 1;
+    if (safe_setsockopt(con.fd, SOL_SOCKET, SO_ZEROCOPY, (char *)&one, sizeof(one)) < 0)
+      f.zerocopy = NET_VC_ZEROCOPY_OFF;
+    else
+      f.zerocopy = NET_VC_ZEROCOPY_ON;
+  }
+  if (f.zerocopy == NET_VC_ZEROCOPY_ON) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = niov;
+    int64_t r = socketManager.sendmsg(con.fd, &msg, MSG_ZEROCOPY);
+    if (r > 0) {
+      zerocopy_sends.add(blocks, iov, niov, r);
+      NET_INCREMENT_DYN_STAT(net_zerocopy_sends_stat);
+    }
+    // ENOBUFS: the pages could not be pinned, copy them instead
+    if (r != -ENOBUFS) {
+      return r;
+    }
+  }
+#else
+  (void)blocks;
+#endif
+
+  NET_INCREMENT_DYN_STAT(net_zerocopy_fallbacks_stat);
+  return socketManager.writev(con.fd, iov, niov);
+}
+
+void
+UnixNetVConnection::reap_zerocopy()
+{
+  int copied = zerocopy_sends.reap(con.fd);
+
+  if (copied) {
+    ProxyMutex *mutex = thread->mutex;
+    NET_SUM_DYN_STAT(net_zerocopy_copied_stat, copied);
+    // The kernel copies the data of this connection anyway, e.g. over the loopback.
+    f.zerocopy = NET_VC_ZEROCOPY_OFF;
+  }
+}
+
 void
 UnixNetVConnection::readDisable(NetHandler *nh)
 {
@@ -1022,6 +1106,7 @@ UnixNetVConnection::acceptEvent(int event, Event *e)
   }
 
   SET_HANDLER((NetVConnHandler)&UnixNetVConnection::mainEvent);
+  NET_INCREMENT_THREAD_ACCEPTS(thread);
 
   nh = get_NetHandler(thread);
   PollDescriptor *pd = get_PollDescriptor(thread);
@@ -1238,6 +1323,8 @@ UnixNetVConnection::free(EThread *t)
   ink_assert(!active_timeout);
 #endif
   ink_assert(con.fd == NO_FD);
+  ink_assert(zerocopy_sends.empty());
+  zerocopy_sends.next_seq = 0;
   ink_assert(t == this_ethread());
 
   if (from_accept_thread) {
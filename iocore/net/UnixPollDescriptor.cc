@@ -0,0 +1,463 @@
+/** @file
+
+  io_uring backend of the PollDescriptor
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Net.h"
+
+#if TS_USE_IO_URING_POLL
+
+#include <sys/eventfd.h>
+
+// user_data of the SQEs whose completion is of no interest.
+static const uint64_t URING_IGNORE = ~(uint64_t)0;
+static const unsigned URING_ENTRIES = 4096;
+
+static inline uint64_t
+uring_user_data(int slot, uint32_t gen)
+{
+  return ((uint64_t)gen << 32) | (uint32_t)slot;
+}
+
+// Number of SQEs written and not submitted yet.
+static inline unsigned
+uring_unsubmitted(ink_io_uring *ring)
+{
+  return *ring->sq_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+}
+
+// Return a free SQE, submitting the pending ones to make room if needed.
+static struct io_uring_sqe *
+uring_get_sqe(ink_io_uring *ring)
+{
+  struct io_uring_sqe *sqe = ink_io_uring_get_sqe(ring);
+
+  if (sqe == NULL) {
+    ink_io_uring_enter(ring, uring_unsubmitted(ring), 0, 0);
+    sqe = ink_io_uring_get_sqe(ring);
+  }
+  return sqe;
+}
+
+static inline void
+uring_prep_poll(struct io_uring_sqe *sqe, int fd, int events, uint64_t user_data)
+{
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+#if __BYTE_ORDER == __BIG_ENDIAN
+  events = __swahw32(events);
+#endif
+  sqe->poll32_events = events;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = user_data;
+}
+
+// Set up the ring, and check that the kernel supports everything the poller needs: waiting with a timeout
+// (IORING_FEAT_EXT_ARG, Linux 5.11) and multishot polls (Linux 5.13). The latter is tried on an eventfd.
+bool
+PollDescriptor::uring_init()
+{
+  int ret = ink_io_uring_init(&uring, URING_ENTRIES);
+  if (ret < 0) {
+    Warning("io_uring is not available: %s, using epoll", strerror(-ret));
+    return false;
+  }
+
+  bool supported = false;
+  int efd = -1;
+
+  if (uring.features & IORING_FEAT_EXT_ARG) {
+    efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  }
+  if (efd >= 0) {
+    uint64_t counter = 1;
+    struct io_uring_sqe *sqe = ink_io_uring_get_sqe(&uring);
+
+    uring_prep_poll(sqe, efd, POLLIN, URING_IGNORE);
+    ink_io_uring_sqe_ready(&uring);
+    ATS_UNUSED_RETURN(write(efd, &counter, sizeof(counter)));
+
+    if (ink_io_uring_enter(&uring, 1, 1, IORING_ENTER_GETEVENTS) == 1) {
+      struct io_uring_cqe *cqe = ink_io_uring_peek_cqe(&uring);
+      if (cqe) {
+        supported = cqe->res > 0 && (cqe->flags & IORING_CQE_F_MORE);
+        ink_io_uring_cqe_seen(&uring);
+      }
+    }
+
+    // The completions of the removal are ignored by uring_wait().
+    sqe = ink_io_uring_get_sqe(&uring);
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->addr = URING_IGNORE;
+    sqe->user_data = URING_IGNORE;
+    ink_io_uring_sqe_ready(&uring);
+    ink_io_uring_enter(&uring, 1, 0, 0);
+    close(efd);
+  }
+
+  if (!supported) {
+    Warning("the kernel doesn't support io_uring multishot polls, using epoll");
+    ink_io_uring_close(&uring);
+    return false;
+  }
+
+  ink_mutex_init(&uring_mutex, "PollDescriptor::uring_mutex");
+  uring_owner = ink_thread_self();
+  Debug("iocore_net", "polling with io_uring, fd %d", uring.fd);
+  return true;
+}
+
+int
+PollDescriptor::uring_add(EventIO *io, int events)
+{
+  ink_mutex_acquire(&uring_mutex);
+
+  if (uring_free < 0) {
+    int n = uring_nslots ? uring_nslots * 2 : 1024;
+    uring_slots = (UringSlot *)ats_realloc(uring_slots, n * sizeof(UringSlot));
+    for (int i = n - 1; i >= uring_nslots; --i) {
+      uring_slots[i].io = NULL;
+      uring_slots[i].gen = 0;
+      uring_slots[i].events = 0;
+      uring_slots[i].next_free = uring_free;
+      uring_free = i;
+    }
+    uring_nslots = n;
+  }
+
+  struct io_uring_sqe *sqe = uring_get_sqe(&uring);
+  if (sqe == NULL) {
+    ink_mutex_release(&uring_mutex);
+    errno = EBUSY;
+    return -1;
+  }
+
+  int slot = uring_free;
+  UringSlot &s = uring_slots[slot];
+
+  uring_free = s.next_free;
+  s.io = io;
+  s.events = events & ~EPOLLET;
+  io->uring_slot = slot;
+
+  uring_prep_poll(sqe, io->fd, s.events, uring_user_data(slot, s.gen));
+  ink_io_uring_sqe_ready(&uring);
+
+  // Requests from the polling thread are submitted with the next wait, the others right away.
+  if (!pthread_equal(uring_owner, ink_thread_self())) {
+    ink_io_uring_enter(&uring, uring_unsubmitted(&uring), 0, 0);
+  }
+
+  ink_mutex_release(&uring_mutex);
+  return 0;
+}
+
+int
+PollDescriptor::uring_remove(EventIO *io)
+{
+  int slot = io->uring_slot;
+  if (slot < 0) {
+    return 0;
+  }
+
+  ink_mutex_acquire(&uring_mutex);
+
+  UringSlot &s = uring_slots[slot];
+  struct io_uring_sqe *sqe = uring_get_sqe(&uring);
+
+  if (sqe) {
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->addr = uring_user_data(slot, s.gen);
+    sqe->user_data = URING_IGNORE;
+    ink_io_uring_sqe_ready(&uring);
+  }
+
+  // The completions of the poll still in the queue are ignored from now on.
+  ++s.gen;
+  s.io = NULL;
+  s.next_free = uring_free;
+  uring_free = slot;
+  io->uring_slot = -1;
+
+  if (!pthread_equal(uring_owner, ink_thread_self())) {
+    ink_io_uring_enter(&uring, uring_unsubmitted(&uring), 0, 0);
+  }
+
+  ink_mutex_release(&uring_mutex);
+  return sqe ? 0 : -1;
+}
+
+// Submit the polls added and removed since the last call, wait for completions, and translate them into
+// ePoll_Triggered_Events.
+int
+PollDescriptor::uring_wait(int timeout)
+{
+  struct io_uring_cqe *cqe;
+  struct io_uring_sqe *sqe;
+  int n = 0;
+
+  ink_mutex_acquire(&uring_mutex);
+  uring_owner = ink_thread_self();
+  unsigned to_submit = uring_unsubmitted(&uring);
+  ink_mutex_release(&uring_mutex);
+
+  if (timeout == 0 || ink_io_uring_peek_cqe(&uring)) {
+    if (to_submit) {
+      ink_io_uring_enter(&uring, to_submit, 0, IORING_ENTER_GETEVENTS);
+    }
+  } else {
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+
+    memset(&arg, 0, sizeof(arg));
+    if (timeout > 0) {
+      ts.tv_sec = timeout / 1000;
+      ts.tv_nsec = (timeout % 1000) * 1000000;
+      arg.ts = (uint64_t)(uintptr_t)&ts;
+    }
+    ink_io_uring_enter(&uring, to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+  }
+
+  ink_mutex_acquire(&uring_mutex);
+  while (n < POLL_DESCRIPTOR_SIZE && (cqe = ink_io_uring_peek_cqe(&uring)) != NULL) {
+    uint64_t user_data = cqe->user_data;
+    int res = cqe->res;
+    bool more = cqe->flags & IORING_CQE_F_MORE;
+
+    ink_io_uring_cqe_seen(&uring);
+
+    if (user_data == URING_IGNORE) {
+      continue;
+    }
+
+    int slot = (int)(uint32_t)user_data;
+    if (slot >= uring_nslots || uring_slots[slot].gen != (uint32_t)(user_data >> 32) || uring_slots[slot].io == NULL) {
+      continue;
+    }
+
+    UringSlot &s = uring_slots[slot];
+    if (res < 0) {
+      // The poll failed and is gone, let the owner of the fd find out about it.
+      ePoll_Triggered_Events[n].events = EPOLLERR;
+    } else {
+      if (!more && (sqe = uring_get_sqe(&uring)) != NULL) {
+        // The kernel terminated the poll, e.g. because the completion queue overflowed. Arm it again.
+        uring_prep_poll(sqe, s.io->fd, s.events, user_data);
+        ink_io_uring_sqe_ready(&uring);
+      }
+      if (res == 0) {
+        continue;
+      }
+      ePoll_Triggered_Events[n].events = res;
+    }
+    ePoll_Triggered_Events[n].data.ptr = s.io;
+    ++n;
+  }
+  ink_mutex_release(&uring_mutex);
+
+  return n;
+}
+
+#endif /* TS_USE_IO_URING_POLL */
+
+#if TS_HAS_TESTS && TS_USE_EPOLL
+
+#include "TestBox.h"
+
+struct PollTestConnections {
+  int n;
+  int *client;
+  int *server;
+  EventIO *eio;
+
+  // Keep-alive connections over the loopback interface.
+  bool
+  open(int count)
+  {
+    IpEndpoint addr;
+    socklen_t addrlen = sizeof(addr.sin);
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+
+    n = 0;
+    client = (int *)ats_malloc(count * sizeof(int));
+    server = (int *)ats_malloc(count * sizeof(int));
+    eio = new EventIO[count];
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin.sin_family = AF_INET;
+    addr.sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (lfd < 0 || bind(lfd, &addr.sa, sizeof(addr.sin)) < 0 || listen(lfd, count) < 0 ||
+        getsockname(lfd, &addr.sa, &addrlen) < 0) {
+      ::close(lfd);
+      return false;
+    }
+
+    for (; n < count; ++n) {
+      client[n] = socket(AF_INET, SOCK_STREAM, 0);
+      if (client[n] < 0 || connect(client[n], &addr.sa, sizeof(addr.sin)) < 0) {
+        ::close(client[n]);
+        break;
+      }
+      server[n] = accept(lfd, NULL, NULL);
+      if (server[n] < 0) {
+        ::close(client[n]);
+        break;
+      }
+      fcntl(server[n], F_SETFL, O_NONBLOCK);
+    }
+
+    ::close(lfd);
+    return n == count;
+  }
+
+  void
+  close()
+  {
+    for (int i = 0; i < n; ++i) {
+      eio[i].stop();
+      ::close(client[i]);
+      ::close(server[i]);
+    }
+    ats_free(client);
+    ats_free(server);
+    delete[] eio;
+  }
+};
+
+// Send a byte on the given connections, and poll until all of them reported that they are readable.
+static int
+poll_test_round(PollDescriptor *pd, PollTestConnections &conns, int first, int count, bool *seen)
+{
+  char c = 'x';
+  int ready = 0;
+
+  for (int i = first; i < first + count; ++i) {
+    ATS_UNUSED_RETURN(write(conns.client[i], &c, 1));
+  }
+
+  for (int tries = 0; ready < count && tries < 100; ++tries) {
+    int r = pd->wait(10);
+    for (int x = 0; x < r; ++x) {
+      EventIO *e = (EventIO *)get_ev_data(pd, x);
+      int i = e - conns.eio;
+      if ((get_ev_events(pd, x) & EVENTIO_READ) && !seen[i]) {
+        char buf[16];
+        seen[i] = true;
+        ++ready;
+        ATS_UNUSED_RETURN(read(conns.server[i], buf, sizeof(buf)));
+      }
+    }
+  }
+
+  return ready;
+}
+
+static void
+poll_test_run(RegressionTest *t, TestBox &box, bool io_uring, int nconns, int nrounds, int batch)
+{
+  PollDescriptor *pd = new PollDescriptor;
+  PollTestConnections conns;
+  const char *name = io_uring ? "io_uring" : "epoll";
+
+#if TS_USE_IO_URING_POLL
+  if (io_uring && !pd->use_io_uring) {
+    pd->use_io_uring = pd->uring_init();
+  } else if (!io_uring && pd->use_io_uring) {
+    ink_io_uring_close(&pd->uring);
+    pd->use_io_uring = false;
+  }
+  if (io_uring && !pd->use_io_uring) {
+    rprintf(t, "io_uring is not supported, skipping\n");
+    delete pd;
+    return;
+  }
+#else
+  if (io_uring) {
+    delete pd;
+    return;
+  }
+#endif
+
+  if (!conns.open(nconns)) {
+    rprintf(t, "unable to open %d loopback connections, skipping %s\n", nconns, name);
+    conns.close();
+    delete pd;
+    return;
+  }
+
+  for (int i = 0; i < nconns; ++i) {
+    box.check(conns.eio[i].start(pd, conns.server[i], NULL, EVENTIO_READ) == 0, "%s: unable to start polling", name);
+  }
+
+  bool *seen = (bool *)ats_malloc(nconns * sizeof(bool));
+  ink_hrtime start = ink_get_hrtime_internal();
+
+  for (int round = 0; round < nrounds; ++round) {
+    int first = (round * batch) % (nconns - batch + 1);
+    memset(seen, 0, nconns * sizeof(bool));
+    int ready = poll_test_round(pd, conns, first, batch, seen);
+    box.check(ready == batch, "%s: %d of %d connections reported readable", name, ready, batch);
+    for (int i = 0; i < nconns; ++i) {
+      box.check(seen[i] == (i >= first && i < first + batch), "%s: unexpected event on connection %d", name, i);
+    }
+  }
+
+  ink_hrtime elapsed = ink_get_hrtime_internal() - start;
+  if (nrounds > 1) {
+    rprintf(t, "%s: %d connections, %d rounds of %d, %" PRId64 " usec/round\n", name, nconns, nrounds, batch,
+            (int64_t)ink_hrtime_to_usec(elapsed) / nrounds);
+  }
+
+  // A connection which isn't polled anymore is quiet.
+  conns.eio[0].stop();
+  memset(seen, 0, nconns * sizeof(bool));
+  box.check(poll_test_round(pd, conns, 0, 2, seen) == 1 && !seen[0], "%s: stopped connection reported an event", name);
+
+  ats_free(seen);
+  conns.close();
+  delete pd;
+}
+
+REGRESSION_TEST(NetPoller)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  poll_test_run(t, box, false, 64, 8, 16);
+  poll_test_run(t, box, true, 64, 8, 16);
+}
+
+// Many idle keep-alive connections, with a few of them active at a time.
+REGRESSION_TEST(NetPoller_Benchmark)(RegressionTest *t, int atype, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  if (atype < REGRESSION_TEST_NIGHTLY) {
+    *pstatus = REGRESSION_TEST_NOT_RUN;
+    return;
+  }
+
+  poll_test_run(t, box, false, 400, 2000, 32);
+  poll_test_run(t, box, true, 400, 2000, 32);
+}
+
+#endif /* TS_HAS_TESTS && TS_USE_EPOLL */
@@ -0,0 +1,149 @@
+/** @file
+
+  Bookkeeping of the MSG_ZEROCOPY sends of a socket.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Net.h"
+
+ClassAllocator<ZeroCopySend> zeroCopySendAllocator("zeroCopySendAllocator");
+
+// How long a closed socket is kept for the kernel to finish its sends, before it is reset.
+#define ZEROCOPY_LINGER_TIMEOUT HRTIME_SECONDS(30)
+
+static inline void
+free_ZeroCopySend(ZeroCopySend *s)
+{
+  s->blocks = NULL;
+  zeroCopySendAllocator.free(s);
+}
+
+void
+ZeroCopyQueue::add(IOBufferBlock **blocks, IOVec *iov, int niov, int64_t len)
+{
+  ZeroCopySend *s = zeroCopySendAllocator.alloc();
+  IOBufferBlock *tail = NULL;
+
+  s->seq = next_seq++;
+  for (int i = 0; i < niov && len > 0; len -= iov[i].iov_len, ++i) {
+    IOBufferBlock *b = blocks[i]->clone();
+    if (tail) {
+      tail->next = b;
+    } else {
+      s->blocks = b;
+    }
+    tail = b;
+  }
+  sends.enqueue(s);
+}
+
+int
+ZeroCopyQueue::reap(int fd)
+{
+  int copied = 0;
+
+#if TS_USE_MSG_ZEROCOPY
+  while (!empty()) {
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err)) + CMSG_SPACE(sizeof(struct sockaddr_in6))];
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(fd, &msg, MSG_ERRQUEUE) < 0) {
+      break;
+    }
+
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+          !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+        continue;
+      }
+      struct sock_extended_err *err = reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cm));
+      if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+        continue;
+      }
+      // The sends from ee_info to ee_data, both included, are done.
+      uint32_t lo = err->ee_info, hi = err->ee_data;
+      ZeroCopySend *next = NULL;
+      for (ZeroCopySend *s = sends.head; s; s = next) {
+        next = s->link.next;
+        if (s->seq - lo <= hi - lo) {
+          sends.remove(s);
+          free_ZeroCopySend(s);
+          if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+            ++copied;
+          }
+        }
+      }
+    }
+  }
+#else
+  (void)fd;
+#endif
+
+  return copied;
+}
+
+void
+ZeroCopyQueue::release()
+{
+  while (ZeroCopySend *s = sends.dequeue()) {
+    free_ZeroCopySend(s);
+  }
+}
+
+void
+NetHandler::zerocopy_linger(int fd, ZeroCopyQueue &queue)
+{
+  ZeroCopyLinger *l = new ZeroCopyLinger;
+
+  l->fd = fd;
+  l->timeout_at = ink_get_hrtime() + ZEROCOPY_LINGER_TIMEOUT;
+  l->queue.next_seq = queue.next_seq;
+  while (ZeroCopySend *s = queue.sends.dequeue()) {
+    l->queue.sends.enqueue(s);
+  }
+  // What close() would do, the socket stays open.
+  shutdown(fd, SHUT_WR);
+  zerocopy_lingering.enqueue(l);
+}
+
+void
+NetHandler::manage_zerocopy_lingering(ink_hrtime now)
+{
+  ZeroCopyLinger *next = NULL;
+
+  for (ZeroCopyLinger *l = zerocopy_lingering.head; l; l = next) {
+    next = l->link.next;
+    l->queue.reap(l->fd);
+    if (!l->queue.empty() && l->timeout_at > now) {
+      continue;
+    }
+    if (!l->queue.empty()) {
+      // Reset the connection, so that the kernel drops the data it did not send instead of reading it later.
+      struct linger lngr = {1, 0};
+      safe_setsockopt(l->fd, SOL_SOCKET, SO_LINGER, (char *)&lngr, sizeof(lngr));
+    }
+    socketManager.close(l->fd);
+    zerocopy_lingering.remove(l);
+    delete l;
+  }
+}
@@ -0,0 +1,112 @@
+/** @file
+
+  Minimal io_uring support for libts
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "libts.h"
+#include "ink_io_uring.h"
+
+#if TS_HAS_IO_URING
+
+#include <sys/mman.h>
+
+int
+ink_io_uring_init(ink_io_uring *ring, unsigned entries)
+{
+  struct io_uring_params p;
+
+  memset(ring, 0, sizeof(*ring));
+  memset(&p, 0, sizeof(p));
+  ring->sq_ring = ring->cq_ring = MAP_FAILED;
+  ring->sqes = (struct io_uring_sqe *)MAP_FAILED;
+
+  ring->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  if (ring->fd < 0) {
+    return -errno;
+  }
+  ring->features = p.features;
+
+  ring->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->sq_ring_size = ring->cq_ring_size = MAX(ring->sq_ring_size, ring->cq_ring_size);
+  }
+  ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED) {
+    goto Lerror;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ring = ring->sq_ring;
+  } else {
+    ring->cq_ring =
+      mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ring == MAP_FAILED) {
+      goto Lerror;
+    }
+  }
+  ring->sqes =
+    (struct io_uring_sqe *)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    goto Lerror;
+  }
+
+  ring->sq_head = (unsigned *)((char *)ring->sq_ring + p.sq_off.head);
+  ring->sq_tail = (unsigned *)((char *)ring->sq_ring + p.sq_off.tail);
+  ring->sq_mask = (unsigned *)((char *)ring->sq_ring + p.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)((char *)ring->sq_ring + p.sq_off.array);
+  ring->sq_entries = p.sq_entries;
+
+  ring->cq_head = (unsigned *)((char *)ring->cq_ring + p.cq_off.head);
+  ring->cq_tail = (unsigned *)((char *)ring->cq_ring + p.cq_off.tail);
+  ring->cq_mask = (unsigned *)((char *)ring->cq_ring + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)((char *)ring->cq_ring + p.cq_off.cqes);
+  ring->cq_entries = p.cq_entries;
+  return 0;
+
+Lerror:
+  int err = errno;
+  ink_io_uring_close(ring);
+  return -err;
+}
+
+void
+ink_io_uring_close(ink_io_uring *ring)
+{
+  if (ring->sqes != MAP_FAILED) {
+    munmap(ring->sqes, ring->sqes_size);
+  }
+  if (ring->cq_ring != MAP_FAILED && ring->cq_ring != ring->sq_ring) {
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  }
+  if (ring->sq_ring != MAP_FAILED) {
+    munmap(ring->sq_ring, ring->sq_ring_size);
+  }
+  if (ring->fd >= 0) {
+    close(ring->fd);
+  }
+  ring->sq_ring = ring->cq_ring = MAP_FAILED;
+  ring->sqes = (struct io_uring_sqe *)MAP_FAILED;
+  ring->fd = -1;
+}
+
+#endif /* TS_HAS_IO_URING */
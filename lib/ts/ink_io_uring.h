@@ -0,0 +1,153 @@
+/** @file
+
+  Minimal io_uring support for libts
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+/****************************************************************************
+
+  ink_io_uring.h
+
+  The rings are driven through the raw system calls, so liburing is not
+  required. A ring is meant to be used by a single thread: SQEs are taken
+  with ink_io_uring_get_sqe(), made visible to the kernel with
+  ink_io_uring_sqe_ready(), and submitted in batches with
+  ink_io_uring_enter(). Completions are consumed from the shared memory
+  with ink_io_uring_peek_cqe() and ink_io_uring_cqe_seen().
+
+ ****************************************************************************/
+
+#ifndef _ink_io_uring_h_
+#define _ink_io_uring_h_
+
+#include "ink_config.h"
+
+#if HAVE_LINUX_IO_URING_H
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#if defined(__NR_io_uring_setup)
+#define TS_HAS_IO_URING 1
+#endif
+
+#endif
+
+#if TS_HAS_IO_URING
+
+struct ink_io_uring {
+  int fd;
+  unsigned features;
+
+  // Submission queue.
+  unsigned *sq_head;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned sq_entries;
+  struct io_uring_sqe *sqes;
+
+  // Completion queue.
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  unsigned cq_entries;
+  struct io_uring_cqe *cqes;
+
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  size_t sqes_size;
+};
+
+// Set up a ring with at least the given number of submission queue entries. Returns 0, or -errno if the
+// kernel doesn't support io_uring.
+int ink_io_uring_init(ink_io_uring *ring, unsigned entries);
+void ink_io_uring_close(ink_io_uring *ring);
+
+// Return the next SQE, cleared, or NULL if the submission queue is full. The same SQE is returned until it
+// is queued with ink_io_uring_sqe_ready().
+static inline struct io_uring_sqe *
+ink_io_uring_get_sqe(ink_io_uring *ring)
+{
+  unsigned tail = *ring->sq_tail;
+
+  if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >= ring->sq_entries) {
+    return NULL;
+  }
+
+  unsigned idx = tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[idx] = idx;
+  return sqe;
+}
+
+static inline void
+ink_io_uring_sqe_ready(ink_io_uring *ring)
+{
+  __atomic_store_n(ring->sq_tail, *ring->sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+// Submit SQEs, and optionally wait for completions. Returns the number of SQEs consumed, or -errno.
+static inline int
+ink_io_uring_enter(ink_io_uring *ring, unsigned to_submit, unsigned min_complete, unsigned flags, void *arg = NULL,
+                   size_t argsz = 0)
+{
+  int r;
+  do {
+    r = (int)syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, arg, argsz);
+  } while (r < 0 && errno == EINTR && !min_complete);
+  return r < 0 ? -errno : r;
+}
+
+static inline int
+ink_io_uring_register(ink_io_uring *ring, unsigned opcode, const void *arg, unsigned nr_args)
+{
+  int r = (int)syscall(__NR_io_uring_register, ring->fd, opcode, arg, nr_args);
+  return r < 0 ? -errno : r;
+}
+
+// Return the oldest completion, or NULL if there is none. It stays in the queue until
+// ink_io_uring_cqe_seen() is called.
+static inline struct io_uring_cqe *
+ink_io_uring_peek_cqe(ink_io_uring *ring)
+{
+  unsigned head = *ring->cq_head;
+
+  if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+    return NULL;
+  }
+  return &ring->cqes[head & *ring->cq_mask];
+}
+
+static inline void
+ink_io_uring_cqe_seen(ink_io_uring *ring)
+{
+  __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+#endif /* TS_HAS_IO_URING */
+
+#endif /* _ink_io_uring_h_ */
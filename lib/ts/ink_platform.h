@@ -120,6 +120,9 @@
 #if TS_USE_PORT
 #include <port.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 
 
 #ifdef HAVE_VALUES_H
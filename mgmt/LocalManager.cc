@@ -1055,6 +1055,20 @@ LocalManager::bindProxyPort(HttpProxyPort &port)
     _exit(1);
   }
 
+#ifdef SO_REUSEPORT
+  // With per thread accepts, traffic_server opens more sockets on this port, one for each net thread.
+  {
+    bool found;
+    RecInt reuseport = REC_readInteger("proxy.config.net.accept_reuseport", &found);
+    RecInt accept_threads = REC_readInteger("proxy.config.accept_threads", &found);
+    if (reuseport > 0 && accept_threads == 0) {
+      if (setsockopt(port.m_fd, SOL_SOCKET, SO_REUSEPORT, (char *)&one, sizeof(int)) < 0) {
+        mgmt_elog(stderr, 0, "[bindProxyPort] Unable to set SO_REUSEPORT: %d : %s\n", port.m_port, strerror(errno));
+      }
+    }
+  }
+#endif
+
   if (port.m_inbound_transparent_p) {
 #if TS_USE_TPROXY
     Debug("http_tproxy", "Listen port %d inbound transparency enabled.\n", port.m_port);
@@ -73,6 +73,12 @@ public:
   Action *open_write(const HttpCacheKey *key, URL *url, HTTPHdr *request, CacheHTTPInfo *old_info, time_t pin_in_cache, bool retry,
                      bool allow_multiple);
 
+  const HttpCacheKey *
+  get_cache_key() const
+  {
+    return &cache_key;
+  }
+
   CacheVConnection *cache_read_vc;
   CacheVConnection *cache_write_vc;
 
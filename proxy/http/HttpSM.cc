@@ -4335,6 +4335,9 @@ HttpSM::do_cache_lookup_and_read()
 
   HttpCacheKey key;
   Cache::generate_key(&key, c_url, t_state.txn_conf->cache_generation_number);
+  // count the lookup for the cache admission once per transaction, not on each retry
+  if (t_state.cache_info.lookup_count == 1 || t_state.redirect_info.redirect_in_process)
+    cacheProcessor.admission_record(&key.hash);
 
   Action *cache_action_handle =
     cache_sm.open_read(&key, c_url, &t_state.hdr_info.client_request, &(t_state.cache_info.config),
@@ -5737,6 +5740,12 @@ HttpSM::setup_cache_read_transfer()
   if (doc_size != INT64_MAX)
     doc_size += hdr_size;
 
+  // The body goes to the client as is: let the cache hand out the fragments
+  // which are not in memory as ranges of the disk, to be sent with sendfile().
+  if (!t_state.client_info.receive_chunked_response && ua_session->get_netvc() && ua_session->get_netvc()->is_sendfile_capable()) {
+    cache_sm.cache_read_vc->enable_sendfile();
+  }
+
   HttpTunnelProducer *p = tunnel.add_producer(cache_sm.cache_read_vc, doc_size, buf_start, &HttpSM::tunnel_handler_cache_read,
                                               HT_CACHE_READ, "cache read");
   tunnel.add_consumer(ua_entry->vc, cache_sm.cache_read_vc, &HttpSM::tunnel_handler_ua, HT_HTTP_CLIENT, "user agent");
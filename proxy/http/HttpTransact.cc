@@ -1713,7 +1713,9 @@ HttpTransact::OSDNSLookup(State *s)
     // HostDB addresses. We use those if they're different from the CTA.
     // In all cases we now commit to client or HostDB for our source.
     if (s->host_db_info.round_robin) {
-      HostDBInfo *cta = s->host_db_info.rr()->select_next(&s->current.server->addr.sa);
+      // the record may have been replaced since, its round robin data with it
+      HostDBRoundRobin *rr = s->host_db_info.rr();
+      HostDBInfo *cta = rr ? rr->select_next(&s->current.server->addr.sa) : NULL;
       if (cta) {
         // found another addr, lock in host DB.
         s->host_db_info = *cta;
@@ -4358,6 +4360,11 @@ HttpTransact::handle_cache_operation_on_forward_server_response(State *s)
         s->cache_info.action = CACHE_DO_NO_ACTION;
       } else if (s->method == HTTP_WKSIDX_HEAD) {
         s->cache_info.action = CACHE_DO_NO_ACTION;
+      } else if (s->cache_lookup_result == CACHE_LOOKUP_MISS &&
+                 !cacheProcessor.admit(&s->state_machine->get_cache_sm().get_cache_key()->hash,
+                                       s->hdr_info.response_content_length)) {
+        DebugTxn("http_trans", "[hcoofsr] object not admitted to the cache");
+        s->cache_info.action = CACHE_DO_NO_ACTION;
       } else {
         s->cache_info.action = CACHE_DO_WRITE;
       }
@@ -43,6 +43,9 @@ const unsigned HPACK_LEN_STATUS = countof(":status") - 1;
 // Section 6.2), plus 32.
 const static unsigned ADDITIONAL_OCTETS = 32;
 
+// 6.5.2. The initial value of SETTINGS_HEADER_TABLE_SIZE is 4,096 octets.
+const static uint32_t INITIAL_TABLE_SIZE = 4096;
+
 const static uint32_t HEADER_FIELD_LIMIT_LENGTH = 4096;
 
 typedef enum {
@@ -177,6 +180,114 @@ const static struct {
                     {"via", ""},
                     {"www-authenticate", ""}};
 
+static uint32_t
+hpack_hash_name(const char *name, int name_len)
+{
+  ATSHash32FNV1a hash;
+
+  hash.update(name, name_len, ATSHash::nocase());
+  hash.final();
+  return hash.get();
+}
+
+static uint32_t
+hpack_hash_field(const char *name, int name_len, const char *value, int value_len)
+{
+  ATSHash32FNV1a hash;
+
+  hash.update(name, name_len, ATSHash::nocase());
+  hash.update(value, value_len);
+  hash.final();
+  return hash.get();
+}
+
+static inline bool
+hpack_name_equal(const char *a, int a_len, const char *b, int b_len)
+{
+  return a_len == b_len && strncasecmp(a, b, a_len) == 0;
+}
+
+// Hash index of the names of the static table. The entries which share a name are contiguous in the static
+// table, so only the first one of them is indexed.
+class HpackStaticTableIndex
+{
+public:
+  HpackStaticTableIndex()
+  {
+    memset(bucket, 0, sizeof(bucket));
+    memset(next, 0, sizeof(next));
+
+    for (unsigned i = 1; i < TS_HPACK_STATIC_TABLE_ENTRY_NUM; i++) {
+      if (i > 1 && strcmp(STATIC_TABLE[i].name, STATIC_TABLE[i - 1].name) == 0) {
+        continue;
+      }
+
+      name_len[i] = strlen(STATIC_TABLE[i].name);
+      name_hash[i] = hpack_hash_name(STATIC_TABLE[i].name, name_len[i]);
+
+      unsigned b = name_hash[i] % BUCKETS;
+      next[i] = bucket[b];
+      bucket[b] = i;
+    }
+
+    for (unsigned i = 1; i < TS_HPACK_STATIC_TABLE_ENTRY_NUM; i++) {
+      value_len[i] = strlen(STATIC_TABLE[i].value);
+    }
+  }
+
+  HpackLookupResult
+  lookup(const char *name, int len, const char *value, int vlen) const
+  {
+    HpackLookupResult result;
+    uint32_t hash = hpack_hash_name(name, len);
+
+    for (unsigned i = bucket[hash % BUCKETS]; i; i = next[i]) {
+      if (name_hash[i] != hash || !hpack_name_equal(STATIC_TABLE[i].name, name_len[i], name, len)) {
+        continue;
+      }
+
+      result.index = i;
+      result.match = HPACK_NAME_MATCH;
+
+      for (unsigned j = i; j < TS_HPACK_STATIC_TABLE_ENTRY_NUM && strcmp(STATIC_TABLE[j].name, STATIC_TABLE[i].name) == 0; j++) {
+        if (value_len[j] == vlen && memcmp(STATIC_TABLE[j].value, value, vlen) == 0) {
+          result.index = j;
+          result.match = HPACK_EXACT_MATCH;
+          break;
+        }
+      }
+      break;
+    }
+
+    return result;
+  }
+
+private:
+  static const unsigned BUCKETS = 64;
+
+  uint8_t bucket[BUCKETS];
+  uint8_t next[TS_HPACK_STATIC_TABLE_ENTRY_NUM];
+  uint32_t name_hash[TS_HPACK_STATIC_TABLE_ENTRY_NUM];
+  int name_len[TS_HPACK_STATIC_TABLE_ENTRY_NUM];
+  int value_len[TS_HPACK_STATIC_TABLE_ENTRY_NUM];
+};
+
+static const HpackStaticTableIndex static_table_index;
+
+Http2DynamicTable::Http2DynamicTable()
+  : _current_size(0), _settings_dynamic_table_size(0), _entries_inserted(0), _size_update_pending(false),
+    _smallest_pending_size(0), _entries(NULL), _entry_capacity(0), _first_entry(0), _entry_count(0), _data(NULL),
+    _data_capacity(0), _data_head(0), _data_used(0)
+{
+  _settings_dynamic_table_size = INITIAL_TABLE_SIZE;
+}
+
+Http2DynamicTable::~Http2DynamicTable()
+{
+  ats_free(_entries);
+  ats_free(_data);
+}
+
 int
 Http2DynamicTable::get_header_from_indexing_tables(uint32_t index, MIMEFieldWrapper &field) const
 {
@@ -188,14 +299,20 @@ Http2DynamicTable::get_header_from_indexing_tables(uint32_t index, MIMEFieldWrap
     field.name_set(STATIC_TABLE[index].name, strlen(STATIC_TABLE[index].name));
     field.value_set(STATIC_TABLE[index].value, strlen(STATIC_TABLE[index].value));
   } else if (index < TS_HPACK_STATIC_TABLE_ENTRY_NUM + get_current_entry_num()) {
-    const MIMEField *m_field = get_header(index - TS_HPACK_STATIC_TABLE_ENTRY_NUM + 1);
-
-    int name_len, value_len;
-    const char *name = m_field->name_get(&name_len);
-    const char *value = m_field->value_get(&value_len);
-
-    field.name_set(name, name_len);
-    field.value_set(value, value_len);
+    const Entry *e = get_entry(index - TS_HPACK_STATIC_TABLE_ENTRY_NUM + 1);
+    uint32_t len = e->name_len + e->value_len;
+
+    // The strings are contiguous unless they wrap around the end of the ring
+    if (e->offset + len <= _data_capacity) {
+      field.name_set(_data + e->offset, e->name_len);
+      field.value_set(_data + e->offset + e->name_len, e->value_len);
+    } else {
+      ats_scoped_str buf(static_cast<char *>(ats_malloc(len)));
+
+      copy_string(buf, e->offset, len);
+      field.name_set(buf, e->name_len);
+      field.value_set(buf + e->name_len, e->value_len);
+    }
   } else {
     // 3.3.3.  Index Address Space
     // Indices strictly greater than the sum of the lengths of both tables
@@ -206,6 +323,44 @@ Http2DynamicTable::get_header_from_indexing_tables(uint32_t index, MIMEFieldWrap
   return 0;
 }
 
+// Find the entry of the indexing tables the encoder can refer to for a header field. An entry with the same name
+// and value is preferred, and then the static table, whose indices are the smallest.
+HpackLookupResult
+Http2DynamicTable::lookup(const char *name, int name_len, const char *value, int value_len) const
+{
+  HpackLookupResult result = static_table_index.lookup(name, name_len, value, value_len);
+
+  if (result.match == HPACK_EXACT_MATCH) {
+    return result;
+  }
+
+  uint32_t hash = hpack_hash_field(name, name_len, value, value_len);
+  for (Entry *e = _field_index[hash % INDEX_BUCKETS].head; e; e = e->field_link.next) {
+    if (e->field_hash == hash && e->name_len == static_cast<uint32_t>(name_len) &&
+        e->value_len == static_cast<uint32_t>(value_len) && string_equal(e->offset, name_len, name, true) &&
+        string_equal((e->offset + name_len) % _data_capacity, value_len, value, false)) {
+      result.index = TS_HPACK_STATIC_TABLE_ENTRY_NUM + get_index(e);
+      result.match = HPACK_EXACT_MATCH;
+      return result;
+    }
+  }
+
+  if (result.match == HPACK_NAME_MATCH) {
+    return result;
+  }
+
+  hash = hpack_hash_name(name, name_len);
+  for (Entry *e = _name_index[hash % INDEX_BUCKETS].head; e; e = e->name_link.next) {
+    if (e->name_hash == hash && e->name_len == static_cast<uint32_t>(name_len) && string_equal(e->offset, name_len, name, true)) {
+      result.index = TS_HPACK_STATIC_TABLE_ENTRY_NUM + get_index(e);
+      result.match = HPACK_NAME_MATCH;
+      break;
+    }
+  }
+
+  return result;
+}
+
 // 5.2.  Entry Eviction when Header Table Size Changes
 // Whenever the maximum size for the header table is reduced, entries
 // are evicted from the end of the header table until the size of the
@@ -213,20 +368,57 @@ Http2DynamicTable::get_header_from_indexing_tables(uint32_t index, MIMEFieldWrap
 void
 Http2DynamicTable::set_dynamic_table_size(uint32_t new_size)
 {
-  uint32_t old_size = _settings_dynamic_table_size;
-  while (old_size > new_size) {
-    int last_name_len, last_value_len;
-    MIMEField *last_field = _headers.last();
+  while (_current_size > new_size) {
+    evict_last_entry();
+  }
 
-    last_field->name_get(&last_name_len);
-    last_field->value_get(&last_value_len);
-    old_size -= ADDITIONAL_OCTETS + last_name_len + last_value_len;
+  _settings_dynamic_table_size = new_size;
 
-    _headers.remove_index(_headers.length() - 1);
-    _mhdr->field_delete(last_field, false);
+  // Give back the memory the table can't use anymore
+  if (_entry_capacity > new_size / ADDITIONAL_OCTETS || _data_capacity > new_size) {
+    reallocate(min(_entry_capacity, new_size / ADDITIONAL_OCTETS), min(_data_capacity, new_size));
   }
+}
 
-  _settings_dynamic_table_size = new_size;
+void
+Http2DynamicTable::update_encoder_table_size(uint32_t new_size)
+{
+  if (new_size == _settings_dynamic_table_size) {
+    return;
+  }
+
+  if (!_size_update_pending || new_size < _smallest_pending_size) {
+    _smallest_pending_size = new_size;
+  }
+  _size_update_pending = true;
+
+  set_dynamic_table_size(new_size);
+}
+
+int64_t
+Http2DynamicTable::encode_pending_size_update(uint8_t *buf_start, const uint8_t *buf_end)
+{
+  uint8_t *p = buf_start;
+  int64_t len;
+
+  if (!_size_update_pending) {
+    return 0;
+  }
+
+  if (_smallest_pending_size < _settings_dynamic_table_size) {
+    if ((len = encode_dynamic_table_size_update(p, buf_end, _smallest_pending_size)) == -1) {
+      return -1;
+    }
+    p += len;
+  }
+
+  if ((len = encode_dynamic_table_size_update(p, buf_end, _settings_dynamic_table_size)) == -1) {
+    return -1;
+  }
+  p += len;
+
+  _size_update_pending = false;
+  return p - buf_start;
 }
 
 void
@@ -235,32 +427,157 @@ Http2DynamicTable::add_header_field(const MIMEField *field)
   int name_len, value_len;
   const char *name = field->name_get(&name_len);
   const char *value = field->value_get(&value_len);
+
+  add_header_field(name, name_len, value, value_len);
+}
+
+void
+Http2DynamicTable::add_header_field(const char *name, int name_len, const char *value, int value_len)
+{
   uint32_t header_size = ADDITIONAL_OCTETS + name_len + value_len;
 
   if (header_size > _settings_dynamic_table_size) {
     // 5.3. It is not an error to attempt to add an entry that is larger than the maximum size; an
     // attempt to add an entry larger than the entire table causes the table to be emptied of all existing entries.
-    _headers.clear();
-    _mhdr->fields_clear();
-  } else {
-    _current_size += header_size;
-    while (_current_size > _settings_dynamic_table_size) {
-      int last_name_len, last_value_len;
-      MIMEField *last_field = _headers.last();
+    clear();
+    return;
+  }
+
+  while (_current_size + header_size > _settings_dynamic_table_size) {
+    evict_last_entry();
+  }
 
-      last_field->name_get(&last_name_len);
-      last_field->value_get(&last_value_len);
-      _current_size -= ADDITIONAL_OCTETS + last_name_len + last_value_len;
+  // Grow the rings if needed. The strings of the entries take the maximum size minus 32 bytes per entry at most.
+  uint32_t len = name_len + value_len;
+  if (_entry_count == _entry_capacity || _data_used + len > _data_capacity || _data_capacity == 0) {
+    uint32_t entry_capacity = _entry_capacity, data_capacity = _data_capacity;
 
-      _headers.remove_index(_headers.length() - 1);
-      _mhdr->field_delete(last_field, false);
+    if (_entry_count == _entry_capacity) {
+      entry_capacity = min(max(_entry_capacity * 2, 8u), _settings_dynamic_table_size / ADDITIONAL_OCTETS);
     }
+    if (_data_used + len > _data_capacity || _data_capacity == 0) {
+      data_capacity = min(max(_data_capacity * 2, max(_data_used + len, 256u)), _settings_dynamic_table_size);
+    }
+    reallocate(entry_capacity, data_capacity);
+  }
+  ink_assert(_entry_count < _entry_capacity && _data_used + len <= _data_capacity);
+
+  Entry *e = &_entries[(_first_entry + _entry_count) % _entry_capacity];
+  e->offset = _data_head;
+  e->name_len = name_len;
+  e->value_len = value_len;
+  e->name_hash = hpack_hash_name(name, name_len);
+  e->field_hash = hpack_hash_field(name, name_len, value, value_len);
+  e->insert_count = _entries_inserted++;
+  e->name_link.next = e->name_link.prev = NULL;
+  e->field_link.next = e->field_link.prev = NULL;
+
+  // Copy the strings, wrapping around the end of the ring
+  const char *src[2] = {name, value};
+  const uint32_t src_len[2] = {static_cast<uint32_t>(name_len), static_cast<uint32_t>(value_len)};
+  for (int i = 0; i < 2; i++) {
+    uint32_t first = min(src_len[i], _data_capacity - _data_head);
+
+    memcpy(_data + _data_head, src[i], first);
+    memcpy(_data, src[i] + first, src_len[i] - first);
+    _data_head = (_data_head + src_len[i]) % _data_capacity;
+  }
+
+  _name_index[e->name_hash % INDEX_BUCKETS].push(e);
+  _field_index[e->field_hash % INDEX_BUCKETS].push(e);
+  _current_size += header_size;
+  _data_used += len;
+  ++_entry_count;
+}
+
+void
+Http2DynamicTable::copy_string(char *dst, uint32_t offset, uint32_t len) const
+{
+  uint32_t first = min(len, _data_capacity - offset);
+
+  memcpy(dst, _data + offset, first);
+  memcpy(dst + first, _data, len - first);
+}
+
+bool
+Http2DynamicTable::string_equal(uint32_t offset, uint32_t len, const char *str, bool nocase) const
+{
+  uint32_t first = min(len, _data_capacity - offset);
+
+  if (nocase) {
+    return strncasecmp(_data + offset, str, first) == 0 && strncasecmp(_data, str + first, len - first) == 0;
+  } else {
+    return memcmp(_data + offset, str, first) == 0 && memcmp(_data, str + first, len - first) == 0;
+  }
+}
 
-    MIMEField *new_field = _mhdr->field_create(name, name_len);
-    new_field->value_set(_mhdr->m_heap, _mhdr->m_mime, value, value_len);
-    // XXX Because entire Vec instance is copied, Its too expensive!
-    _headers.insert(0, new_field);
+void
+Http2DynamicTable::evict_last_entry()
+{
+  Entry *last = &_entries[_first_entry];
+
+  _current_size -= ADDITIONAL_OCTETS + last->name_len + last->value_len;
+  _data_used -= last->name_len + last->value_len;
+  _name_index[last->name_hash % INDEX_BUCKETS].remove(last);
+  _field_index[last->field_hash % INDEX_BUCKETS].remove(last);
+
+  _first_entry = (_first_entry + 1) % _entry_capacity;
+  --_entry_count;
+}
+
+// Move the entries, oldest first, to the beginning of new rings.
+void
+Http2DynamicTable::reallocate(uint32_t entry_capacity, uint32_t data_capacity)
+{
+  ink_assert(_entry_count <= entry_capacity && _data_used <= data_capacity);
+
+  Entry *entries = entry_capacity ? static_cast<Entry *>(ats_malloc(entry_capacity * sizeof(Entry))) : NULL;
+  char *data = data_capacity ? static_cast<char *>(ats_malloc(data_capacity)) : NULL;
+  uint32_t data_head = 0;
+
+  for (unsigned i = 0; i < INDEX_BUCKETS; i++) {
+    _name_index[i].clear();
+    _field_index[i].clear();
+  }
+
+  for (uint32_t i = 0; i < _entry_count; i++) {
+    Entry *e = &entries[i];
+
+    *e = _entries[(_first_entry + i) % _entry_capacity];
+    copy_string(data + data_head, e->offset, e->name_len + e->value_len);
+    e->offset = data_head;
+    data_head += e->name_len + e->value_len;
+
+    e->name_link.next = e->name_link.prev = NULL;
+    e->field_link.next = e->field_link.prev = NULL;
+    _name_index[e->name_hash % INDEX_BUCKETS].push(e);
+    _field_index[e->field_hash % INDEX_BUCKETS].push(e);
   }
+
+  ats_free(_entries);
+  ats_free(_data);
+
+  _entries = entries;
+  _entry_capacity = entry_capacity;
+  _first_entry = 0;
+  _data = data;
+  _data_capacity = data_capacity;
+  _data_head = data_capacity ? data_head % data_capacity : 0;
+}
+
+void
+Http2DynamicTable::clear()
+{
+  for (unsigned i = 0; i < INDEX_BUCKETS; i++) {
+    _name_index[i].clear();
+    _field_index[i].clear();
+  }
+
+  _first_entry = 0;
+  _entry_count = 0;
+  _data_head = 0;
+  _data_used = 0;
+  _current_size = 0;
 }
 
 // The first byte of an HPACK field unambiguously tells us what
@@ -333,18 +650,30 @@ int64_t
 encode_string(uint8_t *buf_start, const uint8_t *buf_end, const char *value, size_t value_len)
 {
   uint8_t *p = buf_start;
+  const uint8_t *src = reinterpret_cast<const uint8_t *>(value);
+
+  // 5.2. Use Huffman encoding only when it makes the string shorter
+  const int64_t huffman_len = huffman_encode_length(src, value_len);
+  const bool use_huffman = huffman_len < static_cast<int64_t>(value_len);
+  const size_t data_len = use_huffman ? huffman_len : value_len;
 
   // Length
-  const int64_t len = encode_integer(p, buf_end, value_len, 7);
+  const int64_t len = encode_integer(p, buf_end, data_len, 7);
   if (len == -1)
     return -1;
+  if (use_huffman)
+    *p |= 0x80;
   p += len;
-  if (buf_end < p || static_cast<size_t>(buf_end - p) < value_len)
+  if (buf_end < p || static_cast<size_t>(buf_end - p) < data_len)
     return -1;
 
   // Value String
-  memcpy(p, value, value_len);
-  p += value_len;
+  if (use_huffman) {
+    huffman_encode(p, src, value_len);
+  } else {
+    memcpy(p, value, value_len);
+  }
+  p += data_len;
   return p - buf_start;
 }
 
@@ -476,6 +805,78 @@ encode_literal_header_field(uint8_t *buf_start, const uint8_t *buf_end, const MI
   return p - buf_start;
 }
 
+// 6.3. Dynamic Table Size Update
+int64_t
+encode_dynamic_table_size_update(uint8_t *buf_start, const uint8_t *buf_end, uint32_t size)
+{
+  if (buf_start >= buf_end)
+    return -1;
+
+  const int64_t len = encode_integer(buf_start, buf_end, size, 5);
+  if (len == -1)
+    return -1;
+
+  *buf_start |= 0x20;
+
+  return len;
+}
+
+// Choose how a header field which is not in the indexing tables is represented. Fields whose value changes with
+// every response, and fields which would take most of the table, would only evict the entries worth keeping.
+static HpackFieldType
+hpack_literal_field_type(const char *name, int name_len, int value_len, const Http2DynamicTable &dynamic_table)
+{
+  // 7.1.3. Never index values which are worth protecting from compression-based attacks.
+  if (hpack_name_equal(name, name_len, MIME_FIELD_SET_COOKIE, MIME_LEN_SET_COOKIE)) {
+    return HPACK_FIELD_NEVERINDEX_LITERAL;
+  }
+
+  if (hpack_name_equal(name, name_len, MIME_FIELD_DATE, MIME_LEN_DATE) ||
+      hpack_name_equal(name, name_len, MIME_FIELD_CONTENT_LENGTH, MIME_LEN_CONTENT_LENGTH) ||
+      hpack_name_equal(name, name_len, MIME_FIELD_CONTENT_RANGE, MIME_LEN_CONTENT_RANGE) ||
+      hpack_name_equal(name, name_len, MIME_FIELD_ETAG, MIME_LEN_ETAG) ||
+      hpack_name_equal(name, name_len, MIME_FIELD_LAST_MODIFIED, MIME_LEN_LAST_MODIFIED) ||
+      hpack_name_equal(name, name_len, MIME_FIELD_EXPIRES, MIME_LEN_EXPIRES) ||
+      hpack_name_equal(name, name_len, MIME_FIELD_LOCATION, MIME_LEN_LOCATION)) {
+    return HPACK_FIELD_NOINDEX_LITERAL;
+  }
+
+  if (ADDITIONAL_OCTETS + name_len + value_len > dynamic_table.get_dynamic_table_size() / 2) {
+    return HPACK_FIELD_NOINDEX_LITERAL;
+  }
+
+  return HPACK_FIELD_INDEXED_LITERAL;
+}
+
+// Encode a header field with the shortest representation the indexing tables allow, and add it to the dynamic
+// table when the decoder is asked to.
+int64_t
+encode_header_field(uint8_t *buf_start, const uint8_t *buf_end, const MIMEFieldWrapper &header, Http2DynamicTable &dynamic_table)
+{
+  int name_len, value_len;
+  const char *name = header.name_get(&name_len);
+  const char *value = header.value_get(&value_len);
+  int64_t len;
+
+  HpackLookupResult result = dynamic_table.lookup(name, name_len, value, value_len);
+  if (result.match == HPACK_EXACT_MATCH) {
+    return encode_indexed_header_field(buf_start, buf_end, result.index);
+  }
+
+  HpackFieldType type = hpack_literal_field_type(name, name_len, value_len, dynamic_table);
+  if (result.match == HPACK_NAME_MATCH) {
+    len = encode_literal_header_field(buf_start, buf_end, header, result.index, type);
+  } else {
+    len = encode_literal_header_field(buf_start, buf_end, header, type);
+  }
+
+  if (len != -1 && type == HPACK_FIELD_INDEXED_LITERAL) {
+    dynamic_table.add_header_field(header.field_get());
+  }
+
+  return len;
+}
+
 /*
  * 6.1.  Integer representation
  *
@@ -94,45 +94,120 @@ private:
   MIMEHdrImpl *_mh;
 };
 
+// Result of the lookup of a header field in the indexing tables
+enum HpackMatch {
+  HPACK_NO_MATCH,    // Neither the name nor the field is in the tables
+  HPACK_NAME_MATCH,  // The index refers to an entry with the same name
+  HPACK_EXACT_MATCH, // The index refers to an entry with the same name and value
+};
+
+struct HpackLookupResult {
+  HpackLookupResult() : index(0), match(HPACK_NO_MATCH) {}
+
+  uint32_t index;
+  HpackMatch match;
+};
+
 // 2.3.2. Dynamic Table
+//
+// The entries are kept in a ring, and their names and values are copied one after the other into a ring of bytes.
+// Entries are only added at the head and evicted at the tail, so both are O(1), and a string may wrap around the
+// end of the ring of bytes. The rings grow as the table fills up, up to what the maximum size of the table can
+// hold: the size of an entry is the length of its strings plus 32.
+//
+// The entries are also indexed by hashes of their name and of their name and value, so that the encoder can find
+// the entries which it can refer to without scanning the table.
 class Http2DynamicTable
 {
 public:
-  Http2DynamicTable() : _current_size(0), _settings_dynamic_table_size(4096)
+  Http2DynamicTable();
+  ~Http2DynamicTable();
+
+  void add_header_field(const MIMEField *field);
+  void add_header_field(const char *name, int name_len, const char *value, int value_len);
+  int get_header_from_indexing_tables(uint32_t index, MIMEFieldWrapper &header_field) const;
+  HpackLookupResult lookup(const char *name, int name_len, const char *value, int value_len) const;
+  void set_dynamic_table_size(uint32_t new_size);
+
+  uint32_t
+  get_dynamic_table_size() const
   {
-    _mhdr = new MIMEHdr();
-    _mhdr->create();
+    return _settings_dynamic_table_size;
   }
 
-  ~Http2DynamicTable()
+  // Bytes of memory held by the table.
+  size_t
+  get_memory_usage() const
   {
-    _headers.clear();
-    _mhdr->fields_clear();
-    delete _mhdr;
+    return sizeof(*this) + _data_capacity + _entry_capacity * sizeof(Entry);
   }
 
-  void add_header_field(const MIMEField *field);
-  int get_header_from_indexing_tables(uint32_t index, MIMEFieldWrapper &header_field) const;
-  void set_dynamic_table_size(uint32_t new_size);
+  // 4.2. The encoder may use a smaller table than the decoder allows. A change of its size is signaled at the
+  // beginning of the next header block, preceded by the smallest size the table had in between.
+  void update_encoder_table_size(uint32_t new_size);
+  int64_t encode_pending_size_update(uint8_t *buf_start, const uint8_t *buf_end);
 
 private:
-  const MIMEField *
-  get_header(uint32_t index) const
+  Http2DynamicTable(const Http2DynamicTable &);            // noncopyable
+  Http2DynamicTable &operator=(const Http2DynamicTable &); // noncopyable
+
+  struct Entry {
+    uint32_t offset; // Position of the name in the ring of bytes, the value follows it
+    uint32_t name_len;
+    uint32_t value_len;
+    uint32_t name_hash;
+    uint32_t field_hash;
+    uint32_t insert_count; // Value of _entries_inserted when the entry was added
+
+    LINK(Entry, name_link);
+    LINK(Entry, field_link);
+  };
+
+  static const unsigned INDEX_BUCKETS = 64;
+
+  // Index 1 is the newest entry
+  Entry *
+  get_entry(uint32_t index) const
   {
-    return _headers.get(index - 1);
+    return &_entries[(_first_entry + _entry_count - index) % _entry_capacity];
   }
 
   const uint32_t
   get_current_entry_num() const
   {
-    return _headers.length();
+    return _entry_count;
   }
 
+  uint32_t
+  get_index(const Entry *e) const
+  {
+    return _entries_inserted - 1 - e->insert_count;
+  }
+
+  void copy_string(char *dst, uint32_t offset, uint32_t len) const;
+  bool string_equal(uint32_t offset, uint32_t len, const char *str, bool nocase) const;
+  void evict_last_entry();
+  void reallocate(uint32_t entry_capacity, uint32_t data_capacity);
+  void clear();
+
   uint32_t _current_size;
   uint32_t _settings_dynamic_table_size;
-
-  MIMEHdr *_mhdr;
-  Vec<MIMEField *> _headers;
+  uint32_t _entries_inserted;
+  bool _size_update_pending;
+  uint32_t _smallest_pending_size;
+
+  Entry *_entries;
+  uint32_t _entry_capacity;
+  uint32_t _first_entry; // Position of the oldest entry
+  uint32_t _entry_count;
+
+  char *_data;
+  uint32_t _data_capacity;
+  uint32_t _data_head; // Where the strings of the next entry go
+  uint32_t _data_used;
+
+  DLL<Entry, Entry::Link_name_link> _name_index[INDEX_BUCKETS];
+  DLL<Entry, Entry::Link_field_link> _field_index[INDEX_BUCKETS];
 };
 
 HpackFieldType hpack_parse_field_type(uint8_t ftype);
@@ -153,6 +228,9 @@ int64_t encode_literal_header_field(uint8_t *buf_start, const uint8_t *buf_end,
                                     HpackFieldType type);
 int64_t encode_literal_header_field(uint8_t *buf_start, const uint8_t *buf_end, const MIMEFieldWrapper &header,
                                     HpackFieldType type);
+int64_t encode_dynamic_table_size_update(uint8_t *buf_start, const uint8_t *buf_end, uint32_t size);
+int64_t encode_header_field(uint8_t *buf_start, const uint8_t *buf_end, const MIMEFieldWrapper &header,
+                            Http2DynamicTable &dynamic_table);
 
 // When these functions returns minus value, any error occurs
 // TODO Separate error code and length of processed buffer
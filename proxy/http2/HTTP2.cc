@@ -336,7 +336,9 @@ http2_parse_priority_parameter(IOVec iov, Http2Priority &params)
   memcpy_and_advance(dependency.bytes, ptr);
   memcpy_and_advance(params.weight, ptr);
 
-  params.stream_dependency = ntohs(dependency.value);
+  uint32_t value = ntohl(dependency.value);
+  params.exclusive_flag = value & 0x80000000;
+  params.stream_dependency = value & 0x7fffffff;
 
   return true;
 }
@@ -535,7 +537,7 @@ convert_from_2_to_1_1_header(HTTPHdr *headers)
 }
 
 int64_t
-http2_write_psuedo_headers(HTTPHdr *in, uint8_t *out, uint64_t out_len, Http2DynamicTable & /* dynamic_table */)
+http2_write_psuedo_headers(HTTPHdr *in, uint8_t *out, uint64_t out_len, Http2DynamicTable &dynamic_table)
 {
   uint8_t *p = out;
   uint8_t *end = out + out_len;
@@ -543,7 +545,11 @@ http2_write_psuedo_headers(HTTPHdr *in, uint8_t *out, uint64_t out_len, Http2Dyn
 
   ink_assert(http_hdr_type_get(in->m_http) != HTTP_TYPE_UNKNOWN);
 
-  // TODO Check whether buffer size is enough
+  // A change of the size of the dynamic table is signaled at the beginning of the header block
+  len = dynamic_table.encode_pending_size_update(p, end);
+  if (len == -1)
+    return -1;
+  p += len;
 
   // Set psuedo header
   if (http_hdr_type_get(in->m_http) == HTTP_TYPE_RESPONSE) {
@@ -558,7 +564,7 @@ http2_write_psuedo_headers(HTTPHdr *in, uint8_t *out, uint64_t out_len, Http2Dyn
 
     // Encode psuedo headers by HPACK
     MIMEFieldWrapper header(status_field, in->m_heap, in->m_http->m_fields_impl);
-    len = encode_literal_header_field(p, end, header, HPACK_FIELD_NEVERINDEX_LITERAL);
+    len = encode_header_field(p, end, header, dynamic_table);
     if (len == -1)
       return -1;
     p += len;
@@ -572,7 +578,7 @@ http2_write_psuedo_headers(HTTPHdr *in, uint8_t *out, uint64_t out_len, Http2Dyn
 
 int64_t
 http2_write_header_fragment(HTTPHdr *in, MIMEFieldIter &field_iter, uint8_t *out, uint64_t out_len,
-                            Http2DynamicTable & /* dynamic_table */, bool &cont)
+                            Http2DynamicTable &dynamic_table, bool &cont)
 {
   uint8_t *p = out;
   uint8_t *end = out + out_len;
@@ -581,9 +587,6 @@ http2_write_header_fragment(HTTPHdr *in, MIMEFieldIter &field_iter, uint8_t *out
   ink_assert(http_hdr_type_get(in->m_http) != HTTP_TYPE_UNKNOWN);
   ink_assert(in);
 
-  // TODO Get a index value from the tables for the header field, and then choose a representation type.
-  // TODO Each indexing types per field should be passed by a caller, HTTP/2 implementation.
-
   // Get first header field which is required encoding
   MIMEField *field;
   if (!field_iter.m_block) {
@@ -609,7 +612,7 @@ http2_write_header_fragment(HTTPHdr *in, MIMEFieldIter &field_iter, uint8_t *out
     MIMEFieldIter current_iter = field_iter;
     do {
       MIMEFieldWrapper header(field, in->m_heap, in->m_http->m_fields_impl);
-      if ((len = encode_literal_header_field(p, end, header, HPACK_FIELD_INDEXED_LITERAL)) == -1) {
+      if ((len = encode_header_field(p, end, header, dynamic_table)) == -1) {
         if (!cont) {
           // Parsing a part of headers is done
           cont = true;
@@ -748,8 +751,11 @@ uint32_t Http2::max_concurrent_streams = 100;
 uint32_t Http2::initial_window_size = 1048576;
 uint32_t Http2::max_frame_size = 16384;
 uint32_t Http2::header_table_size = 4096;
+uint32_t Http2::encoder_header_table_size = 4096;
 uint32_t Http2::max_header_list_size = 4294967295;
 
+RecRawStatBlock *http2_rsb;
+
 void
 Http2::init()
 {
@@ -757,7 +763,22 @@ Http2::init()
   REC_EstablishStaticConfigInt32U(initial_window_size, "proxy.config.http2.initial_window_size_in");
   REC_EstablishStaticConfigInt32U(max_frame_size, "proxy.config.http2.max_frame_size");
   REC_EstablishStaticConfigInt32U(header_table_size, "proxy.config.http2.header_table_size");
+  REC_EstablishStaticConfigInt32U(encoder_header_table_size, "proxy.config.http2.encoder_header_table_size");
   REC_EstablishStaticConfigInt32U(max_header_list_size, "proxy.config.http2.max_header_list_size");
+
+  http2_rsb = RecAllocateRawStatBlock(static_cast<int>(HTTP2_N_STATS));
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, "proxy.process.http2.data_frames_sent", RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_DATA_FRAMES_SENT), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, "proxy.process.http2.data_bytes_sent", RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_DATA_BYTES_SENT), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, "proxy.process.http2.priority_frames_in", RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_PRIORITY_FRAMES_IN), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, "proxy.process.http2.reprioritizations", RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_REPRIORITIZATIONS), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, "proxy.process.http2.window_stalls", RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_WINDOW_STALLS), RecRawStatSyncSum);
+  RecRegisterRawStat(http2_rsb, RECT_PROCESS, "proxy.process.http2.buffer_stalls", RECD_INT, RECP_PERSISTENT,
+                     static_cast<int>(HTTP2_STAT_BUFFER_STALLS), RecRawStatSyncSum);
 }
 
 
@@ -787,17 +808,21 @@ const static struct {
 } integer_test_case[] = {{10, (uint8_t *) "\x0A", 1, 5}, {1337, (uint8_t *) "\x1F\x9A\x0A", 3, 5}, {42, (uint8_t *) "\x2A", 1, 8}};
 
 // Example: custom-key: custom-header
+// The encoder uses Huffman coding only when it makes the string shorter, the last case is decoded only.
 const static struct {
   char *raw_string;
   uint32_t raw_string_len;
   uint8_t *encoded_field;
   int encoded_field_len;
-} string_test_case[] = {{(char *)"custom-key", 10, (uint8_t *) "\xA"
-                                                               "custom-key",
-                         11},
-                        {(char *)"custom-key", 10, (uint8_t *) "\x88"
+} string_test_case[] = {{(char *)"custom-key", 10, (uint8_t *) "\x88"
                                                                "\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f",
-                         9}};
+                         9},
+                        {(char *)"{}", 2, (uint8_t *) "\x02"
+                                                       "{}",
+                         3},
+                        {(char *)"custom-key", 10, (uint8_t *) "\xA"
+                                                               "custom-key",
+                         11}};
 
 // D.2.4.  Indexed Header Field
 const static struct {
@@ -808,7 +833,7 @@ const static struct {
   int encoded_field_len;
 } indexed_test_case[] = {{2, (char *) ":method", (char *) "GET", (uint8_t *) "\x82", 1}};
 
-// D.2.  Header Field Representation Examples
+// D.2.  Header Field Representation Examples, with Huffman Coding
 const static struct {
   char *raw_name;
   char *raw_value;
@@ -817,41 +842,26 @@ const static struct {
   uint8_t *encoded_field;
   int encoded_field_len;
 } literal_test_case[] = {
-  {(char *)"custom-key", (char *) "custom-header", 0, HPACK_FIELD_INDEXED_LITERAL, (uint8_t *) "\x40\x0a"
-                                                                                               "custom-key\x0d"
-                                                                                               "custom-header",
-   26},
-  {(char *)"custom-key", (char *) "custom-header", 0, HPACK_FIELD_NOINDEX_LITERAL, (uint8_t *) "\x00\x0a"
-                                                                                               "custom-key\x0d"
-                                                                                               "custom-header",
-   26},
-  {(char *)"custom-key", (char *) "custom-header", 0, HPACK_FIELD_NEVERINDEX_LITERAL, (uint8_t *) "\x10\x0a"
-                                                                                                  "custom-key\x0d"
-                                                                                                  "custom-header",
-   26},
-  {(char *)":path", (char *) "/sample/path", 4, HPACK_FIELD_INDEXED_LITERAL, (uint8_t *) "\x44\x0c"
-                                                                                         "/sample/path",
-   14},
-  {(char *)":path", (char *) "/sample/path", 4, HPACK_FIELD_NOINDEX_LITERAL, (uint8_t *) "\x04\x0c"
-                                                                                         "/sample/path",
-   14},
-  {(char *)":path", (char *) "/sample/path", 4, HPACK_FIELD_NEVERINDEX_LITERAL, (uint8_t *) "\x14\x0c"
-                                                                                            "/sample/path",
-   14},
-  {(char *)"password", (char *) "secret", 0, HPACK_FIELD_INDEXED_LITERAL, (uint8_t *) "\x40\x08"
-                                                                                      "password\x06"
-                                                                                      "secret",
-   17},
-  {(char *)"password", (char *) "secret", 0, HPACK_FIELD_NOINDEX_LITERAL, (uint8_t *) "\x00\x08"
-                                                                                      "password\x06"
-                                                                                      "secret",
-   17},
-  {(char *)"password", (char *) "secret", 0, HPACK_FIELD_NEVERINDEX_LITERAL, (uint8_t *) "\x10\x08"
-                                                                                         "password\x06"
-                                                                                         "secret",
-   17}};
-
-// D.3.  Request Examples without Huffman Coding - D.3.1.  First Request
+  {(char *)"custom-key", (char *) "custom-header", 0, HPACK_FIELD_INDEXED_LITERAL,
+   (uint8_t *) "\x40\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f\x89\x25\xa8\x49\xe9\x5a\x72\x8e\x42\xd9", 20},
+  {(char *)"custom-key", (char *) "custom-header", 0, HPACK_FIELD_NOINDEX_LITERAL,
+   (uint8_t *) "\x00\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f\x89\x25\xa8\x49\xe9\x5a\x72\x8e\x42\xd9", 20},
+  {(char *)"custom-key", (char *) "custom-header", 0, HPACK_FIELD_NEVERINDEX_LITERAL,
+   (uint8_t *) "\x10\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f\x89\x25\xa8\x49\xe9\x5a\x72\x8e\x42\xd9", 20},
+  {(char *)":path", (char *) "/sample/path", 4, HPACK_FIELD_INDEXED_LITERAL,
+   (uint8_t *) "\x44\x89\x61\x03\xa6\xba\x0a\xc5\x63\x4c\xff", 11},
+  {(char *)":path", (char *) "/sample/path", 4, HPACK_FIELD_NOINDEX_LITERAL,
+   (uint8_t *) "\x04\x89\x61\x03\xa6\xba\x0a\xc5\x63\x4c\xff", 11},
+  {(char *)":path", (char *) "/sample/path", 4, HPACK_FIELD_NEVERINDEX_LITERAL,
+   (uint8_t *) "\x14\x89\x61\x03\xa6\xba\x0a\xc5\x63\x4c\xff", 11},
+  {(char *)"password", (char *) "secret", 0, HPACK_FIELD_INDEXED_LITERAL,
+   (uint8_t *) "\x40\x86\xac\x68\x47\x83\xd9\x27\x84\x41\x49\x61\x53", 13},
+  {(char *)"password", (char *) "secret", 0, HPACK_FIELD_NOINDEX_LITERAL,
+   (uint8_t *) "\x00\x86\xac\x68\x47\x83\xd9\x27\x84\x41\x49\x61\x53", 13},
+  {(char *)"password", (char *) "secret", 0, HPACK_FIELD_NEVERINDEX_LITERAL,
+   (uint8_t *) "\x10\x86\xac\x68\x47\x83\xd9\x27\x84\x41\x49\x61\x53", 13}};
+
+// D.4.  Request Examples with Huffman Coding - D.4.1.  First Request
 const static struct {
   char *raw_name;
   char *raw_value;
@@ -865,19 +875,11 @@ const static struct {
 const static struct {
   uint8_t *encoded_field;
   int encoded_field_len;
-} encoded_field_test_case[] = {{(uint8_t *)"\x40"
-                                           "\x7:method"
-                                           "\x3GET"
-                                           "\x40"
-                                           "\x7:scheme"
-                                           "\x4http"
-                                           "\x40"
-                                           "\x5:path"
-                                           "\x1/"
-                                           "\x40"
-                                           "\xa:authority"
-                                           "\xfwww.example.com",
-                                64}};
+} encoded_field_test_case[] = {{(uint8_t *)"\x82"
+                                           "\x86"
+                                           "\x84"
+                                           "\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff",
+                                17}};
 
 /***********************************************************************************
  *                                                                                 *
@@ -910,14 +912,13 @@ REGRESSION_TEST(HPACK_EncodeString)(RegressionTest *t, int, int *pstatus)
   uint8_t buf[BUFSIZE_FOR_REGRESSION_TEST];
   int len;
 
-  // FIXME Current encoder don't support huffman conding.
-  for (unsigned int i = 0; i < 1; i++) {
+  for (unsigned int i = 0; i < 2; i++) {
     memset(buf, 0, BUFSIZE_FOR_REGRESSION_TEST);
 
     len = encode_string(buf, buf + BUFSIZE_FOR_REGRESSION_TEST, string_test_case[i].raw_string, string_test_case[i].raw_string_len);
 
     box.check(len == string_test_case[i].encoded_field_len, "encoded length was %d, expecting %d", len,
-              integer_test_case[i].encoded_field_len);
+              string_test_case[i].encoded_field_len);
     box.check(len > 0 && memcmp(buf, string_test_case[i].encoded_field, len) == 0, "encoded string was invalid");
   }
 }
@@ -1011,6 +1012,193 @@ REGRESSION_TEST(HPACK_Encode)(RegressionTest *t, int, int *pstatus)
   }
 }
 
+// Repeated response headers are sent as indexed references, and the header blocks still decode to the fields sent.
+REGRESSION_TEST(HPACK_EncodeWithIndexing)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  const static struct {
+    const char *name;
+    const char *value;
+  } fields[] = {{"Server", "ATS/6.0.0"},
+                {"Cache-Control", "max-age=3600"},
+                {"Content-Type", "text/html"},
+                {"Via", "http/1.1 cache.example.com (ApacheTrafficServer/6.0.0)"},
+                {"Age", "0"},
+                {"Date", "Mon, 21 Oct 2013 20:13:21 GMT"}};
+
+  uint8_t buf[BUFSIZE_FOR_REGRESSION_TEST * 2];
+  int64_t block_len[2];
+  Http2DynamicTable encoder_table;
+  Http2DynamicTable decoder_table;
+
+  hpack_huffman_init();
+
+  for (int n = 0; n < 2; n++) {
+    ats_scoped_obj<HTTPHdr> headers(new HTTPHdr);
+    headers->create(HTTP_TYPE_RESPONSE);
+    headers->status_set(HTTP_STATUS_OK);
+
+    for (unsigned i = 0; i < countof(fields); i++) {
+      MIMEField *field = headers->field_create(fields[i].name, strlen(fields[i].name));
+      field->value_set(headers->m_heap, headers->m_mime, fields[i].value, strlen(fields[i].value));
+      headers->field_attach(field);
+    }
+
+    int64_t len = http2_write_psuedo_headers(headers, buf, sizeof(buf), encoder_table);
+    MIMEFieldIter field_iter;
+    bool cont = false;
+    len += http2_write_header_fragment(headers, field_iter, buf + len, sizeof(buf) - len, encoder_table, cont);
+    block_len[n] = len;
+
+    // Decode the header block field by field, the fields come in the order they were encoded
+    ats_scoped_obj<HTTPHdr> decoded(new HTTPHdr);
+    decoded->create(HTTP_TYPE_RESPONSE);
+
+    const uint8_t *cursor = buf;
+    for (int i = -1; cursor < buf + len && i < static_cast<int>(countof(fields)); i++) {
+      MIMEField *field = mime_field_create(decoded->m_heap, decoded->m_http->m_fields_impl);
+      MIMEFieldWrapper header(field, decoded->m_heap, decoded->m_http->m_fields_impl);
+      int64_t read_bytes;
+
+      if (hpack_parse_field_type(*cursor) == HPACK_FIELD_INDEX) {
+        read_bytes = decode_indexed_header_field(header, cursor, buf + len, decoder_table);
+      } else {
+        read_bytes = decode_literal_header_field(header, cursor, buf + len, decoder_table);
+      }
+      if (read_bytes <= 0) {
+        box.check(false, "decoding failed in block %d", n);
+        break;
+      }
+      cursor += read_bytes;
+
+      int name_len, value_len;
+      const char *name = header.name_get(&name_len);
+      const char *value = header.value_get(&value_len);
+      const char *expected_name = i < 0 ? HPACK_VALUE_STATUS : fields[i].name;
+      const char *expected_value = i < 0 ? "200" : fields[i].value;
+
+      box.check(name_len == static_cast<int>(strlen(expected_name)) && strncasecmp(name, expected_name, name_len) == 0 &&
+                  value_len == static_cast<int>(strlen(expected_value)) && memcmp(value, expected_value, value_len) == 0,
+                "field \"%s\" was not decoded in block %d", expected_name, n);
+    }
+    box.check(cursor == buf + len, "header block %d was not entirely decoded", n);
+  }
+
+  // :status 200 is in the static table, five fields are in the dynamic table and the date is a literal with an
+  // indexed name.
+  int64_t date_len = 2 + 1 + huffman_encode_length(reinterpret_cast<const uint8_t *>(fields[5].value), strlen(fields[5].value));
+  box.check(block_len[1] == 6 + date_len, "second header block was %" PRId64 " bytes, expecting %" PRId64, block_len[1],
+            6 + date_len);
+  box.check(block_len[1] < block_len[0], "second header block was not smaller");
+}
+
+// 6.3. Dynamic Table Size Update: the smallest size is signaled before the final one.
+REGRESSION_TEST(HPACK_EncodeTableSizeUpdate)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  uint8_t buf[BUFSIZE_FOR_REGRESSION_TEST];
+  Http2DynamicTable dynamic_table;
+
+  box.check(dynamic_table.encode_pending_size_update(buf, buf + sizeof(buf)) == 0, "no update should be pending");
+
+  dynamic_table.update_encoder_table_size(0);
+  dynamic_table.update_encoder_table_size(256);
+
+  int64_t len = dynamic_table.encode_pending_size_update(buf, buf + sizeof(buf));
+  box.check(len == 4 && memcmp(buf, "\x20\x3f\xe1\x01", 4) == 0, "invalid size update, length %" PRId64, len);
+  box.check(dynamic_table.get_dynamic_table_size() == 256, "table size was %u", dynamic_table.get_dynamic_table_size());
+  box.check(dynamic_table.encode_pending_size_update(buf, buf + sizeof(buf)) == 0, "update should be sent once");
+}
+
+// Bytes held by a HdrHeap and its string heaps
+static int64_t
+hdr_heap_footprint(HdrHeap *heap)
+{
+  int64_t size = 0;
+
+  for (HdrHeap *h = heap; h; h = h->m_next) {
+    size += h->m_size;
+  }
+  if (heap->m_read_write_heap) {
+    size += heap->m_read_write_heap->m_heap_size;
+  }
+  for (int i = 0; i < HDR_BUF_RONLY_HEAPS; i++) {
+    size += heap->m_ronly_heap[i].m_heap_len;
+  }
+
+  return size;
+}
+
+// Memory held by the dynamic table of a connection after a stream of responses, compared with a MIMEHdr holding
+// the same entries the way the table used to store them.
+REGRESSION_TEST(HPACK_DynamicTableMemory)(RegressionTest *t, int, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  const static struct {
+    const char *name;
+    const char *value;
+  } fields[] = {{"server", "ATS/6.0.0"},
+                {"cache-control", "max-age=3600"},
+                {"content-type", "text/html; charset=utf-8"},
+                {"via", "http/1.1 cache.example.com (ApacheTrafficServer/6.0.0)"},
+                {"age", "0"},
+                {"x-request-id", "7f6c2a10-1b7e-4c1e-9e57-0a8d3c0f1b2e"}};
+  const int responses = 1000;
+
+  Http2DynamicTable dynamic_table;
+  ats_scoped_obj<MIMEHdr> mhdr(new MIMEHdr);
+  Vec<MIMEField *> entries;
+  uint32_t mhdr_size = 0;
+  char value[64];
+
+  mhdr->create();
+
+  for (int n = 0; n < responses; n++) {
+    for (unsigned i = 0; i < countof(fields); i++) {
+      // Some values change with every response, so that the entries keep being evicted
+      int name_len = strlen(fields[i].name);
+      int value_len = snprintf(value, sizeof(value), "%s", fields[i].value);
+      if (i == 4 || i == 5) {
+        value_len = snprintf(value, sizeof(value), "%d-%s", n, fields[i].value);
+      }
+
+      dynamic_table.add_header_field(fields[i].name, name_len, value, value_len);
+
+      uint32_t size = 32 + name_len + value_len;
+      while (mhdr_size + size > 4096) {
+        MIMEField *last = entries.last();
+        int last_name_len, last_value_len;
+
+        last->name_get(&last_name_len);
+        last->value_get(&last_value_len);
+        mhdr_size -= 32 + last_name_len + last_value_len;
+        entries.remove_index(entries.length() - 1);
+        mhdr->field_delete(last, false);
+      }
+
+      MIMEField *field = mhdr->field_create(fields[i].name, name_len);
+      field->value_set(mhdr->m_heap, mhdr->m_mime, value, value_len);
+      entries.insert(0, field);
+      mhdr_size += size;
+    }
+  }
+
+  int64_t table_memory = dynamic_table.get_memory_usage();
+  int64_t mhdr_memory = sizeof(MIMEHdr) + hdr_heap_footprint(mhdr->m_heap) + entries.n * sizeof(MIMEField *);
+
+  rprintf(t, "dynamic table %" PRId64 " bytes, MIMEHdr based table %" PRId64 " bytes\n", table_memory, mhdr_memory);
+  rperf(t, "dynamic_table_bytes", table_memory);
+  rperf(t, "mimehdr_table_bytes", mhdr_memory);
+
+  box.check(table_memory < mhdr_memory, "dynamic table takes %" PRId64 " bytes, more than %" PRId64, table_memory, mhdr_memory);
+}
+
 REGRESSION_TEST(HPACK_DecodeInteger)(RegressionTest *t, int, int *pstatus)
 {
   TestBox box(t, pstatus);
@@ -1090,6 +1278,8 @@ REGRESSION_TEST(HPACK_DecodeLiteralHeaderField)(RegressionTest *t, int, int *pst
 
   Http2DynamicTable dynamic_table;
 
+  hpack_huffman_init();
+
   for (unsigned int i = 0; i < sizeof(literal_test_case) / sizeof(literal_test_case[0]); i++) {
     ats_scoped_obj<HTTPHdr> headers(new HTTPHdr);
     headers->create(HTTP_TYPE_REQUEST);
@@ -1121,6 +1311,8 @@ REGRESSION_TEST(HPACK_Decode)(RegressionTest *t, int, int *pstatus)
 
   Http2DynamicTable dynamic_table;
 
+  hpack_huffman_init();
+
   for (unsigned int i = 0; i < sizeof(encoded_field_test_case) / sizeof(encoded_field_test_case[0]); i++) {
     ats_scoped_obj<HTTPHdr> headers(new HTTPHdr);
     headers->create(HTTP_TYPE_REQUEST);
@@ -1148,4 +1340,59 @@ REGRESSION_TEST(HPACK_Decode)(RegressionTest *t, int, int *pstatus)
   }
 }
 
+// Throughput of the Huffman codec on the strings of the test cases above, in MB of raw strings per second.
+REGRESSION_TEST(HPACK_HuffmanBenchmark)(RegressionTest *t, int atype, int *pstatus)
+{
+  TestBox box(t, pstatus);
+
+  if (atype < REGRESSION_TEST_NIGHTLY) {
+    box = REGRESSION_TEST_NOT_RUN;
+    return;
+  }
+  box = REGRESSION_TEST_PASSED;
+
+  const static char *strings[] = {"custom-key", "custom-header", "/sample/path", "password", "secret", "www.example.com",
+                                  "Mon, 21 Oct 2013 20:13:21 GMT", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1"};
+  const int iterations = 100000;
+  uint8_t encoded[countof(strings)][BUFSIZE_FOR_REGRESSION_TEST];
+  int64_t encoded_len[countof(strings)];
+  char decoded[BUFSIZE_FOR_REGRESSION_TEST * 2];
+  uint64_t total = 0;
+
+  hpack_huffman_init();
+
+  for (unsigned i = 0; i < countof(strings); i++) {
+    total += strlen(strings[i]);
+  }
+  total *= iterations;
+
+  ink_hrtime start = ink_get_hrtime_internal();
+  for (int n = 0; n < iterations; n++) {
+    for (unsigned i = 0; i < countof(strings); i++) {
+      encoded_len[i] = huffman_encode(encoded[i], reinterpret_cast<const uint8_t *>(strings[i]), strlen(strings[i]));
+    }
+  }
+  ink_hrtime encode_time = ink_get_hrtime_internal() - start;
+
+  start = ink_get_hrtime_internal();
+  for (int n = 0; n < iterations; n++) {
+    for (unsigned i = 0; i < countof(strings); i++) {
+      int64_t len = huffman_decode(decoded, encoded[i], encoded_len[i]);
+      if (n == 0) {
+        box.check(len == static_cast<int64_t>(strlen(strings[i])) && memcmp(decoded, strings[i], len) == 0,
+                  "round trip of \"%s\" failed", strings[i]);
+      }
+    }
+  }
+  ink_hrtime decode_time = ink_get_hrtime_internal() - start;
+
+  // Bytes per microsecond is MB per second
+  double encode_rate = static_cast<double>(total) / ink_hrtime_to_usec(encode_time > HRTIME_USECOND ? encode_time : HRTIME_USECOND);
+  double decode_rate = static_cast<double>(total) / ink_hrtime_to_usec(decode_time > HRTIME_USECOND ? decode_time : HRTIME_USECOND);
+
+  rprintf(t, "huffman encode %.1f MB/s, decode %.1f MB/s\n", encode_rate, decode_rate);
+  rperf(t, "huffman_encode_MBps", encode_rate);
+  rperf(t, "huffman_decode_MBps", decode_rate);
+}
+
 #endif /* TS_HAS_TESTS */
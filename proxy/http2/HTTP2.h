@@ -28,6 +28,7 @@
 #include "ink_memory.h"
 #include "HPACK.h"
 #include "MIME.h"
+#include "P_RecProcess.h"
 
 class HTTPHdr;
 
@@ -59,6 +60,10 @@ const uint32_t HTTP2_MAX_FRAME_SIZE = 16384;
 const uint32_t HTTP2_HEADER_TABLE_SIZE = 4096;
 const uint32_t HTTP2_MAX_HEADER_LIST_SIZE = UINT_MAX;
 
+// 5.3.5 Default Priorities
+const uint32_t HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY = 0;
+const uint8_t HTTP2_PRIORITY_DEFAULT_WEIGHT = 15;
+
 // 6.9.1 The Flow Control Window
 static const Http2WindowSize HTTP2_MAX_WINDOW_SIZE = 0x7FFFFFFF;
 
@@ -205,8 +210,14 @@ struct Http2SettingsParameter {
 
 // 6.3 PRIORITY
 struct Http2Priority {
+  Http2Priority()
+    : exclusive_flag(false), weight(HTTP2_PRIORITY_DEFAULT_WEIGHT), stream_dependency(HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY)
+  {
+  }
+
+  bool exclusive_flag;
+  uint8_t weight; // The weight on the wire, the effective weight is this value + 1
   uint32_t stream_dependency;
-  uint8_t weight;
 };
 
 // 6.2 HEADERS Format
@@ -287,6 +298,22 @@ int64_t http2_write_psuedo_headers(HTTPHdr *, uint8_t *, uint64_t, Http2DynamicT
 int64_t http2_write_header_fragment(HTTPHdr *, MIMEFieldIter &, uint8_t *, uint64_t, Http2DynamicTable &, bool &);
 
 
+// Statistics of the stream scheduler, summed over the connections.
+extern RecRawStatBlock *http2_rsb;
+
+enum Http2Stat {
+  HTTP2_STAT_DATA_FRAMES_SENT,   ///< DATA frames sent
+  HTTP2_STAT_DATA_BYTES_SENT,    ///< DATA frame payload bytes sent
+  HTTP2_STAT_PRIORITY_FRAMES_IN, ///< PRIORITY frames received
+  HTTP2_STAT_REPRIORITIZATIONS,  ///< Streams moved in the dependency tree by the client
+  HTTP2_STAT_WINDOW_STALLS,      ///< Streams with data to send blocked by a flow control window
+  HTTP2_STAT_BUFFER_STALLS,      ///< Scheduler passes stopped by a full session write buffer
+  HTTP2_N_STATS                  ///< Terminal counter, NOT A STAT INDEX.
+};
+
+#define HTTP2_INCREMENT_THREAD_DYN_STAT(_s, _t) RecIncrRawStat(http2_rsb, _t, (int)_s, 1);
+#define HTTP2_SUM_THREAD_DYN_STAT(_s, _t, _v) RecIncrRawStat(http2_rsb, _t, (int)_s, _v);
+
 // Not sure where else to put this, but figure this is as good of a start as anything else.
 // Right now, only the static init() is available, which sets up some basic librecords
 // dependencies.
@@ -297,6 +324,7 @@ public:
   static uint32_t initial_window_size;
   static uint32_t max_frame_size;
   static uint32_t header_table_size;
+  static uint32_t encoder_header_table_size;
   static uint32_t max_header_list_size;
 
   static void init();
@@ -230,16 +230,12 @@ Http2ClientSession::main_event_handler(int event, void *edata)
     // After sending GOAWAY, close the connection
     if (this->connection_state.is_state_closed() && write_vio->ntodo() <= 0) {
       this->do_io_close();
+    } else if (!this->connection_state.is_state_closed()) {
+      // Let the scheduler refill the write buffer with DATA frames
+      send_connection_event(&this->connection_state, HTTP2_SESSION_EVENT_DRAIN, this);
     }
     return 0;
 
-  case TS_FETCH_EVENT_EXT_HEAD_DONE:
-  case TS_FETCH_EVENT_EXT_BODY_READY:
-  case TS_FETCH_EVENT_EXT_BODY_DONE:
-    // Process responses from origin server
-    send_connection_event(&this->connection_state, event, edata);
-    return 0;
-
   default:
     DebugHttp2Ssn("unexpected event=%d edata=%p", event, edata);
     ink_release_assert(0);
@@ -33,11 +33,13 @@
 // HTTP2_SESSION_EVENT_FINI   Http2ClientSession *  HTTP/2 session is ended
 // HTTP2_SESSION_EVENT_RECV   Http2Frame *          Received a frame
 // HTTP2_SESSION_EVENT_XMIT   Http2Frame *          Send this frame
+// HTTP2_SESSION_EVENT_DRAIN  Http2ClientSession *  Write buffer was drained, more frames can be sent
 
 #define HTTP2_SESSION_EVENT_INIT (HTTP2_SESSION_EVENTS_START + 1)
 #define HTTP2_SESSION_EVENT_FINI (HTTP2_SESSION_EVENTS_START + 2)
 #define HTTP2_SESSION_EVENT_RECV (HTTP2_SESSION_EVENTS_START + 3)
 #define HTTP2_SESSION_EVENT_XMIT (HTTP2_SESSION_EVENTS_START + 4)
+#define HTTP2_SESSION_EVENT_DRAIN (HTTP2_SESSION_EVENTS_START + 5)
 
 static size_t const HTTP2_HEADER_BUFFER_SIZE_INDEX = CLIENT_CONNECTION_FIRST_READ_BUFFER_SIZE_INDEX;
 
@@ -63,13 +65,13 @@ struct Http2UpgradeContext {
 class Http2Frame
 {
 public:
-  Http2Frame(const Http2FrameHeader &h, IOBufferReader *r)
+  Http2Frame(const Http2FrameHeader &h, IOBufferReader *r) : payload_reader(NULL), payload_length(0)
   {
     this->hdr.cooked = h;
     this->ioreader = r;
   }
 
-  Http2Frame(Http2FrameType type, Http2StreamId streamid, uint8_t flags)
+  Http2Frame(Http2FrameType type, Http2StreamId streamid, uint8_t flags) : payload_reader(NULL), payload_length(0)
   {
     Http2FrameHeader hdr = {0, (uint8_t)type, flags, streamid};
     http2_write_frame_header(hdr, make_iovec(this->hdr.raw));
@@ -120,6 +122,21 @@ public:
     }
   }
 
+  // Finalize a frame whose payload is the next nbytes of the given reader. The payload is not copied into
+  // the frame, it is cloned into the write buffer by xmit(). The reader is not consumed.
+  void
+  finalize(IOBufferReader *reader, size_t nbytes)
+  {
+    ink_assert(this->ioblock && this->ioblock->size() == HTTP2_FRAME_HEADER_LEN);
+    ink_assert((int64_t)nbytes <= reader->read_avail());
+
+    this->payload_reader = reader;
+    this->payload_length = nbytes;
+
+    this->hdr.cooked.length = nbytes;
+    http2_write_frame_header(this->hdr.cooked, make_iovec(this->ioblock->start(), HTTP2_FRAME_HEADER_LEN));
+  }
+
   void
   xmit(MIOBuffer *iobuffer)
   {
@@ -128,6 +145,10 @@ public:
     } else {
       iobuffer->write(this->hdr.raw, sizeof(this->hdr.raw));
     }
+
+    if (payload_reader && payload_length > 0) {
+      iobuffer->write(payload_reader, payload_length);
+    }
   }
 
 private:
@@ -136,6 +157,8 @@ private:
 
   Ptr<IOBufferBlock> ioblock;
   IOBufferReader *ioreader;
+  IOBufferReader *payload_reader;
+  int64_t payload_length;
 
   union {
     Http2FrameHeader cooked;
@@ -191,6 +214,13 @@ public:
     write_vio->reenable();
   }
 
+  // Bytes of the frames which are not written to the network yet
+  int64_t
+  write_buffer_pending() const
+  {
+    return sm_writer->read_avail();
+  }
+
   void set_upgrade_context(HTTPHdr *h);
   const Http2UpgradeContext &
   get_upgrade_context() const
@@ -27,13 +27,13 @@
 
 #define DebugHttp2Ssn(fmt, ...) DebugSsn("http2_cs", "[%" PRId64 "] " fmt, this->con_id, __VA_ARGS__)
 
-// Currently use only HTTP/1.1 for requesting to origin server
-const static char *HTTP2_FETCHING_HTTP_VERSION = "HTTP/1.1";
+// Upper bound of the frames waiting in the session write buffer before the scheduler picks the next DATA frame
+static const int64_t HTTP2_DATA_FRAME_WATER_MARK = 4 * HTTP2_MAX_FRAME_SIZE;
 
 typedef Http2ErrorCode (*http2_frame_dispatch)(Http2ClientSession &, Http2ConnectionState &, const Http2Frame &);
 
 static const int buffer_size_index[HTTP2_FRAME_TYPE_MAX] = {
-  BUFFER_SIZE_INDEX_8K,  // HTTP2_FRAME_TYPE_DATA
+  BUFFER_SIZE_INDEX_128, // HTTP2_FRAME_TYPE_DATA
   BUFFER_SIZE_INDEX_4K,  // HTTP2_FRAME_TYPE_HEADERS
   -1,                    // HTTP2_FRAME_TYPE_PRIORITY
   BUFFER_SIZE_INDEX_128, // HTTP2_FRAME_TYPE_RST_STREAM
@@ -63,7 +63,6 @@ read_rcv_buffer(char *buf, size_t bufsize, unsigned &nbytes, const Http2Frame &f
 static Http2ErrorCode
 rcv_data_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const Http2Frame &frame)
 {
-  char buf[BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_DATA])];
   unsigned nbytes = 0;
   Http2StreamId id = frame.header().streamid;
   Http2Stream *stream = cstate.find_stream(id);
@@ -98,8 +97,9 @@ rcv_data_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const Http2
 
   if (frame.header().flags & HTTP2_FLAGS_DATA_PADDED) {
     frame.reader()->memcpy(&pad_length, HTTP2_DATA_PADLEN_LEN, nbytes);
+    nbytes += HTTP2_DATA_PADLEN_LEN;
 
-    if (pad_length > payload_length) {
+    if (pad_length >= payload_length) {
       // If the length of the padding is the length of the
       // frame payload or greater, the recipient MUST treat this as a
       // connection error of type PROTOCOL_ERROR.
@@ -109,6 +109,9 @@ rcv_data_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const Http2
 
   // If Data length is 0, do nothing.
   if (payload_length == 0) {
+    if (frame.header().flags & HTTP2_FLAGS_DATA_END_STREAM) {
+      stream->mark_request_done();
+    }
     return HTTP2_ERROR_NO_ERROR;
   }
 
@@ -121,13 +124,11 @@ rcv_data_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const Http2
   cstate.server_rwnd -= payload_length;
   stream->server_rwnd -= payload_length;
 
+  // Hand the payload over to the transaction. The frame buffer blocks are shared, not copied.
   const uint32_t unpadded_length = payload_length - pad_length;
-  while (nbytes < payload_length - pad_length) {
-    size_t read_len = sizeof(buf);
-    if (nbytes + read_len > unpadded_length)
-      read_len -= nbytes + read_len - unpadded_length;
-    unsigned read_bytes = read_rcv_buffer(buf, read_len, nbytes, frame);
-    stream->set_body_to_fetcher(buf, read_bytes);
+  stream->write_request_data(frame.reader(), nbytes, unpadded_length - nbytes);
+  if (frame.header().flags & HTTP2_FLAGS_DATA_END_STREAM) {
+    stream->mark_request_done();
   }
 
   uint32_t initial_rwnd = cstate.server_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE);
@@ -199,13 +200,21 @@ rcv_headers_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const Ht
   }
 
   // Check whether parameters of priority exist or not.
-  // TODO Currently priority is NOT supported.
   if (frame.header().flags & HTTP2_FLAGS_HEADERS_PRIORITY) {
     frame.reader()->memcpy(buf, HTTP2_PRIORITY_LEN, nbytes);
     nbytes += HTTP2_PRIORITY_LEN;
     if (!http2_parse_priority_parameter(make_iovec(buf, HTTP2_PRIORITY_LEN), params.priority)) {
       return HTTP2_ERROR_PROTOCOL_ERROR;
     }
+
+    // 5.3.1. A stream cannot depend on itself. The header block still has to be decoded to keep the
+    // HPACK state in sync, so this is treated as a connection error rather than a stream error.
+    if (params.priority.stream_dependency == id) {
+      return HTTP2_ERROR_PROTOCOL_ERROR;
+    }
+
+    // The stream was just created, this sets its initial priority.
+    cstate.reprioritize_stream(id, params.priority, false);
   }
 
   // Parse request headers encoded by HPACK
@@ -243,17 +252,28 @@ rcv_headers_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const Ht
     }
   }
 
-  // backposting
+  if (frame.header().flags & HTTP2_FLAGS_HEADERS_END_STREAM) {
+    stream->mark_request_done();
+  }
+
+  // Start the transaction once the whole header block is decoded
   if (frame.header().flags & HTTP2_FLAGS_HEADERS_END_HEADERS) {
-    stream->init_fetcher(cstate);
+    if (!stream->new_transaction()) {
+      cstate.send_rst_stream_frame(id, HTTP2_ERROR_PROTOCOL_ERROR);
+      cstate.delete_stream(stream);
+    }
   }
 
   return HTTP2_ERROR_NO_ERROR;
 }
 
 static Http2ErrorCode
-rcv_priority_frame(Http2ClientSession &cs, Http2ConnectionState & /*cstate*/, const Http2Frame &frame)
+rcv_priority_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const Http2Frame &frame)
 {
+  char buf[HTTP2_PRIORITY_LEN];
+  Http2Priority priority;
+  const Http2StreamId id = frame.header().streamid;
+
   DebugSsn(&cs, "http2_cs", "[%" PRId64 "] received PRIORITY frame", cs.connection_id());
 
   // If a PRIORITY frame is received with a stream identifier of 0x0, the
@@ -268,8 +288,24 @@ rcv_priority_frame(Http2ClientSession &cs, Http2ConnectionState & /*cstate*/, co
     return HTTP2_ERROR_FRAME_SIZE_ERROR;
   }
 
-  // TODO Pick stream dependencies and weight
-  // Supporting PRIORITY is not essential so its temporarily ignored.
+  frame.reader()->memcpy(buf, sizeof(buf), 0);
+  if (!http2_parse_priority_parameter(make_iovec(buf, sizeof(buf)), priority)) {
+    return HTTP2_ERROR_PROTOCOL_ERROR;
+  }
+  ++cstate.scheduler_stats.priority_frames;
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_PRIORITY_FRAMES_IN, this_ethread());
+
+  // 5.3.1. A stream cannot depend on itself. An endpoint MUST treat this as a
+  // stream error of type PROTOCOL_ERROR.
+  if (priority.stream_dependency == id) {
+    cstate.send_rst_stream_frame(id, HTTP2_ERROR_PROTOCOL_ERROR);
+    return HTTP2_ERROR_NO_ERROR;
+  }
+
+  DebugSsn(&cs, "http2_priority", "[%" PRId64 "] PRIORITY: Stream ID: %u, Dependency: %u, Weight: %u, Exclusive: %d",
+           cs.connection_id(), id, priority.stream_dependency, priority.weight + 1, priority.exclusive_flag);
+
+  cstate.reprioritize_stream(id, priority, true);
 
   return HTTP2_ERROR_NO_ERROR;
 }
@@ -355,6 +391,11 @@ rcv_settings_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const H
       cstate.update_initial_rwnd(param.value);
     }
 
+    // 4.2. The encoder may use any table size up to the size the client's decoder allows.
+    if (param.id == HTTP2_SETTINGS_HEADER_TABLE_SIZE) {
+      cstate.remote_dynamic_table->update_encoder_table_size(min(param.value, Http2::encoder_header_table_size));
+    }
+
     cstate.client_settings.set((Http2SettingsIdentifier)param.id, param.value);
   }
 
@@ -363,6 +404,9 @@ rcv_settings_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, const H
   Http2Frame ackFrame(HTTP2_FRAME_TYPE_SETTINGS, 0, HTTP2_FLAGS_SETTINGS_ACK);
   cstate.ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &ackFrame);
 
+  // The stream windows may have been opened by a new SETTINGS_INITIAL_WINDOW_SIZE.
+  cstate.restart_streams();
+
   return HTTP2_ERROR_NO_ERROR;
 }
 
@@ -493,9 +537,8 @@ rcv_window_update_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, co
     }
 
     stream->client_rwnd += size;
-    ssize_t wnd = min(cstate.client_rwnd, stream->client_rwnd);
-    if (wnd > 0) {
-      cstate.send_data_frame(stream->get_fetcher());
+    if (stream->client_rwnd > 0) {
+      cstate.send_data_frame(stream);
     }
   }
 
@@ -565,10 +608,13 @@ rcv_continuation_frame(Http2ClientSession &cs, Http2ConnectionState &cstate, con
     }
   }
 
-  // backposting
+  // Start the transaction once the whole header block is decoded
   if (frame.header().flags & HTTP2_FLAGS_HEADERS_END_HEADERS) {
     cstate.finish_continued_headers();
-    stream->init_fetcher(cstate);
+    if (!stream->new_transaction()) {
+      cstate.send_rst_stream_frame(stream_id, HTTP2_ERROR_PROTOCOL_ERROR);
+      cstate.delete_stream(stream);
+    }
   }
 
   return HTTP2_ERROR_NO_ERROR;
@@ -664,26 +710,9 @@ Http2ConnectionState::main_event_handler(int event, void *edata)
     return 0;
   }
 
-  // Process response headers from origin server
-  case TS_FETCH_EVENT_EXT_HEAD_DONE: {
-    FetchSM *fetch_sm = reinterpret_cast<FetchSM *>(edata);
-    this->send_headers_frame(fetch_sm);
-    return 0;
-  }
-
-  // Process a part of response body from origin server
-  case TS_FETCH_EVENT_EXT_BODY_READY: {
-    FetchSM *fetch_sm = reinterpret_cast<FetchSM *>(edata);
-    this->send_data_frame(fetch_sm);
-    return 0;
-  }
-
-  // Process final part of response body from origin server
-  case TS_FETCH_EVENT_EXT_BODY_DONE: {
-    FetchSM *fetch_sm = reinterpret_cast<FetchSM *>(edata);
-    Http2Stream *stream = static_cast<Http2Stream *>(fetch_sm->ext_get_user_data());
-    stream->mark_body_done();
-    this->send_data_frame(fetch_sm);
+  // The session can take more frames
+  case HTTP2_SESSION_EVENT_DRAIN: {
+    this->send_data_frames();
     return 0;
   }
 
@@ -719,10 +748,22 @@ Http2ConnectionState::create_stream(Http2StreamId new_id)
     return NULL;
   }
 
-  Http2Stream *new_stream = new Http2Stream(new_id, client_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE));
+  Http2Stream *new_stream = new Http2Stream(this, new_id, client_settings.get(HTTP2_SETTINGS_INITIAL_WINDOW_SIZE));
   stream_list.push(new_stream);
   latest_streamid = new_id;
 
+  // A PRIORITY frame may have placed the stream into the tree while it was idle.
+  Http2DependencyTree::Node *node = dependency_tree.find(new_id);
+  if (node == NULL) {
+    node = dependency_tree.add(HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY, new_id, HTTP2_PRIORITY_DEFAULT_WEIGHT + 1, false, new_stream);
+  }
+  node->stream = new_stream;
+  new_stream->priority_node = node;
+
+  if (dependency_tree.size() > scheduler_stats.max_active_streams) {
+    scheduler_stats.max_active_streams = dependency_tree.size();
+  }
+
   ink_assert(client_streams_count < UINT32_MAX);
   ++client_streams_count;
 
@@ -742,16 +783,15 @@ Http2ConnectionState::find_stream(Http2StreamId id) const
 void
 Http2ConnectionState::restart_streams()
 {
-  // Currently lookup retryable streams sequentially.
-  // TODO considering to stream weight and dependencies.
-  Http2Stream *s = stream_list.head;
-  while (s) {
-    Http2Stream *next = s->link.next;
-    if (min(this->client_rwnd, s->client_rwnd) > 0) {
-      this->send_data_frame(s->get_fetcher());
+  // Put back into the scheduler the streams whose window is open again
+  for (Http2Stream *s = stream_list.head; s; s = s->link.next) {
+    IOBufferReader *reader = s->get_response_data_reader();
+    if (s->priority_node && s->client_rwnd > 0 && reader && (reader->read_avail() > 0 || s->is_body_done())) {
+      dependency_tree.activate(s->priority_node);
     }
-    s = next;
   }
+
+  this->send_data_frames();
 }
 
 void
@@ -761,10 +801,40 @@ Http2ConnectionState::cleanup_streams()
   while (s) {
     Http2Stream *next = s->link.next;
     stream_list.remove(s);
-    delete s;
+    s->priority_node = NULL;
+    s->detach_connection();
     s = next;
   }
   client_streams_count = 0;
+
+  if (dependency_tree.size() > 0 || scheduler_stats.data_frames > 0) {
+    Debug("http2_priority", "scheduler stats: data_frames=%" PRIu64 " data_bytes=%" PRIu64 " priority_frames=%" PRIu64
+                            " reprioritizations=%" PRIu64 " window_stalls=%" PRIu64 " buffer_stalls=%" PRIu64 " max_streams=%u",
+          scheduler_stats.data_frames, scheduler_stats.data_bytes, scheduler_stats.priority_frames,
+          scheduler_stats.reprioritizations, scheduler_stats.window_stalls, scheduler_stats.buffer_stalls,
+          scheduler_stats.max_active_streams);
+  }
+  dependency_tree.clear();
+}
+
+// Apply the priority given by a HEADERS or a PRIORITY frame. A PRIORITY frame may refer to an idle stream, in
+// which case a node is created so that other streams can depend on it. Only the changes of the priority of a
+// stream already in the tree are counted as reprioritizations, not the priority a stream is opened with.
+void
+Http2ConnectionState::reprioritize_stream(Http2StreamId id, const Http2Priority &priority, bool reprioritization)
+{
+  Http2DependencyTree::Node *node = dependency_tree.find(id);
+  uint32_t weight = priority.weight + 1;
+
+  if (node != NULL) {
+    dependency_tree.reprioritize(node, priority.stream_dependency, weight, priority.exclusive_flag);
+    if (reprioritization) {
+      ++scheduler_stats.reprioritizations;
+      HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_REPRIORITIZATIONS, this_ethread());
+    }
+  } else if (id > latest_streamid && dependency_tree.size() < client_streams_count + server_settings.get(HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS)) {
+    dependency_tree.add(priority.stream_dependency, id, weight, priority.exclusive_flag, NULL);
+  }
 }
 
 void
@@ -797,7 +867,11 @@ void
 Http2ConnectionState::delete_stream(Http2Stream *stream)
 {
   stream_list.remove(stream);
-  delete stream;
+  if (stream->priority_node) {
+    dependency_tree.remove(stream->priority_node);
+    stream->priority_node = NULL;
+  }
+  stream->detach_connection();
 
   ink_assert(client_streams_count > 0);
   --client_streams_count;
@@ -812,79 +886,156 @@ Http2ConnectionState::update_initial_rwnd(Http2WindowSize new_size)
   }
 }
 
+// The stream may have something to send, let the scheduler decide when it goes out.
 void
-Http2ConnectionState::send_data_frame(FetchSM *fetch_sm)
+Http2ConnectionState::send_data_frame(Http2Stream *stream)
 {
-  size_t buf_len = BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_DATA]) - HTTP2_FRAME_HEADER_LEN;
-  uint8_t payload_buffer[buf_len];
+  IOBufferReader *reader = stream->get_response_data_reader();
 
-  DebugSsn(this->ua_session, "http2_cs", "[%" PRId64 "] Send DATA frame.", this->ua_session->connection_id());
+  // Response header is not sent yet
+  if (reader == NULL || stream->priority_node == NULL) {
+    return;
+  }
 
-  Http2Stream *stream = static_cast<Http2Stream *>(fetch_sm->ext_get_user_data());
+  if (reader->read_avail() > 0 || stream->is_body_done()) {
+    dependency_tree.activate(stream->priority_node);
+  }
 
-  for (;;) {
-    uint8_t flags = 0x00;
+  this->send_data_frames();
+}
 
-    // Select appropriate payload size
-    if (this->client_rwnd <= 0 || stream->client_rwnd <= 0)
-      break;
-    size_t window_size = min(this->client_rwnd, stream->client_rwnd);
-    size_t send_size = min(buf_len, window_size);
+// Send DATA frames in the order given by the dependency tree, until nothing is left to send or the session
+// write buffer is full. Keeping the write buffer short is what lets a higher priority stream overtake the
+// streams which are already sending.
+void
+Http2ConnectionState::send_data_frames()
+{
+  while (!this->is_state_closed()) {
+    if (this->ua_session->write_buffer_pending() >= HTTP2_DATA_FRAME_WATER_MARK) {
+      ++scheduler_stats.buffer_stalls;
+      HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_BUFFER_STALLS, this_ethread());
+      return;
+    }
 
-    size_t payload_length = fetch_sm->ext_read_data(reinterpret_cast<char *>(payload_buffer), send_size);
+    Http2DependencyTree::Node *node = dependency_tree.top();
+    if (node == NULL) {
+      return;
+    }
 
-    // If we break here, we never send the END_STREAM in the case of a
-    // early terminating OS.  Ok if there is no body yet.  Otherwise
-    // continue on to delete the stream
-    if (payload_length == 0 && !stream->is_body_done()) {
+    size_t payload_length = 0;
+    switch (this->send_a_data_frame(node->stream, payload_length)) {
+    case HTTP2_SEND_DATA_FRAME_NO_ERROR:
+      dependency_tree.update(node, payload_length);
+      break;
+    case HTTP2_SEND_DATA_FRAME_STREAM_WINDOW:
+      ++scheduler_stats.window_stalls;
+      HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_WINDOW_STALLS, this_ethread());
+    // fallthrough
+    case HTTP2_SEND_DATA_FRAME_NO_PAYLOAD:
+      // The stream is activated again by a WINDOW_UPDATE or by more data from the transaction.
+      dependency_tree.deactivate(node);
+      break;
+    case HTTP2_SEND_DATA_FRAME_CONNECTION_WINDOW:
+      // Every stream is blocked, restart_streams() resumes the scheduler.
+      ++scheduler_stats.window_stalls;
+      HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_WINDOW_STALLS, this_ethread());
+      return;
+    case HTTP2_SEND_DATA_FRAME_DONE:
+      // The stream and its node are gone.
       break;
     }
+  }
+}
 
-    // Update window size
-    this->client_rwnd -= payload_length;
-    stream->client_rwnd -= payload_length;
+Http2ConnectionState::Http2SendDataFrameResult
+Http2ConnectionState::send_a_data_frame(Http2Stream *stream, size_t &payload_length)
+{
+  IOBufferReader *reader = stream->get_response_data_reader();
+  uint8_t flags = 0x00;
 
-    if (stream->is_body_done() && payload_length < send_size) {
-      flags |= HTTP2_FLAGS_DATA_END_STREAM;
-    }
+  if (reader == NULL) {
+    return HTTP2_SEND_DATA_FRAME_NO_PAYLOAD;
+  }
 
-    // Create frame
-    Http2Frame data(HTTP2_FRAME_TYPE_DATA, stream->get_id(), flags);
-    data.alloc(buffer_size_index[HTTP2_FRAME_TYPE_DATA]);
-    http2_write_data(payload_buffer, payload_length, data.write());
-    data.finalize(payload_length);
+  int64_t avail = reader->read_avail();
 
-    // Change state to 'closed' if its end of DATAs.
-    if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
-      if (!stream->change_state(data.header().type, data.header().flags)) {
-        this->send_goaway_frame(stream->get_id(), HTTP2_ERROR_PROTOCOL_ERROR);
-      }
+  // If we break here, we never send the END_STREAM in the case of a
+  // early terminating OS.  Ok if there is no body yet.  Otherwise
+  // continue on to delete the stream
+  if (avail == 0 && !stream->is_body_done()) {
+    return HTTP2_SEND_DATA_FRAME_NO_PAYLOAD;
+  }
+
+  // Select appropriate payload size. A window may be negative after the client lowered
+  // SETTINGS_INITIAL_WINDOW_SIZE, so the windows are checked before anything is taken out of them. The empty
+  // frame which ends a stream does not need any window.
+  int64_t send_size = 0;
+  if (avail > 0) {
+    if (stream->client_rwnd <= 0) {
+      return HTTP2_SEND_DATA_FRAME_STREAM_WINDOW;
+    }
+    if (this->client_rwnd <= 0) {
+      return HTTP2_SEND_DATA_FRAME_CONNECTION_WINDOW;
     }
+    int64_t window_size = min(this->client_rwnd, stream->client_rwnd);
+    send_size = min(min((int64_t)client_settings.get(HTTP2_SETTINGS_MAX_FRAME_SIZE), window_size), avail);
+  }
 
-    // xmit event
-    SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
-    this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &data);
+  // Update window size
+  this->client_rwnd -= send_size;
+  stream->client_rwnd -= send_size;
 
-    if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
-      // Delete a stream immediately
-      // TODO its should not be deleted for a several time to handling RST_STREAM and WINDOW_UPDATE.
-      // See 'closed' state written at https://tools.ietf.org/html/draft-ietf-httpbis-http2-16#section-5.1
-      this->delete_stream(stream);
-      break;
+  if (stream->is_body_done() && send_size == avail) {
+    flags |= HTTP2_FLAGS_DATA_END_STREAM;
+  }
+
+  DebugSsn(this->ua_session, "http2_cs", "[%" PRId64 "] Send DATA frame. Stream ID: %u, Length: %" PRId64,
+           this->ua_session->connection_id(), stream->get_id(), send_size);
+
+  // Create frame. The payload is not copied, the frame refers to the response blocks of the stream.
+  Http2Frame data(HTTP2_FRAME_TYPE_DATA, stream->get_id(), flags);
+  data.alloc(buffer_size_index[HTTP2_FRAME_TYPE_DATA]);
+  data.finalize(reader, send_size);
+
+  // Change state to 'closed' if its end of DATAs.
+  if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
+    if (!stream->change_state(data.header().type, data.header().flags)) {
+      this->send_goaway_frame(stream->get_id(), HTTP2_ERROR_PROTOCOL_ERROR);
+      return HTTP2_SEND_DATA_FRAME_DONE;
     }
   }
+
+  // xmit event
+  SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
+  this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &data);
+  stream->consume_response_data(send_size);
+
+  payload_length = send_size;
+  ++scheduler_stats.data_frames;
+  scheduler_stats.data_bytes += send_size;
+  HTTP2_INCREMENT_THREAD_DYN_STAT(HTTP2_STAT_DATA_FRAMES_SENT, this_ethread());
+  HTTP2_SUM_THREAD_DYN_STAT(HTTP2_STAT_DATA_BYTES_SENT, this_ethread(), send_size);
+
+  if (flags & HTTP2_FLAGS_DATA_END_STREAM) {
+    // Delete a stream immediately
+    // TODO its should not be deleted for a several time to handling RST_STREAM and WINDOW_UPDATE.
+    // See 'closed' state written at https://tools.ietf.org/html/draft-ietf-httpbis-http2-16#section-5.1
+    this->delete_stream(stream);
+    return HTTP2_SEND_DATA_FRAME_DONE;
+  }
+
+  return HTTP2_SEND_DATA_FRAME_NO_ERROR;
 }
 
 void
-Http2ConnectionState::send_headers_frame(FetchSM *fetch_sm)
+Http2ConnectionState::send_headers_frame(Http2Stream *stream)
 {
   const size_t buf_len = BUFFER_SIZE_FOR_INDEX(buffer_size_index[HTTP2_FRAME_TYPE_HEADERS]) - HTTP2_FRAME_HEADER_LEN;
   uint8_t payload_buffer[buf_len];
   size_t payload_length = 0;
   uint8_t flags = 0x00;
 
-  Http2Stream *stream = static_cast<Http2Stream *>(fetch_sm->ext_get_user_data());
-  HTTPHdr *resp_header = reinterpret_cast<HTTPHdr *>(fetch_sm->resp_hdr_bufp());
+  HTTPHdr *resp_header = stream->get_response_header();
 
   // Write psuedo headers
   payload_length += http2_write_psuedo_headers(resp_header, payload_buffer, buf_len, *(this->remote_dynamic_table));
@@ -893,6 +1044,8 @@ Http2ConnectionState::send_headers_frame(FetchSM *fetch_sm)
   // Must check to ensure content-length is there.  Otherwise the value defaults to 0
   if (resp_header->presence(MIME_PRESENCE_CONTENT_LENGTH) && resp_header->get_content_length() == 0) {
     flags |= HTTP2_FLAGS_HEADERS_END_STREAM;
+  } else if (stream->is_body_done() && stream->get_response_data_reader()->read_avail() == 0) {
+    flags |= HTTP2_FLAGS_HEADERS_END_STREAM;
   }
 
   MIMEFieldIter field_iter;
@@ -920,6 +1073,15 @@ Http2ConnectionState::send_headers_frame(FetchSM *fetch_sm)
     SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
     this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &headers);
   } while (cont);
+
+  // Nothing follows the HEADERS frame, the stream is closed.
+  if (flags & HTTP2_FLAGS_HEADERS_END_STREAM) {
+    if (!stream->change_state(HTTP2_FRAME_TYPE_HEADERS, flags)) {
+      this->send_goaway_frame(stream->get_id(), HTTP2_ERROR_PROTOCOL_ERROR);
+      return;
+    }
+    this->delete_stream(stream);
+  }
 }
 
 void
@@ -985,137 +1147,3 @@ Http2ConnectionState::send_window_update_frame(Http2StreamId id, uint32_t size)
   SCOPED_MUTEX_LOCK(lock, this->ua_session->mutex, this_ethread());
   this->ua_session->handleEvent(HTTP2_SESSION_EVENT_XMIT, &window_update);
 }
-
-void
-Http2Stream::init_fetcher(Http2ConnectionState &cstate)
-{
-  extern ClassAllocator<FetchSM> FetchSMAllocator;
-
-  // Convert header to HTTP/1.1 format
-  convert_from_2_to_1_1_header(&_req_header);
-
-  // Get null-terminated URL and method
-  Arena arena;
-  int url_len, method_len;
-  const char *url_ref = _req_header.url_get()->string_get_ref(&url_len);
-  const char *url = arena.str_store(url_ref, url_len);
-  const char *method_ref = _req_header.method_get(&method_len);
-  const char *method = arena.str_store(method_ref, method_len);
-
-  // Initialize FetchSM
-  _fetch_sm = FetchSMAllocator.alloc();
-  _fetch_sm->ext_init((Continuation *)cstate.ua_session, method, url, HTTP2_FETCHING_HTTP_VERSION,
-                      cstate.ua_session->get_client_addr(), (TS_FETCH_FLAGS_DECHUNK | TS_FETCH_FLAGS_NOT_INTERNAL_REQUEST));
-
-  // Set request header
-  MIMEFieldIter fiter;
-  for (const MIMEField *field = _req_header.iter_get_first(&fiter); field != NULL; field = _req_header.iter_get_next(&fiter)) {
-    int name_len, value_len;
-    const char *name = field->name_get(&name_len);
-    const char *value = field->value_get(&value_len);
-
-    _fetch_sm->ext_add_header(name, name_len, value, value_len);
-  }
-
-  _fetch_sm->ext_set_user_data(this);
-  _fetch_sm->ext_launch();
-}
-
-void
-Http2Stream::set_body_to_fetcher(const void *data, size_t len)
-{
-  ink_assert(_fetch_sm != NULL);
-
-  _fetch_sm->ext_write_data(data, len);
-}
-
-/*
- * 5.1.  Stream States
- *
- *                       +--------+
- *                 PP    |        |    PP
- *              ,--------|  idle  |--------.
- *             /         |        |         \
- *            v          +--------+          v
- *     +----------+          |           +----------+
- *     |          |          | H         |          |
- * ,---| reserved |          |           | reserved |---.
- * |   | (local)  |          v           | (remote) |   |
- * |   +----------+      +--------+      +----------+   |
- * |      |          ES  |        |  ES          |      |
- * |      | H    ,-------|  open  |-------.      | H    |
- * |      |     /        |        |        \     |      |
- * |      v    v         +--------+         v    v      |
- * |   +----------+          |           +----------+   |
- * |   |   half   |          |           |   half   |   |
- * |   |  closed  |          | R         |  closed  |   |
- * |   | (remote) |          |           | (local)  |   |
- * |   +----------+          |           +----------+   |
- * |        |                v                 |        |
- * |        |  ES / R    +--------+  ES / R    |        |
- * |        `----------->|        |<-----------'        |
- * |  R                  | closed |                  R  |
- * `-------------------->|        |<--------------------'
- *                       +--------+
- */
-bool
-Http2Stream::change_state(uint8_t type, uint8_t flags)
-{
-  switch (_state) {
-  case HTTP2_STREAM_STATE_IDLE:
-    if (type == HTTP2_FRAME_TYPE_HEADERS) {
-      if (flags & HTTP2_FLAGS_HEADERS_END_STREAM) {
-        // Skip OPEN _state
-        _state = HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE;
-      } else {
-        _state = HTTP2_STREAM_STATE_OPEN;
-      }
-    } else if (type == HTTP2_FRAME_TYPE_PUSH_PROMISE) {
-      // XXX Server Push have been supported yet.
-    } else {
-      return false;
-    }
-    break;
-
-  case HTTP2_STREAM_STATE_OPEN:
-    if (type == HTTP2_FRAME_TYPE_RST_STREAM) {
-      _state = HTTP2_STREAM_STATE_CLOSED;
-    } else if (type == HTTP2_FRAME_TYPE_DATA && flags & HTTP2_FLAGS_DATA_END_STREAM) {
-      _state = HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE;
-    } else {
-      // Currently ATS supports only HTTP/2 server features
-      return false;
-    }
-    break;
-
-  case HTTP2_STREAM_STATE_RESERVED_LOCAL:
-    // Currently ATS supports only HTTP/2 server features
-    return false;
-
-  case HTTP2_STREAM_STATE_RESERVED_REMOTE:
-    // XXX Server Push have been supported yet.
-    return false;
-
-  case HTTP2_STREAM_STATE_HALF_CLOSED_LOCAL:
-    // Currently ATS supports only HTTP/2 server features
-    return false;
-
-  case HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE:
-    if (type == HTTP2_FRAME_TYPE_RST_STREAM || (type == HTTP2_FRAME_TYPE_HEADERS && flags & HTTP2_FLAGS_HEADERS_END_STREAM) ||
-        (type == HTTP2_FRAME_TYPE_DATA && flags & HTTP2_FLAGS_DATA_END_STREAM)) {
-      _state = HTTP2_STREAM_STATE_CLOSED;
-    } else {
-      return false;
-    }
-    break;
-
-  case HTTP2_STREAM_STATE_CLOSED:
-    // No state changing
-    return false;
-
-  default:
-    return false;
-  }
-
-  return true;
-}
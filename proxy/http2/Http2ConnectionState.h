@@ -26,7 +26,8 @@
 
 #include "HTTP2.h"
 #include "HPACK.h"
-#include "FetchSM.h"
+#include "Http2Stream.h"
+#include "Http2DependencyTree.h"
 
 class Http2ClientSession;
 
@@ -93,94 +94,23 @@ private:
   unsigned settings[HTTP2_SETTINGS_MAX - 1];
 };
 
-class Http2ConnectionState;
-
-class Http2Stream
-{
-public:
-  Http2Stream(Http2StreamId sid = 0, ssize_t initial_rwnd = Http2::initial_window_size)
-    : client_rwnd(initial_rwnd), server_rwnd(initial_rwnd), _id(sid), _state(HTTP2_STREAM_STATE_IDLE), _fetch_sm(NULL),
-      body_done(false), data_length(0)
-  {
-    _req_header.create(HTTP_TYPE_REQUEST);
-  }
-
-  ~Http2Stream()
-  {
-    _req_header.destroy();
-
-    if (_fetch_sm) {
-      _fetch_sm->ext_destroy();
-      _fetch_sm = NULL;
-    }
-  }
-
-  // Operate FetchSM
-  void init_fetcher(Http2ConnectionState &cstate);
-  void set_body_to_fetcher(const void *data, size_t len);
-  FetchSM *
-  get_fetcher()
-  {
-    return _fetch_sm;
-  }
-  bool
-  is_body_done() const
-  {
-    return body_done;
-  }
-  void
-  mark_body_done()
-  {
-    body_done = true;
-  }
-
-  const Http2StreamId
-  get_id() const
+// Scheduling statistics of a connection.
+struct Http2SchedulerStats {
+  Http2SchedulerStats()
+    : data_frames(0), data_bytes(0), priority_frames(0), reprioritizations(0), window_stalls(0), buffer_stalls(0),
+      max_active_streams(0)
   {
-    return _id;
   }
-  const Http2StreamState
-  get_state() const
-  {
-    return _state;
-  }
-  bool change_state(uint8_t type, uint8_t flags);
-
-  int64_t
-  decode_request_header(const IOVec &iov, Http2DynamicTable &dynamic_table, bool cont)
-  {
-    return http2_parse_header_fragment(&_req_header, iov, dynamic_table, cont);
-  }
-
-  // Check entire DATA payload length if content-length: header is exist
-  void
-  increment_data_length(uint64_t length)
-  {
-    data_length += length;
-  }
-  bool
-  payload_length_is_valid() const
-  {
-    uint32_t content_length = _req_header.get_content_length();
-    return content_length == 0 || content_length == data_length;
-  }
-
-  // Stream level window size
-  ssize_t client_rwnd, server_rwnd;
-
-  LINK(Http2Stream, link);
 
-private:
-  Http2StreamId _id;
-  Http2StreamState _state;
-
-  HTTPHdr _req_header;
-  FetchSM *_fetch_sm;
-  bool body_done;
-  uint64_t data_length;
+  uint64_t data_frames;        // DATA frames sent
+  uint64_t data_bytes;         // DATA frame payload bytes sent
+  uint64_t priority_frames;    // PRIORITY frames received
+  uint64_t reprioritizations;  // Dependency or weight changes requested by the client
+  uint64_t window_stalls;      // Times a stream with data to send was blocked by a flow control window
+  uint64_t buffer_stalls;      // Times the scheduler stopped because the session write buffer was full
+  uint32_t max_active_streams; // Largest number of streams in the dependency tree
 };
 
-
 // Http2ConnectionState
 //
 // Capture the semantics of a HTTP/2 connection. The client session captures the frame layer, and the
@@ -209,6 +139,7 @@ public:
   {
     local_dynamic_table = new Http2DynamicTable();
     remote_dynamic_table = new Http2DynamicTable();
+    remote_dynamic_table->update_encoder_table_size(min(Http2::encoder_header_table_size, HTTP2_HEADER_TABLE_SIZE));
 
     continued_buffer.iov_base = NULL;
     continued_buffer.iov_len = 0;
@@ -238,6 +169,7 @@ public:
   void restart_streams();
   void delete_stream(Http2Stream *stream);
   void cleanup_streams();
+  void reprioritize_stream(Http2StreamId id, const Http2Priority &priority, bool reprioritization);
 
   void update_initial_rwnd(Http2WindowSize new_size);
 
@@ -258,9 +190,13 @@ public:
   // Connection level window size
   ssize_t client_rwnd, server_rwnd;
 
+  // DATA frame scheduling statistics, dumped to the "http2_priority" debug tag when the connection ends
+  Http2SchedulerStats scheduler_stats;
+
   // HTTP/2 frame sender
-  void send_data_frame(FetchSM *fetch_sm);
-  void send_headers_frame(FetchSM *fetch_sm);
+  void send_data_frame(Http2Stream *stream);
+  void send_data_frames();
+  void send_headers_frame(Http2Stream *stream);
   void send_rst_stream_frame(Http2StreamId id, Http2ErrorCode ec);
   void send_ping_frame(Http2StreamId id, uint8_t flag, const uint8_t *opaque_data);
   void send_goaway_frame(Http2StreamId id, Http2ErrorCode ec);
@@ -276,7 +212,17 @@ private:
   Http2ConnectionState(const Http2ConnectionState &);            // noncopyable
   Http2ConnectionState &operator=(const Http2ConnectionState &); // noncopyable
 
+  enum Http2SendDataFrameResult {
+    HTTP2_SEND_DATA_FRAME_NO_ERROR,
+    HTTP2_SEND_DATA_FRAME_NO_PAYLOAD,
+    HTTP2_SEND_DATA_FRAME_STREAM_WINDOW,
+    HTTP2_SEND_DATA_FRAME_CONNECTION_WINDOW,
+    HTTP2_SEND_DATA_FRAME_DONE,
+  };
+  Http2SendDataFrameResult send_a_data_frame(Http2Stream *stream, size_t &payload_length);
+
   DLL<Http2Stream> stream_list;
+  Http2DependencyTree dependency_tree;
   Http2StreamId latest_streamid;
 
   // Counter for current acive streams which is started by client
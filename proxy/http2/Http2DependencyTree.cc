@@ -0,0 +1,368 @@
+/** @file
+
+  Http2DependencyTree.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "libts.h"
+#include "Http2DependencyTree.h"
+
+// Scale of the virtual time. Sending n bytes advances the virtual time of a node by n * scale / weight.
+static const uint64_t HTTP2_DEPENDENCY_TREE_WEIGHT_SCALE = 256;
+
+Http2DependencyTree::Http2DependencyTree()
+  : root(HTTP2_PRIORITY_DEFAULT_STREAM_DEPENDENCY, HTTP2_PRIORITY_DEFAULT_WEIGHT + 1, NULL), node_count(0)
+{
+}
+
+Http2DependencyTree::~Http2DependencyTree()
+{
+  clear();
+}
+
+Http2DependencyTree::Node *
+Http2DependencyTree::find(Http2StreamId id) const
+{
+  if (id == root.id) {
+    return const_cast<Node *>(&root);
+  }
+
+  for (Node *n = all_nodes.head; n; n = n->all_link.next) {
+    if (n->id == id) {
+      return n;
+    }
+  }
+
+  return NULL;
+}
+
+// 5.3.1. A stream that depends on a stream which is not in the tree is given the default priority.
+Http2DependencyTree::Node *
+Http2DependencyTree::add(Http2StreamId parent_id, Http2StreamId id, uint32_t weight, bool exclusive, Http2Stream *stream)
+{
+  Node *parent = find(parent_id);
+  if (parent == NULL) {
+    parent = &root;
+    weight = HTTP2_PRIORITY_DEFAULT_WEIGHT + 1;
+    exclusive = false;
+  }
+
+  Node *node = new Node(id, weight, stream);
+
+  // 5.3.1. An exclusive flag allows for the insertion of a new level of dependencies.
+  if (exclusive) {
+    while (Node *child = parent->children.head) {
+      detach(child);
+      attach(child, node);
+    }
+  }
+
+  attach(node, parent);
+  all_nodes.push(node);
+  ++node_count;
+
+  return node;
+}
+
+// 5.3.3. Reprioritization
+void
+Http2DependencyTree::reprioritize(Node *node, Http2StreamId new_parent_id, uint32_t weight, bool exclusive)
+{
+  ink_assert(node != &root);
+
+  Node *new_parent = find(new_parent_id);
+  if (new_parent == NULL) {
+    new_parent = &root;
+    weight = HTTP2_PRIORITY_DEFAULT_WEIGHT + 1;
+    exclusive = false;
+  }
+
+  if (new_parent == node) {
+    return;
+  }
+
+  // If a stream is made dependent on one of its own dependencies, the formerly dependent stream is first moved
+  // to be dependent on the reprioritized stream's previous parent. The moved dependency retains its weight.
+  if (is_ancestor(node, new_parent)) {
+    Node *old_parent = node->parent;
+    detach(new_parent);
+    attach(new_parent, old_parent);
+  }
+
+  detach(node);
+  node->weight = weight;
+
+  if (exclusive) {
+    while (Node *child = new_parent->children.head) {
+      detach(child);
+      attach(child, node);
+    }
+  }
+
+  attach(node, new_parent);
+}
+
+// 5.3.4. When a stream is removed from the tree, its dependencies are moved to become dependent on the parent
+// of the closed stream. The weight of the closed stream is distributed to the moved dependencies in proportion
+// to their weights.
+void
+Http2DependencyTree::remove(Node *node)
+{
+  ink_assert(node != &root);
+
+  Node *parent = node->parent;
+  uint32_t weight_sum = 0;
+
+  for (Node *child = node->children.head; child; child = child->link.next) {
+    weight_sum += child->weight;
+  }
+
+  while (Node *child = node->children.head) {
+    uint32_t weight = node->weight * child->weight / weight_sum;
+
+    detach(child);
+    child->weight = weight > 0 ? weight : 1;
+    attach(child, parent);
+  }
+
+  detach(node);
+  all_nodes.remove(node);
+  --node_count;
+
+  delete node;
+}
+
+void
+Http2DependencyTree::clear()
+{
+  while (Node *node = all_nodes.pop()) {
+    delete node;
+  }
+
+  root.children.clear();
+  root.queue.clear();
+  root.vtime = 0;
+  node_count = 0;
+}
+
+// Return the node which should send the next DATA frame, or NULL if no stream has anything to send.
+Http2DependencyTree::Node *
+Http2DependencyTree::top() const
+{
+  for (Node *node = root.queue.head; node; node = node->queue.head) {
+    if (node->active) {
+      return node;
+    }
+  }
+
+  return NULL;
+}
+
+void
+Http2DependencyTree::activate(Node *node)
+{
+  node->active = true;
+  enqueue(node);
+}
+
+void
+Http2DependencyTree::deactivate(Node *node)
+{
+  node->active = false;
+  dequeue(node);
+}
+
+// Charge the node and its ancestors for the bytes sent, and move them back in their queues accordingly.
+void
+Http2DependencyTree::update(Node *node, size_t sent)
+{
+  for (Node *n = node; n->parent; n = n->parent) {
+    Node *parent = n->parent;
+
+    if (!n->queued) {
+      continue;
+    }
+
+    parent->vtime = n->point;
+    n->point += sent * HTTP2_DEPENDENCY_TREE_WEIGHT_SCALE / n->weight + 1;
+
+    parent->queue.remove(n);
+    n->queued = false;
+    enqueue(n);
+  }
+}
+
+bool
+Http2DependencyTree::is_ancestor(const Node *ancestor, const Node *node) const
+{
+  for (const Node *n = node->parent; n; n = n->parent) {
+    if (n == ancestor) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void
+Http2DependencyTree::attach(Node *node, Node *parent)
+{
+  node->parent = parent;
+  node->point = 0;
+  parent->children.push(node);
+
+  if (node->active || !node->queue.empty()) {
+    enqueue(node);
+  }
+}
+
+void
+Http2DependencyTree::detach(Node *node)
+{
+  Node *parent = node->parent;
+
+  if (node->queued) {
+    parent->queue.remove(node);
+    node->queued = false;
+    dequeue(parent);
+  }
+
+  parent->children.remove(node);
+  node->parent = NULL;
+}
+
+// Put the node into its parent's queue, and the ancestors which were idle into theirs. A node which joins a
+// queue starts at the queue's current virtual time, so it can't claim the bandwidth it didn't use while idle.
+void
+Http2DependencyTree::enqueue(Node *node)
+{
+  for (Node *n = node; n->parent && !n->queued; n = n->parent) {
+    Node *parent = n->parent;
+
+    if (n->point < parent->vtime) {
+      n->point = parent->vtime;
+    }
+
+    Node *after = NULL;
+    for (Node *s = parent->queue.head; s && s->point <= n->point; s = s->queue_link.next) {
+      after = s;
+    }
+    parent->queue.insert(n, after);
+    n->queued = true;
+  }
+}
+
+// Take the node out of its parent's queue if it has nothing to send, and the ancestors which become idle.
+void
+Http2DependencyTree::dequeue(Node *node)
+{
+  for (Node *n = node; n->parent && n->queued && !n->active && n->queue.empty(); n = n->parent) {
+    n->parent->queue.remove(n);
+    n->queued = false;
+  }
+}
+
+#if TS_HAS_TESTS
+
+#include "TestBox.h"
+
+// 5.3.1. Stream Dependencies: an exclusive dependency inserts a new level.
+REGRESSION_TEST(HTTP2_DependencyTree_Exclusive)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Http2DependencyTree tree;
+  Http2DependencyTree::Node *b = tree.add(0, 3, 16, false, NULL);
+  Http2DependencyTree::Node *c = tree.add(0, 5, 16, false, NULL);
+  Http2DependencyTree::Node *d = tree.add(0, 7, 16, true, NULL);
+
+  box.check(tree.size() == 3, "expected 3 nodes, got %u", tree.size());
+  box.check(b->parent == d && c->parent == d, "exclusive stream should adopt its siblings");
+  box.check(d->parent == tree.find(0), "exclusive stream should depend on the root");
+}
+
+// 5.3.3. Reprioritization: a stream made dependent on its own dependency.
+REGRESSION_TEST(HTTP2_DependencyTree_Reprioritize)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Http2DependencyTree tree;
+  Http2DependencyTree::Node *a = tree.add(0, 1, 16, false, NULL);
+  Http2DependencyTree::Node *b = tree.add(1, 3, 16, false, NULL);
+  Http2DependencyTree::Node *c = tree.add(1, 5, 16, false, NULL);
+  Http2DependencyTree::Node *d = tree.add(5, 7, 16, false, NULL);
+
+  tree.reprioritize(a, 7, 16, true);
+
+  box.check(d->parent == tree.find(0), "dependency should move to the old parent, got %u", d->parent->id);
+  box.check(a->parent == d, "stream should depend on its former dependency");
+  box.check(b->parent == a && c->parent == a, "former children should stay with the stream");
+
+  tree.remove(a);
+  box.check(b->parent == d && c->parent == d, "children of a removed stream should move to its parent");
+  box.check(b->weight == 8 && c->weight == 8, "weight should be distributed, got %u and %u", b->weight, c->weight);
+}
+
+// 5.3.2. Dependency Weighting: siblings share the bandwidth in proportion to their weights, and a stream goes
+// before the streams depending on it.
+REGRESSION_TEST(HTTP2_DependencyTree_Schedule)(RegressionTest *t, int /* atype ATS_UNUSED */, int *pstatus)
+{
+  TestBox box(t, pstatus);
+  box = REGRESSION_TEST_PASSED;
+
+  Http2DependencyTree tree;
+  Http2DependencyTree::Node *a = tree.add(0, 1, 32, false, NULL);
+  Http2DependencyTree::Node *b = tree.add(0, 3, 64, false, NULL);
+  Http2DependencyTree::Node *c = tree.add(3, 5, 16, false, NULL);
+
+  box.check(tree.top() == NULL, "no stream is active");
+
+  tree.activate(a);
+  tree.activate(b);
+  tree.activate(c);
+
+  int count_a = 0, count_b = 0, count_c = 0;
+  for (int i = 0; i < 300; ++i) {
+    Http2DependencyTree::Node *node = tree.top();
+    if (node == a) {
+      ++count_a;
+    } else if (node == b) {
+      ++count_b;
+    } else if (node == c) {
+      ++count_c;
+    }
+    tree.update(node, 1024);
+  }
+
+  box.check(count_c == 0, "dependent stream should wait for its parent, got %d frames", count_c);
+  box.check(count_a >= 95 && count_a <= 105 && count_b >= 195 && count_b <= 205, "expected 1:2 ratio, got %d:%d", count_a,
+            count_b);
+
+  tree.deactivate(b);
+  box.check(tree.top() == a || tree.top() == c, "dependent stream should be scheduled once its parent is blocked");
+  tree.deactivate(a);
+  box.check(tree.top() == c, "only the dependent stream is left");
+  tree.deactivate(c);
+  box.check(tree.top() == NULL, "no stream is active");
+}
+
+#endif /* TS_HAS_TESTS */
@@ -0,0 +1,106 @@
+/** @file
+
+  Http2DependencyTree.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __HTTP2_DEPENDENCY_TREE_H__
+#define __HTTP2_DEPENDENCY_TREE_H__
+
+#include "List.h"
+#include "HTTP2.h"
+
+class Http2Stream;
+
+// Http2DependencyTree
+//
+// The stream dependency tree of a connection (RFC 7540 5.3), and a weighted fair scheduler on top of it.
+//
+// A node is active when its stream has a DATA frame ready to go. Every node keeps the children that are active
+// or have active descendants in a queue, ordered by their virtual finish time. The next stream to send is found
+// by walking down from the root, stopping at the first active node: a stream takes precedence over the streams
+// depending on it, and siblings share their parent's bandwidth in proportion to their weights.
+
+class Http2DependencyTree
+{
+public:
+  class Node
+  {
+  public:
+    Node(Http2StreamId i, uint32_t w, Http2Stream *s)
+      : id(i), weight(w), point(0), vtime(0), active(false), queued(false), parent(NULL), stream(s)
+    {
+    }
+
+    Http2StreamId id;
+    uint32_t weight; // 1 - 256
+    uint64_t point;  // Virtual finish time in the parent's queue
+    uint64_t vtime;  // Virtual time of the queue of this node
+    bool active;
+    bool queued;
+
+    Node *parent;
+    Http2Stream *stream; // NULL for the root and for nodes of idle streams only referred by PRIORITY frames
+
+    LINK(Node, link);       // Siblings
+    LINK(Node, queue_link); // Siblings in the parent's queue
+    LINK(Node, all_link);   // All the nodes of the tree
+
+    DLL<Node> children;
+    DLL<Node, Link_queue_link> queue;
+  };
+
+  Http2DependencyTree();
+  ~Http2DependencyTree();
+
+  Node *find(Http2StreamId id) const;
+  Node *add(Http2StreamId parent_id, Http2StreamId id, uint32_t weight, bool exclusive, Http2Stream *stream);
+  void reprioritize(Node *node, Http2StreamId new_parent_id, uint32_t weight, bool exclusive);
+  void remove(Node *node);
+  void clear();
+
+  // Scheduler
+  Node *top() const;
+  void activate(Node *node);
+  void deactivate(Node *node);
+  void update(Node *node, size_t sent);
+
+  uint32_t
+  size() const
+  {
+    return node_count;
+  }
+
+private:
+  Http2DependencyTree(const Http2DependencyTree &);            // noncopyable
+  Http2DependencyTree &operator=(const Http2DependencyTree &); // noncopyable
+
+  bool is_ancestor(const Node *ancestor, const Node *node) const;
+  void attach(Node *node, Node *parent);
+  void detach(Node *node);
+  void enqueue(Node *node);
+  void dequeue(Node *node);
+
+  Node root;
+  DLL<Node, Node::Link_all_link> all_nodes;
+  uint32_t node_count;
+};
+
+#endif // __HTTP2_DEPENDENCY_TREE_H__
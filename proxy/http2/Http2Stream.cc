@@ -0,0 +1,804 @@
+/** @file
+
+  Http2Stream.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "Http2Stream.h"
+#include "Http2ConnectionState.h"
+#include "Http2ClientSession.h"
+#include "HttpSessionAccept.h"
+
+#define DebugHttp2Stream(fmt, ...) Debug("http2_stream", "[%u] " fmt, this->_id, __VA_ARGS__)
+
+#define HTTP2_STREAM_LOCK_RETRY_TIME HRTIME_MSECONDS(10)
+
+// Upper bound of response bytes taken from the transaction but not yet sent as DATA frames. Once it is reached
+// the stream stops consuming the transaction's buffer, which pushes back on the HttpTunnel.
+#define HTTP2_STREAM_RESPONSE_HIGH_WATER (4 * HTTP2_MAX_FRAME_SIZE)
+
+extern HttpSessionAccept *plugin_http_accept;
+
+Http2Stream::Http2Stream(Http2ConnectionState *cstate, Http2StreamId sid, ssize_t initial_rwnd)
+  : super(), client_rwnd(initial_rwnd), server_rwnd(initial_rwnd), priority_node(NULL), _cstate(cstate), _id(sid), _state(HTTP2_STREAM_STATE_IDLE),
+    data_length(0), request_buffer(NULL), request_reader(NULL), request_done(false), response_buffer(NULL), response_reader(NULL),
+    response_header_done(false), response_is_chunked(false), response_write_done(false), need_read_process(false),
+    need_write_process(false), write_shutdown(false), txn_active(false), closed(false), reentrancy_count(0), pending_error_event(0),
+    process_event(NULL), active_timeout(0), active_event(NULL), inactive_timeout(0), inactive_timeout_at(0), inactive_event(NULL)
+{
+  ink_assert(cstate->ua_session != NULL);
+
+  this->mutex = cstate->ua_session->mutex;
+  _req_header.create(HTTP_TYPE_REQUEST);
+  http_parser_init(&http_parser);
+
+  SET_HANDLER(&Http2Stream::main_event_handler);
+}
+
+Http2Stream::~Http2Stream()
+{
+  ink_assert(this->reentrancy_count == 0);
+
+  if (process_event) {
+    process_event->cancel();
+    process_event = NULL;
+  }
+  cancel_active_timeout();
+  cancel_inactivity_timeout();
+
+  _req_header.destroy();
+  _resp_header.destroy();
+  http_parser_clear(&http_parser);
+
+  if (response_is_chunked) {
+    chunked_handler.clear();
+  }
+  if (request_buffer) {
+    free_MIOBuffer(request_buffer);
+  }
+  if (response_buffer) {
+    free_MIOBuffer(response_buffer);
+  }
+
+  read_vio.mutex.clear();
+  write_vio.mutex.clear();
+  mutex.clear();
+}
+
+int
+Http2Stream::main_event_handler(int /* event ATS_UNUSED */, void *edata)
+{
+  Event *e = static_cast<Event *>(edata);
+
+  ++reentrancy_count;
+
+  if (e == active_event) {
+    active_event = NULL;
+    signal_error(VC_EVENT_ACTIVE_TIMEOUT);
+  } else if (e == inactive_event) {
+    ink_hrtime now = ink_get_hrtime();
+    if (inactive_timeout_at && inactive_timeout_at < now) {
+      inactive_event = NULL;
+      signal_error(VC_EVENT_INACTIVITY_TIMEOUT);
+    } else if (inactive_timeout_at) {
+      inactive_event->schedule_in(inactive_timeout_at - now);
+    } else {
+      inactive_event = NULL;
+    }
+  } else if (e == process_event) {
+    process_event = NULL;
+
+    if (pending_error_event && !closed) {
+      int error_event = pending_error_event;
+      pending_error_event = 0;
+      signal_error(error_event);
+    }
+    if (need_write_process && !closed) {
+      process_write_side();
+    }
+    if (need_read_process && !closed) {
+      process_read_side();
+    }
+  }
+
+  --reentrancy_count;
+  destroy_if_done();
+
+  return 0;
+}
+
+// Hand the request over to a new HttpClientSession, as if the stream was a freshly accepted connection. The
+// HTTP/2 request is printed as HTTP/1.1 into the request buffer, which the transaction reads through this VC.
+bool
+Http2Stream::new_transaction()
+{
+  ink_assert(_cstate != NULL && _cstate->ua_session != NULL);
+  ink_assert(!txn_active);
+
+  if (convert_from_2_to_1_1_header(&_req_header) == PARSE_ERROR || plugin_http_accept == NULL) {
+    return false;
+  }
+
+  NetVConnection *client_vc = _cstate->ua_session->get_netvc();
+  ats_ip_copy(&local_addr, client_vc->get_local_addr());
+  ats_ip_copy(&remote_addr, client_vc->get_remote_addr());
+  got_local_addr = true;
+  got_remote_addr = true;
+  attributes = client_vc->attributes;
+  set_is_transparent(client_vc->get_is_transparent());
+  thread = this_ethread();
+
+  request_buffer = new_MIOBuffer(HTTP2_HEADER_BUFFER_SIZE_INDEX);
+  request_reader = request_buffer->alloc_reader();
+
+  int bufindex;
+  int dumpoffset = 0;
+  int done, tmp;
+  do {
+    IOBufferBlock *block = request_buffer->get_current_block();
+    bufindex = 0;
+    tmp = dumpoffset;
+    done = _req_header.print(block->end(), block->write_avail(), &bufindex, &tmp);
+    dumpoffset += bufindex;
+    request_buffer->fill(bufindex);
+    if (!done) {
+      request_buffer->add_block();
+    }
+  } while (!done);
+
+  DebugHttp2Stream("starting transaction, %d bytes of request header", dumpoffset);
+
+  txn_active = true;
+
+  ++reentrancy_count;
+  plugin_http_accept->accept(this, NULL, NULL);
+  --reentrancy_count;
+
+  destroy_if_done();
+
+  return true;
+}
+
+void
+Http2Stream::write_request_data(IOBufferReader *reader, int64_t offset, int64_t len)
+{
+  if (request_buffer == NULL || len <= 0) {
+    return;
+  }
+
+  request_buffer->write(reader, len, offset);
+  need_read_process = true;
+  schedule_process();
+}
+
+void
+Http2Stream::mark_request_done()
+{
+  request_done = true;
+  need_read_process = true;
+  schedule_process();
+}
+
+IOBufferReader *
+Http2Stream::get_response_data_reader()
+{
+  if (!response_header_done) {
+    return NULL;
+  }
+
+  return response_is_chunked ? chunked_handler.dechunked_reader : response_reader;
+}
+
+void
+Http2Stream::consume_response_data(int64_t len)
+{
+  IOBufferReader *reader = get_response_data_reader();
+
+  ink_assert(reader != NULL);
+  reader->consume(len);
+
+  if (inactive_timeout) {
+    inactive_timeout_at = ink_get_hrtime() + inactive_timeout;
+  }
+
+  // The buffered response shrank, pull more out of the transaction.
+  if (!response_write_done) {
+    need_write_process = true;
+    schedule_process();
+  }
+}
+
+bool
+Http2Stream::is_body_done() const
+{
+  if (!response_header_done) {
+    return false;
+  }
+
+  if (response_is_chunked) {
+    return chunked_handler.state == ChunkedHandler::CHUNK_READ_DONE;
+  }
+
+  return response_write_done || write_shutdown;
+}
+
+void
+Http2Stream::detach_connection()
+{
+  _cstate = NULL;
+
+  // A transaction which is still producing the response has to be told that nobody will send it.
+  if (txn_active && !closed && !is_body_done()) {
+    pending_error_event = VC_EVENT_ERROR;
+    schedule_process();
+  }
+
+  destroy_if_done();
+}
+
+VIO *
+Http2Stream::do_io_read(Continuation *c, int64_t nbytes, MIOBuffer *buf)
+{
+  ink_assert(!closed);
+
+  if (buf) {
+    read_vio.buffer.writer_for(buf);
+  } else {
+    read_vio.buffer.clear();
+  }
+
+  read_vio.mutex = c ? c->mutex : this->mutex;
+  read_vio._cont = c;
+  read_vio.nbytes = nbytes;
+  read_vio.ndone = 0;
+  read_vio.vc_server = this;
+  read_vio.op = VIO::READ;
+
+  // Reentrant callbacks are not allowed from do_io, process the request on a different stack.
+  if (c && nbytes > 0) {
+    need_read_process = true;
+    schedule_process();
+  }
+
+  return &read_vio;
+}
+
+VIO *
+Http2Stream::do_io_write(Continuation *c, int64_t nbytes, IOBufferReader *abuffer, bool owner)
+{
+  ink_assert(!closed);
+  ink_assert(!owner);
+
+  if (abuffer) {
+    write_vio.buffer.reader_for(abuffer);
+  } else {
+    write_vio.buffer.clear();
+  }
+
+  write_vio.mutex = c ? c->mutex : this->mutex;
+  write_vio._cont = c;
+  write_vio.nbytes = nbytes;
+  write_vio.ndone = 0;
+  write_vio.vc_server = this;
+  write_vio.op = VIO::WRITE;
+
+  if (c && nbytes > 0) {
+    need_write_process = true;
+    schedule_process();
+  }
+
+  return &write_vio;
+}
+
+void
+Http2Stream::do_io_close(int /* lerrno ATS_UNUSED */)
+{
+  ink_assert(!closed);
+
+  DebugHttp2Stream("transaction closed, response %s", is_body_done() ? "complete" : "incomplete");
+
+  closed = true;
+  txn_active = false;
+
+  // Never touch the transaction's buffers again.
+  read_vio.op = VIO::NONE;
+  read_vio._cont = NULL;
+  read_vio.buffer.clear();
+  write_vio.op = VIO::NONE;
+  write_vio._cont = NULL;
+  write_vio.buffer.clear();
+
+  cancel_active_timeout();
+  cancel_inactivity_timeout();
+
+  ++reentrancy_count;
+
+  // If the whole response has been taken from the transaction, the connection keeps the stream until the
+  // buffered part is sent out. Otherwise the response is truncated and the client has to know it.
+  if (_cstate && !is_body_done()) {
+    SCOPED_MUTEX_LOCK(lock, _cstate->mutex, this_ethread());
+    _cstate->send_rst_stream_frame(_id, HTTP2_ERROR_INTERNAL_ERROR);
+    if (_cstate) {
+      _cstate->delete_stream(this);
+    }
+  }
+
+  --reentrancy_count;
+  destroy_if_done();
+}
+
+void
+Http2Stream::do_io_shutdown(ShutdownHowTo_t howto)
+{
+  if (howto == IO_SHUTDOWN_WRITE || howto == IO_SHUTDOWN_READWRITE) {
+    write_shutdown = true;
+    need_write_process = true;
+    need_read_process = true;
+    schedule_process();
+  }
+}
+
+void
+Http2Stream::reenable(VIO *vio)
+{
+  ink_assert(!closed);
+
+  if (vio->op == VIO::WRITE) {
+    ink_assert(vio == &write_vio);
+    need_write_process = true;
+  } else if (vio->op == VIO::READ) {
+    ink_assert(vio == &read_vio);
+    need_read_process = true;
+  }
+  schedule_process();
+}
+
+void
+Http2Stream::reenable_re(VIO *vio)
+{
+  this->reenable(vio);
+}
+
+void
+Http2Stream::set_active_timeout(ink_hrtime timeout_in)
+{
+  cancel_active_timeout();
+
+  active_timeout = timeout_in;
+  if (active_timeout > 0 && !closed) {
+    active_event = this_ethread()->schedule_in(this, active_timeout);
+  }
+}
+
+void
+Http2Stream::set_inactivity_timeout(ink_hrtime timeout_in)
+{
+  inactive_timeout = timeout_in;
+
+  if (inactive_timeout > 0 && !closed) {
+    inactive_timeout_at = ink_get_hrtime() + inactive_timeout;
+    if (inactive_event == NULL) {
+      inactive_event = this_ethread()->schedule_in(this, inactive_timeout);
+    }
+  } else {
+    inactive_timeout_at = 0;
+  }
+}
+
+void
+Http2Stream::cancel_active_timeout()
+{
+  if (active_event) {
+    active_event->cancel();
+    active_event = NULL;
+  }
+  active_timeout = 0;
+}
+
+void
+Http2Stream::cancel_inactivity_timeout()
+{
+  if (inactive_event) {
+    inactive_event->cancel();
+    inactive_event = NULL;
+  }
+  inactive_timeout = 0;
+  inactive_timeout_at = 0;
+}
+
+void
+Http2Stream::add_to_keep_alive_queue()
+{
+  // do nothing, the client session owns the connection level timeouts
+}
+
+void
+Http2Stream::remove_from_keep_alive_queue()
+{
+  // do nothing
+}
+
+bool
+Http2Stream::add_to_active_queue()
+{
+  // Streams are accounted by the client session's MAX_CONCURRENT_STREAMS, not by the net handler.
+  return true;
+}
+
+ink_hrtime
+Http2Stream::get_active_timeout()
+{
+  return active_timeout;
+}
+
+ink_hrtime
+Http2Stream::get_inactivity_timeout()
+{
+  return inactive_timeout;
+}
+
+void
+Http2Stream::apply_options()
+{
+  // do nothing, socket options belong to the client connection
+}
+
+SOCKET
+Http2Stream::get_socket()
+{
+  // Return an invalid file descriptor
+  return ts::NO_FD;
+}
+
+int
+Http2Stream::set_tcp_init_cwnd(int /* init_cwnd ATS_UNUSED */)
+{
+  return -1;
+}
+
+void
+Http2Stream::set_local_addr()
+{
+  // The local address is copied from the client connection when the transaction starts.
+}
+
+void
+Http2Stream::set_remote_addr()
+{
+  // The remote address is copied from the client connection when the transaction starts.
+}
+
+void
+Http2Stream::schedule_process()
+{
+  if (process_event == NULL && !closed) {
+    process_event = this_ethread()->schedule_imm(this);
+  }
+}
+
+void
+Http2Stream::process_read_side()
+{
+  need_read_process = false;
+
+  if (read_vio.op != VIO::READ || read_vio._cont == NULL || read_vio.buffer.writer() == NULL || read_vio.ntodo() <= 0) {
+    return;
+  }
+
+  MUTEX_TRY_LOCK(lock, read_vio.mutex, this_ethread());
+  if (!lock.is_locked()) {
+    need_read_process = true;
+    if (process_event == NULL) {
+      process_event = this_ethread()->schedule_in(this, HTTP2_STREAM_LOCK_RETRY_TIME);
+    }
+    return;
+  }
+
+  int64_t nbytes = request_reader ? min(read_vio.ntodo(), request_reader->read_avail()) : 0;
+
+  if (nbytes > 0) {
+    read_vio.buffer.writer()->write(request_reader, nbytes);
+    request_reader->consume(nbytes);
+    read_vio.ndone += nbytes;
+
+    if (inactive_timeout) {
+      inactive_timeout_at = ink_get_hrtime() + inactive_timeout;
+    }
+
+    signal_vio(&read_vio, read_vio.ntodo() <= 0 ? VC_EVENT_READ_COMPLETE : VC_EVENT_READ_READY);
+  } else if (request_done && (response_write_done || write_shutdown)) {
+    // Both directions are complete, there is nothing left to read for the transaction.
+    signal_vio(&read_vio, VC_EVENT_EOS);
+  }
+}
+
+void
+Http2Stream::process_write_side()
+{
+  need_write_process = false;
+
+  if (_cstate == NULL) {
+    return;
+  }
+
+  if (write_vio.op != VIO::WRITE || write_vio._cont == NULL || write_vio.buffer.reader() == NULL) {
+    // Nothing more comes from the transaction, flush what is left.
+    if (write_shutdown && response_header_done) {
+      SCOPED_MUTEX_LOCK(cstate_lock, _cstate->mutex, this_ethread());
+      _cstate->send_data_frame(this);
+    }
+    return;
+  }
+
+  MUTEX_TRY_LOCK(lock, write_vio.mutex, this_ethread());
+  if (!lock.is_locked()) {
+    need_write_process = true;
+    if (process_event == NULL) {
+      process_event = this_ethread()->schedule_in(this, HTTP2_STREAM_LOCK_RETRY_TIME);
+    }
+    return;
+  }
+
+  // Take the response out of the transaction's buffer. The blocks are shared, not copied.
+  IOBufferReader *reader = write_vio.get_reader();
+  int64_t nbytes = min(write_vio.ntodo(), reader->read_avail());
+  if (response_header_done) {
+    nbytes = min(nbytes, max((int64_t)0, (int64_t)HTTP2_STREAM_RESPONSE_HIGH_WATER - response_buffered()));
+  }
+
+  if (nbytes > 0) {
+    if (response_buffer == NULL) {
+      response_buffer = new_empty_MIOBuffer();
+      response_reader = response_buffer->alloc_reader();
+    }
+    response_buffer->write(reader, nbytes);
+    reader->consume(nbytes);
+    write_vio.ndone += nbytes;
+
+    if (inactive_timeout) {
+      inactive_timeout_at = ink_get_hrtime() + inactive_timeout;
+    }
+  }
+
+  bool header_was_done = response_header_done;
+  if (!response_header_done && response_reader && !parse_response_header()) {
+    DebugHttp2Stream("invalid response header, %s", "resetting stream");
+    signal_vio(&write_vio, VC_EVENT_ERROR);
+    return;
+  }
+
+  if (response_header_done) {
+    if (write_vio.ntodo() <= 0) {
+      response_write_done = true;
+    }
+
+    if (response_is_chunked) {
+      if (chunked_handler.state == ChunkedHandler::CHUNK_FLOW_CONTROL) {
+        chunked_handler.state = ChunkedHandler::CHUNK_READ_SIZE_START;
+      }
+      chunked_handler.process_chunked_content();
+    }
+
+    SCOPED_MUTEX_LOCK(cstate_lock, _cstate->mutex, this_ethread());
+    if (!header_was_done) {
+      _cstate->send_headers_frame(this);
+    }
+    if (_cstate) {
+      _cstate->send_data_frame(this);
+    }
+  }
+
+  if (nbytes > 0) {
+    signal_vio(&write_vio, write_vio.ntodo() <= 0 ? VC_EVENT_WRITE_COMPLETE : VC_EVENT_WRITE_READY);
+  }
+
+  if (response_write_done) {
+    // Let a transaction waiting on the read side see the end of the stream.
+    need_read_process = true;
+  }
+}
+
+// Parse the HTTP/1.1 response header written by the transaction. Returns false on a malformed header.
+bool
+Http2Stream::parse_response_header()
+{
+  for (;;) {
+    int bytes_used = 0;
+
+    if (!_resp_header.valid()) {
+      _resp_header.create(HTTP_TYPE_RESPONSE);
+    }
+
+    MIMEParseResult result = _resp_header.parse_resp(&http_parser, response_reader, &bytes_used, false);
+    if (result == PARSE_CONT) {
+      return true;
+    } else if (result == PARSE_ERROR) {
+      return false;
+    }
+
+    // Interim responses (e.g. 100 Continue) are not forwarded, wait for the final one.
+    if (_resp_header.status_get() >= HTTP_STATUS_CONTINUE && _resp_header.status_get() < HTTP_STATUS_OK) {
+      _resp_header.destroy();
+      http_parser_clear(&http_parser);
+      http_parser_init(&http_parser);
+      continue;
+    }
+
+    break;
+  }
+
+  response_header_done = true;
+
+  StrList slist;
+  if (_resp_header.value_get_comma_list(MIME_FIELD_TRANSFER_ENCODING, MIME_LEN_TRANSFER_ENCODING, &slist)) {
+    for (Str *f = slist.head; f != NULL; f = f->next) {
+      if (f->len == (size_t)HTTP_LEN_CHUNKED && strncasecmp(f->str, HTTP_VALUE_CHUNKED, HTTP_LEN_CHUNKED) == 0) {
+        response_is_chunked = true;
+        break;
+      }
+    }
+  }
+
+  // HTTP/2 has its own framing, so a chunked body is decoded before it is put into DATA frames.
+  if (response_is_chunked) {
+    chunked_handler.init_by_action(response_reader, ChunkedHandler::ACTION_DECHUNK);
+    chunked_handler.dechunked_reader = chunked_handler.dechunked_buffer->alloc_reader();
+    chunked_handler.state = ChunkedHandler::CHUNK_READ_SIZE;
+    response_reader->dealloc();
+    response_reader = NULL;
+  }
+
+  DebugHttp2Stream("response header done, status %d%s", _resp_header.status_get(), response_is_chunked ? ", chunked" : "");
+
+  return true;
+}
+
+void
+Http2Stream::signal_vio(VIO *vio, int event)
+{
+  if (vio->_cont && vio->op != VIO::NONE) {
+    vio->_cont->handleEvent(event, vio);
+  }
+}
+
+// Deliver an error or timeout to the transaction, the same way a NetVConnection would.
+void
+Http2Stream::signal_error(int event)
+{
+  if (closed) {
+    return;
+  }
+
+  if (read_vio.op == VIO::READ && read_vio._cont && read_vio.ntodo() > 0) {
+    signal_vio(&read_vio, event);
+  } else if (write_vio.op == VIO::WRITE && write_vio._cont && write_vio.ntodo() > 0) {
+    signal_vio(&write_vio, event);
+  }
+}
+
+int64_t
+Http2Stream::response_buffered() const
+{
+  if (response_is_chunked) {
+    return chunked_handler.chunked_reader->read_avail() + chunked_handler.dechunked_reader->read_avail();
+  }
+
+  return response_reader ? response_reader->read_avail() : 0;
+}
+
+void
+Http2Stream::destroy_if_done()
+{
+  if (reentrancy_count == 0 && !txn_active && _cstate == NULL) {
+    DebugHttp2Stream("%s", "stream destroyed");
+    delete this;
+  }
+}
+
+/*
+ * 5.1.  Stream States
+ *
+ *                       +--------+
+ *                 PP    |        |    PP
+ *              ,--------|  idle  |--------.
+ *             /         |        |         \
+ *            v          +--------+          v
+ *     +----------+          |           +----------+
+ *     |          |          | H         |          |
+ * ,---| reserved |          |           | reserved |---.
+ * |   | (local)  |          v           | (remote) |   |
+ * |   +----------+      +--------+      +----------+   |
+ * |      |          ES  |        |  ES          |      |
+ * |      | H    ,-------|  open  |-------.      | H    |
+ * |      |     /        |        |        \     |      |
+ * |      v    v         +--------+         v    v      |
+ * |   +----------+          |           +----------+   |
+ * |   |   half   |          |           |   half   |   |
+ * |   |  closed  |          | R         |  closed  |   |
+ * |   | (remote) |          |           | (local)  |   |
+ * |   +----------+          |           +----------+   |
+ * |        |                v                 |        |
+ * |        |  ES / R    +--------+  ES / R    |        |
+ * |        `----------->|        |<-----------'        |
+ * |  R                  | closed |                  R  |
+ * `-------------------->|        |<--------------------'
+ *                       +--------+
+ */
+bool
+Http2Stream::change_state(uint8_t type, uint8_t flags)
+{
+  switch (_state) {
+  case HTTP2_STREAM_STATE_IDLE:
+    if (type == HTTP2_FRAME_TYPE_HEADERS) {
+      if (flags & HTTP2_FLAGS_HEADERS_END_STREAM) {
+        // Skip OPEN _state
+        _state = HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE;
+      } else {
+        _state = HTTP2_STREAM_STATE_OPEN;
+      }
+    } else if (type == HTTP2_FRAME_TYPE_PUSH_PROMISE) {
+      // XXX Server Push have been supported yet.
+    } else {
+      return false;
+    }
+    break;
+
+  case HTTP2_STREAM_STATE_OPEN:
+    if (type == HTTP2_FRAME_TYPE_RST_STREAM) {
+      _state = HTTP2_STREAM_STATE_CLOSED;
+    } else if (type == HTTP2_FRAME_TYPE_DATA && flags & HTTP2_FLAGS_DATA_END_STREAM) {
+      _state = HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE;
+    } else {
+      // Currently ATS supports only HTTP/2 server features
+      return false;
+    }
+    break;
+
+  case HTTP2_STREAM_STATE_RESERVED_LOCAL:
+    // Currently ATS supports only HTTP/2 server features
+    return false;
+
+  case HTTP2_STREAM_STATE_RESERVED_REMOTE:
+    // XXX Server Push have been supported yet.
+    return false;
+
+  case HTTP2_STREAM_STATE_HALF_CLOSED_LOCAL:
+    // Currently ATS supports only HTTP/2 server features
+    return false;
+
+  case HTTP2_STREAM_STATE_HALF_CLOSED_REMOTE:
+    if (type == HTTP2_FRAME_TYPE_RST_STREAM || (type == HTTP2_FRAME_TYPE_HEADERS && flags & HTTP2_FLAGS_HEADERS_END_STREAM) ||
+        (type == HTTP2_FRAME_TYPE_DATA && flags & HTTP2_FLAGS_DATA_END_STREAM)) {
+      _state = HTTP2_STREAM_STATE_CLOSED;
+    } else {
+      return false;
+    }
+    break;
+
+  case HTTP2_STREAM_STATE_CLOSED:
+    // No state changing
+    return false;
+
+  default:
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,191 @@
+/** @file
+
+  Http2Stream.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#ifndef __HTTP2_STREAM_H__
+#define __HTTP2_STREAM_H__
+
+#include "P_Net.h"
+#include "HTTP2.h"
+#include "HPACK.h"
+#include "HttpTunnel.h"
+#include "Http2DependencyTree.h"
+
+class Http2ConnectionState;
+
+// Http2Stream
+//
+// A single HTTP/2 stream. On the HTTP/2 side the stream is driven by the connection state, which feeds it the
+// decoded request and pulls the response out of it as HEADERS and DATA frames. On the HTTP side the stream
+// impersonates a NetVConnection, so that an HttpClientSession and its HttpSM can be attached to it directly
+// without going through a FetchSM and a PluginVC loopback.
+//
+// All the streams of a connection share the mutex of the client session, and so do the transactions attached
+// to them. The stream is deleted once both the HTTP/2 connection and the transaction are done with it.
+
+class Http2Stream : public NetVConnection
+{
+public:
+  typedef NetVConnection super; ///< Parent type.
+
+  Http2Stream(Http2ConnectionState *cstate, Http2StreamId sid, ssize_t initial_rwnd);
+  ~Http2Stream();
+
+  int main_event_handler(int event, void *edata);
+
+  const Http2StreamId
+  get_id() const
+  {
+    return _id;
+  }
+  const Http2StreamState
+  get_state() const
+  {
+    return _state;
+  }
+  bool change_state(uint8_t type, uint8_t flags);
+
+  int64_t
+  decode_request_header(const IOVec &iov, Http2DynamicTable &dynamic_table, bool cont)
+  {
+    return http2_parse_header_fragment(&_req_header, iov, dynamic_table, cont);
+  }
+
+  // Check entire DATA payload length if content-length: header is exist
+  void
+  increment_data_length(uint64_t length)
+  {
+    data_length += length;
+  }
+  bool
+  payload_length_is_valid() const
+  {
+    uint32_t content_length = _req_header.get_content_length();
+    return content_length == 0 || content_length == data_length;
+  }
+
+  // Request side, called by the connection state.
+  bool new_transaction();
+  void write_request_data(IOBufferReader *reader, int64_t offset, int64_t len);
+  void mark_request_done();
+
+  // Response side, called by the connection state.
+  HTTPHdr *
+  get_response_header()
+  {
+    return &_resp_header;
+  }
+  IOBufferReader *get_response_data_reader();
+  void consume_response_data(int64_t len);
+  bool is_body_done() const;
+
+  // The connection is done with this stream, either because the response was sent or because the stream or
+  // the connection was reset.
+  void detach_connection();
+
+  // Implement VConnection interface.
+  VIO *do_io_read(Continuation *c, int64_t nbytes = INT64_MAX, MIOBuffer *buf = 0);
+  VIO *do_io_write(Continuation *c = NULL, int64_t nbytes = INT64_MAX, IOBufferReader *buf = 0, bool owner = false);
+  void do_io_close(int lerrno = -1);
+  void do_io_shutdown(ShutdownHowTo_t howto);
+  void reenable(VIO *vio);
+  void reenable_re(VIO *vio);
+
+  // Implement NetVConnection interface.
+  void set_active_timeout(ink_hrtime timeout_in);
+  void set_inactivity_timeout(ink_hrtime timeout_in);
+  void cancel_active_timeout();
+  void cancel_inactivity_timeout();
+  void add_to_keep_alive_queue();
+  void remove_from_keep_alive_queue();
+  bool add_to_active_queue();
+  ink_hrtime get_active_timeout();
+  ink_hrtime get_inactivity_timeout();
+  void apply_options();
+  SOCKET get_socket();
+  int set_tcp_init_cwnd(int init_cwnd);
+  void set_local_addr();
+  void set_remote_addr();
+
+  // Stream level window size
+  ssize_t client_rwnd, server_rwnd;
+
+  // Position of the stream in the dependency tree of the connection
+  Http2DependencyTree::Node *priority_node;
+
+  LINK(Http2Stream, link);
+
+private:
+  Http2Stream(const Http2Stream &);            // noncopyable
+  Http2Stream &operator=(const Http2Stream &); // noncopyable
+
+  void schedule_process();
+  void process_read_side();
+  void process_write_side();
+  bool parse_response_header();
+  void signal_vio(VIO *vio, int event);
+  void signal_error(int event);
+  int64_t response_buffered() const;
+  void destroy_if_done();
+
+  Http2ConnectionState *_cstate;
+  Http2StreamId _id;
+  Http2StreamState _state;
+
+  HTTPHdr _req_header;
+  uint64_t data_length;
+
+  // Request bytes (HTTP/1.1 header followed by the DATA payloads) waiting for the transaction to read them.
+  MIOBuffer *request_buffer;
+  IOBufferReader *request_reader;
+  bool request_done;
+
+  // Response bytes taken from the transaction which are not sent to the client yet.
+  MIOBuffer *response_buffer;
+  IOBufferReader *response_reader;
+  HTTPHdr _resp_header;
+  HTTPParser http_parser;
+  ChunkedHandler chunked_handler;
+  bool response_header_done;
+  bool response_is_chunked;
+  bool response_write_done;
+
+  VIO read_vio;
+  VIO write_vio;
+  bool need_read_process;
+  bool need_write_process;
+  bool write_shutdown;
+
+  bool txn_active;
+  bool closed;
+  int reentrancy_count;
+  int pending_error_event;
+  Event *process_event;
+
+  ink_hrtime active_timeout;
+  Event *active_event;
+  ink_hrtime inactive_timeout;
+  ink_hrtime inactive_timeout_at;
+  Event *inactive_event;
+};
+
+#endif // __HTTP2_STREAM_H__
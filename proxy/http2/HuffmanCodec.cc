@@ -171,7 +171,7 @@ static const huffman_entry huffman_table[] = {{0x1ff8, 13},
                                               {0x7fffdc, 23},
                                               {0x7fffdd, 23},
                                               {0x7fffde, 23},
-                                              {0xffffeb, 23},
+                                              {0xffffeb, 24},
                                               {0x7fffdf, 23},
                                               {0xffffec, 24},
                                               {0xffffed, 24},
@@ -197,7 +197,7 @@ static const huffman_entry huffman_table[] = {{0x1ff8, 13},
                                               {0x7fffe8, 23},
                                               {0x7fffe9, 23},
                                               {0x1fffde, 21},
-                                              {0x7fffde, 23},
+                                              {0x7fffea, 23},
                                               {0x3fffdd, 22},
                                               {0x3fffde, 22},
                                               {0xfffff0, 24},
@@ -243,7 +243,7 @@ static const huffman_entry huffman_table[] = {{0x1ff8, 13},
                                               {0x7ffffe0, 27},
                                               {0x7ffffe1, 27},
                                               {0x3ffffe7, 26},
-                                              {0x3ffffe2, 27},
+                                              {0x7ffffe2, 27},
                                               {0xfffff2, 24},
                                               {0x1fffe4, 21},
                                               {0x1fffe5, 21},
@@ -287,102 +287,189 @@ static const huffman_entry huffman_table[] = {{0x1ff8, 13},
                                               {0x3ffffee, 26},
                                               {0x3fffffff, 30}};
 
-typedef struct node {
-  node *left, *right;
-  char ascii_code;
-} Node;
+// Symbol which marks the end of string, it must never appear in encoded data.
+static const unsigned HUFFMAN_EOS = 256;
 
-Node *HUFFMAN_TREE_ROOT;
+// The decoder consumes the input 4 bits at a time. The Huffman tree has 256 internal nodes, each of them is a
+// state of the decoder. For each state and each nibble, the table gives the state after the nibble, and the
+// symbol completed by the nibble if any. No code is shorter than 5 bits, so one nibble completes at most one
+// symbol.
+enum {
+  HUFFMAN_DECODE_ACCEPT = 0x1, // The nibble ends on a valid end of string (padding of up to 7 one bits)
+  HUFFMAN_DECODE_SYMBOL = 0x2, // The nibble completes a symbol
+  HUFFMAN_DECODE_FAIL = 0x4,   // The nibble contains EOS
+};
 
-static Node *
-make_huffman_tree_node()
-{
-  Node *n = static_cast<Node *>(ats_malloc(sizeof(Node)));
-  n->left = NULL;
-  n->right = NULL;
-  n->ascii_code = '\0';
-  return n;
-}
+struct huffman_decode_entry {
+  uint8_t state;
+  uint8_t flags;
+  uint8_t symbol;
+};
+
+static const unsigned HUFFMAN_DECODE_STATES = 256;
+
+static huffman_decode_entry huffman_decode_table[HUFFMAN_DECODE_STATES][16];
+static bool huffman_decode_table_ready = false;
 
-static Node *
-make_huffman_tree()
+static void
+make_huffman_decode_table()
 {
-  Node *root = make_huffman_tree_node();
-  Node *current;
-  uint32_t bit_len;
-  // insert leafs for each ascii code
-  for (unsigned i = 0; i < countof(huffman_table); i++) {
-    bit_len = huffman_table[i].bit_len;
-    current = root;
-    while (bit_len > 0) {
-      if (huffman_table[i].code_as_hex & (1 << (bit_len - 1))) {
-        if (!current->right)
-          current->right = make_huffman_tree_node();
-        current = current->right;
+  // Binary tree of the codes, a non-negative child is an internal node, a negative one is the leaf of symbol
+  // (-child - 1).
+  int16_t child[HUFFMAN_DECODE_STATES][2];
+  bool accept[HUFFMAN_DECODE_STATES];
+  unsigned nodes = 1;
+
+  memset(child, 0, sizeof(child));
+  memset(accept, 0, sizeof(accept));
+
+  for (unsigned sym = 0; sym < countof(huffman_table); sym++) {
+    unsigned current = 0;
+
+    for (uint32_t bit_len = huffman_table[sym].bit_len; bit_len > 0; bit_len--) {
+      int bit = (huffman_table[sym].code_as_hex >> (bit_len - 1)) & 1;
+
+      if (bit_len == 1) {
+        child[current][bit] = -static_cast<int16_t>(sym) - 1;
       } else {
-        if (!current->left)
-          current->left = make_huffman_tree_node();
-        current = current->left;
+        if (child[current][bit] == 0) {
+          ink_release_assert(nodes < HUFFMAN_DECODE_STATES);
+          child[current][bit] = nodes++;
+        }
+        current = child[current][bit];
       }
-      bit_len--;
     }
-    current->ascii_code = i;
   }
-  return root;
-}
 
-static void
-free_huffman_tree(Node *node)
-{
-  if (node->left)
-    free_huffman_tree(node->left);
-  if (node->right)
-    free_huffman_tree(node->right);
+  // 5.2. Padding is the most significant bits of EOS (all ones), and is strictly shorter than 8 bits.
+  for (int n = 0, depth = 0; n >= 0 && depth < 8; n = child[n][1], depth++) {
+    accept[n] = true;
+  }
+
+  for (unsigned state = 0; state < HUFFMAN_DECODE_STATES; state++) {
+    for (unsigned nibble = 0; nibble < 16; nibble++) {
+      huffman_decode_entry &entry = huffman_decode_table[state][nibble];
+      int current = state;
+
+      entry.flags = 0;
+      entry.symbol = 0;
 
-  ats_free(node);
+      for (int shift = 3; shift >= 0; shift--) {
+        current = child[current][(nibble >> shift) & 1];
+        if (current < 0) {
+          unsigned sym = -current - 1;
+          if (sym == HUFFMAN_EOS) {
+            entry.flags = HUFFMAN_DECODE_FAIL;
+            break;
+          }
+          entry.flags |= HUFFMAN_DECODE_SYMBOL;
+          entry.symbol = sym;
+          current = 0;
+        }
+      }
+
+      if (!(entry.flags & HUFFMAN_DECODE_FAIL)) {
+        entry.state = current;
+        if (accept[current]) {
+          entry.flags |= HUFFMAN_DECODE_ACCEPT;
+        }
+      }
+    }
+  }
 }
 
 void
 hpack_huffman_init()
 {
-  if (!HUFFMAN_TREE_ROOT)
-    HUFFMAN_TREE_ROOT = make_huffman_tree();
+  if (!huffman_decode_table_ready) {
+    make_huffman_decode_table();
+    huffman_decode_table_ready = true;
+  }
 }
 
 void
 hpack_huffman_fin()
 {
-  if (HUFFMAN_TREE_ROOT)
-    free_huffman_tree(HUFFMAN_TREE_ROOT);
 }
 
+// Decode src into dst_start, which must be able to take src_len * 8 / 5 bytes. Returns the length of the
+// decoded string, or -1 if src is not a valid Huffman encoded string.
 int64_t
 huffman_decode(char *dst_start, const uint8_t *src, uint32_t src_len)
 {
   char *dst_end = dst_start;
-  uint8_t shift = 7;
-  Node *current = HUFFMAN_TREE_ROOT;
-
-  while (src_len) {
-    if (*src & (1 << shift)) {
-      current = current->right;
-    } else {
-      current = current->left;
+  uint8_t state = 0;
+  bool accept = true;
+
+  for (const uint8_t *end = src + src_len; src < end; ++src) {
+    const huffman_decode_entry *entry = &huffman_decode_table[state][*src >> 4];
+
+    if (entry->flags & HUFFMAN_DECODE_FAIL) {
+      return -1;
+    }
+    if (entry->flags & HUFFMAN_DECODE_SYMBOL) {
+      *dst_end++ = entry->symbol;
     }
 
-    if (current->ascii_code) {
-      *dst_end = current->ascii_code;
-      ++dst_end;
-      current = HUFFMAN_TREE_ROOT;
+    entry = &huffman_decode_table[entry->state][*src & 0xf];
+    if (entry->flags & HUFFMAN_DECODE_FAIL) {
+      return -1;
     }
-    if (shift) {
-      --shift;
-    } else {
-      shift = 7;
-      ++src;
-      --src_len;
+    if (entry->flags & HUFFMAN_DECODE_SYMBOL) {
+      *dst_end++ = entry->symbol;
     }
+
+    state = entry->state;
+    accept = entry->flags & HUFFMAN_DECODE_ACCEPT;
+  }
+
+  // 5.2. A padding longer than 7 bits, or not made of the EOS prefix, MUST be treated as a decoding error.
+  if (!accept) {
+    return -1;
   }
 
   return dst_end - dst_start;
 }
+
+// Return the length of src once Huffman encoded.
+int64_t
+huffman_encode_length(const uint8_t *src, uint32_t src_len)
+{
+  uint64_t bits = 0;
+
+  for (uint32_t i = 0; i < src_len; i++) {
+    bits += huffman_table[src[i]].bit_len;
+  }
+
+  return (bits + 7) >> 3;
+}
+
+// Huffman encode src into dst_start, which must be able to take huffman_encode_length(src, src_len) bytes.
+// Returns the length of the encoded string.
+int64_t
+huffman_encode(uint8_t *dst_start, const uint8_t *src, uint32_t src_len)
+{
+  uint8_t *dst = dst_start;
+  uint64_t buf = 0;   // Pending bits, right aligned
+  uint32_t nbits = 0; // Number of pending bits
+
+  for (uint32_t i = 0; i < src_len; i++) {
+    const huffman_entry &code = huffman_table[src[i]];
+
+    // Codes are at most 30 bits, so at most 37 bits are pending here.
+    buf = (buf << code.bit_len) | code.code_as_hex;
+    nbits += code.bit_len;
+
+    while (nbits >= 8) {
+      nbits -= 8;
+      *dst++ = static_cast<uint8_t>(buf >> nbits);
+    }
+  }
+
+  // 5.2. Pad with the most significant bits of EOS
+  if (nbits > 0) {
+    *dst++ = static_cast<uint8_t>((buf << (8 - nbits)) | (0xff >> nbits));
+  }
+
+  return dst - dst_start;
+}
@@ -70,6 +70,7 @@ Log::LoggingMode Log::logging_mode = LOG_MODE_NONE;
 EventNotify *Log::preproc_notify;
 EventNotify *Log::flush_notify;
 InkAtomicList *Log::flush_data_list;
+int Log::flush_threads;
 
 // Collate thread stuff
 EventNotify Log::collate_notify;
@@ -160,8 +161,8 @@ Log::change_configuration()
 /*-------------------------------------------------------------------------
   PeriodicWakeup
 
-  This continuation is invoked each second to wake-up the flush thread,
-  just in case it's sleeping on the job.
+  This continuation is invoked each second to wake-up the flush threads,
+  just in case they're sleeping on the job.
   -------------------------------------------------------------------------*/
 
 struct PeriodicWakeup;
@@ -244,7 +245,7 @@ Log::periodic_tasks(long time_now)
       if (global_scrap_object) {
         global_scrap_object->roll_files(time_now);
       }
-      Log::config->log_object_manager.roll_files(time_now);
+      Log::config->log_object_manager.roll_files(time_now, 0);
       Log::config->roll_log_files_now = false;
     } else {
       if (error_log) {
@@ -253,11 +254,34 @@ Log::periodic_tasks(long time_now)
       if (global_scrap_object) {
         global_scrap_object->roll_files(time_now);
       }
-      Log::config->log_object_manager.roll_files(time_now);
+      Log::config->log_object_manager.roll_files(time_now, 0);
     }
   }
 }
 
+/*-------------------------------------------------------------------------
+  Log::flush_thread_tasks
+
+  The periodic tasks of each flush thread, on the log objects assigned to
+  it. A file is only ever rolled by the thread writing it, so that it is
+  not closed under a write. The files of flush thread 0 are rolled by
+  periodic_tasks().
+  -------------------------------------------------------------------------*/
+
+void
+Log::flush_thread_tasks(int idx, long time_now)
+{
+  LogConfig *current = (LogConfig *)configProcessor.get(log_configid);
+
+  if (likely(current)) {
+    if (idx && (logging_mode > LOG_MODE_NONE || current->collation_mode == Log::COLLATION_HOST || current->has_api_objects())) {
+      current->log_object_manager.roll_files(time_now, idx);
+    }
+    current->log_object_manager.update_flush_stats(idx);
+    configProcessor.release(log_configid, current);
+  }
+}
+
 /*-------------------------------------------------------------------------
   MAIN INTERFACE
   -------------------------------------------------------------------------*/
@@ -745,6 +769,7 @@ void
 Log::init(int flags)
 {
   collation_preproc_threads = 1;
+  flush_threads = 1;
   collation_accept_file_descriptor = NO_FD;
 
   // store the configuration flags
@@ -768,6 +793,7 @@ Log::init(int flags)
     config->read_configuration_variables();
     collation_port = config->collation_port;
     collation_preproc_threads = config->collation_preproc_threads;
+    flush_threads = config->flush_threads;
 
     if (config_flags & STANDALONE_COLLATOR) {
       logging_mode = LOG_MODE_TRANSACTIONS;
@@ -837,7 +863,7 @@ Log::init_when_enabled()
 
     // create the flush thread and the collation thread
     create_threads();
-    eventProcessor.schedule_every(new PeriodicWakeup(collation_preproc_threads, 1), HRTIME_SECOND, ET_CALL);
+    eventProcessor.schedule_every(new PeriodicWakeup(collation_preproc_threads, flush_threads), HRTIME_SECOND, ET_CALL);
 
     init_status |= FULLY_INITIALIZED;
   }
@@ -867,18 +893,19 @@ Log::create_threads()
     eventProcessor.spawn_thread(preproc_cont, desc, stacksize);
   }
 
-  // Now, only one flush thread is supported.
-  // TODO: Enable multiple flush threads, such as
-  //       one flush thread per file.
+  // start the flush threads, each writes the files of the log objects
+  // assigned to it by the LogObjectManager.
   //
-  flush_notify = new EventNotify;
-  flush_data_list = new InkAtomicList;
-
-  sprintf(desc, "Logging flush buffer list");
-  ink_atomiclist_init(flush_data_list, desc, 0);
-  Continuation *flush_cont = new LoggingFlushContinuation(0);
-  sprintf(desc, "[LOG_FLUSH]");
-  eventProcessor.spawn_thread(flush_cont, desc, stacksize);
+  flush_notify = new EventNotify[flush_threads];
+  flush_data_list = new InkAtomicList[flush_threads];
+
+  for (int i = 0; i < flush_threads; i++) {
+    sprintf(desc, "Logging flush buffer list %d", i);
+    ink_atomiclist_init(&flush_data_list[i], ats_strdup(desc), 0);
+    Continuation *flush_cont = new LoggingFlushContinuation(i);
+    sprintf(desc, "[LOG_FLUSH %d]", i);
+    eventProcessor.spawn_thread(flush_cont, desc, stacksize);
+  }
 }
 
 /*-------------------------------------------------------------------------
@@ -1040,8 +1067,9 @@ Log::preproc_thread_main(void *args)
 }
 
 void *
-Log::flush_thread_main(void * /* args ATS_UNUSED */)
+Log::flush_thread_main(void *args)
 {
+  int idx = *(int *)args;
   char *buf;
   LogFile *logfile;
   LogBuffer *logbuffer;
@@ -1051,10 +1079,10 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
   SLL<LogFlushData, LogFlushData::Link_link> link, invert_link;
   ProxyMutex *mutex = this_thread()->mutex;
 
-  Log::flush_notify->lock();
+  Log::flush_notify[idx].lock();
 
   while (true) {
-    fdata = (LogFlushData *)ink_atomiclist_popall(flush_data_list);
+    fdata = (LogFlushData *)ink_atomiclist_popall(&flush_data_list[idx]);
 
     // invert the list
     //
@@ -1090,6 +1118,8 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
         Warning("File:%s was closed, have dropped (%d) bytes.", logfile->get_name(), total_bytes);
 
         RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_lost_before_written_to_disk_stat, total_bytes);
+        ink_atomic_increment(&logfile->m_flush_queued_bytes, -total_bytes);
+        ink_atomic_increment(&logfile->m_bytes_dropped, total_bytes);
         delete fdata;
         continue;
       }
@@ -1121,6 +1151,9 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
       RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_written_to_disk_stat, bytes_written);
 
       ink_atomic_increment(&logfile->m_bytes_written, bytes_written);
+      ink_atomic_increment(&logfile->m_flush_queued_bytes, -total_bytes);
+      if (bytes_written < total_bytes)
+        ink_atomic_increment(&logfile->m_bytes_dropped, total_bytes - bytes_written);
 
       delete fdata;
     }
@@ -1129,8 +1162,10 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
     //
     now = ink_get_hrtime() / HRTIME_SECOND;
     if (now >= last_time + PERIODIC_TASKS_INTERVAL) {
-      Debug("log-preproc", "periodic tasks for %" PRId64, (int64_t)now);
-      periodic_tasks(now);
+      Debug("log-preproc", "periodic tasks for %" PRId64 " on flush thread %d", (int64_t)now, idx);
+      if (idx == 0)
+        periodic_tasks(now);
+      flush_thread_tasks(idx, now);
       last_time = ink_get_hrtime() / HRTIME_SECOND;
     }
 
@@ -1138,11 +1173,11 @@ Log::flush_thread_main(void * /* args ATS_UNUSED */)
     // check the queue and find there is nothing to do, then wait
     // again.
     //
-    Log::flush_notify->wait();
+    Log::flush_notify[idx].wait();
   }
 
   /* NOTREACHED */
-  Log::flush_notify->unlock();
+  Log::flush_notify[idx].unlock();
   return NULL;
 }
 
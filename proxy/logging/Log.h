@@ -432,8 +432,9 @@ public:
   // logging thread stuff
   static EventNotify *preproc_notify;
   static void *preproc_thread_main(void *args);
-  static EventNotify *flush_notify;
-  static InkAtomicList *flush_data_list;
+  static EventNotify *flush_notify;      // one per flush thread
+  static InkAtomicList *flush_data_list; // one per flush thread
+  static int flush_threads;
   static void *flush_thread_main(void *args);
 
   // collation thread stuff
@@ -455,6 +456,7 @@ public:
 
 private:
   static void periodic_tasks(long time_now);
+  static void flush_thread_tasks(int idx, long time_now);
   static void create_threads();
   static void init_when_enabled();
 
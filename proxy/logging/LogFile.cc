@@ -70,6 +70,9 @@ LogFile::LogFile(const char *name, const char *header, LogFileFormat format, uin
   m_end_time = 0L;
   m_bytes_written = 0;
   m_size_bytes = 0;
+  m_flush_thread = 0;
+  m_flush_queued_bytes = 0;
+  m_bytes_dropped = 0;
   m_ascii_buffer_size = (ascii_buffer_size < max_line_size ? max_line_size : ascii_buffer_size);
 
   Debug("log-file", "exiting LogFile constructor, m_name=%s, this=%p", m_name, this);
@@ -84,7 +87,8 @@ LogFile::LogFile(const char *name, const char *header, LogFileFormat format, uin
 LogFile::LogFile(const LogFile &copy)
   : m_file_format(copy.m_file_format), m_name(ats_strdup(copy.m_name)), m_header(ats_strdup(copy.m_header)),
     m_signature(copy.m_signature), m_meta_info(NULL), m_ascii_buffer_size(copy.m_ascii_buffer_size),
-    m_max_line_size(copy.m_max_line_size), m_fd(-1), m_start_time(0L), m_end_time(0L), m_bytes_written(0)
+    m_max_line_size(copy.m_max_line_size), m_fd(-1), m_start_time(0L), m_end_time(0L), m_bytes_written(0),
+    m_flush_thread(copy.m_flush_thread), m_flush_queued_bytes(0), m_bytes_dropped(0)
 {
   ink_release_assert(m_ascii_buffer_size >= m_max_line_size);
 
@@ -417,6 +421,19 @@ LogFile::roll(long interval_start, long interval_end)
   return 1;
 }
 
+/*-------------------------------------------------------------------------
+  LogFile::queue_flush
+
+  Hand the data to the flush thread writing this file.
+  -------------------------------------------------------------------------*/
+void
+LogFile::queue_flush(LogFlushData *flush_data, int bytes)
+{
+  ink_atomic_increment(&m_flush_queued_bytes, bytes);
+  ink_atomiclist_push(&Log::flush_data_list[m_flush_thread], flush_data);
+  Log::flush_notify[m_flush_thread].signal();
+}
+
 /*-------------------------------------------------------------------------
   LogFile::preproc_and_try_delete
 
@@ -472,9 +489,7 @@ LogFile::preproc_and_try_delete(LogBuffer *lb)
 
     RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, lb->header()->byte_count);
 
-    ink_atomiclist_push(Log::flush_data_list, flush_data);
-
-    Log::flush_notify->signal();
+    queue_flush(flush_data, lb->header()->byte_count);
 
     //
     // LogBuffer will be deleted in flush thread
@@ -650,9 +665,7 @@ LogFile::write_ascii_logbuffer3(LogBufferHeader *buffer_header, const char *alt_
 
     RecIncrRawStat(log_rsb, mutex->thread_holding, log_stat_bytes_flush_to_disk_stat, fmt_buf_bytes);
 
-    ink_atomiclist_push(Log::flush_data_list, flush_data);
-
-    Log::flush_notify->signal();
+    queue_flush(flush_data, fmt_buf_bytes);
 
     total_bytes += fmt_buf_bytes;
   }
@@ -35,6 +35,7 @@ class LogSock;
 class LogBuffer;
 struct LogBufferHeader;
 class LogObject;
+class LogFlushData;
 
 #define LOGFILE_ROLLED_EXTENSION ".old"
 #define LOGFILE_SEPARATOR_STRING "_"
@@ -217,10 +218,16 @@ public:
   volatile uint64_t m_bytes_written;
   off_t m_size_bytes; // current size of file in bytes
 
+  int m_flush_thread;                    // index of the flush thread writing this file
+  volatile int64_t m_flush_queued_bytes; // handed to the flush thread, not yet written
+  volatile int64_t m_bytes_dropped;      // lost by the flush thread
+
 public:
   Link<LogFile> link;
 
 private:
+  void queue_flush(LogFlushData *flush_data, int bytes);
+
   // -- member functions not allowed --
   LogFile();
   LogFile &operator=(const LogFile &);
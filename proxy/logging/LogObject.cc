@@ -65,6 +65,7 @@ LogBufferManager::preproc_buffers(LogBufferSink *sink)
       Warning("Dropping log buffer, can't keep up.");
       RecIncrRawStat(log_rsb, this_thread()->mutex->thread_holding, log_stat_bytes_lost_before_preproc_stat,
                      b->header()->byte_count);
+      ink_atomic_increment(&_bytes_dropped, (int64_t)b->header()->byte_count);
       delete b;
     } else {
       new_q.push(b);
@@ -92,7 +93,7 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
                      int rolling_offset_hr, int rolling_size_mb, bool auto_created)
   : m_auto_created(auto_created), m_alt_filename(NULL), m_flags(0), m_signature(0), m_flush_threads(flush_threads),
     m_rolling_interval_sec(rolling_interval_sec), m_rolling_offset_hr(rolling_offset_hr), m_rolling_size_mb(rolling_size_mb),
-    m_last_roll_time(0), m_buffer_manager_idx(0)
+    m_last_roll_time(0), m_buffer_manager_idx(0), m_flush_thread(-1), m_flush_stats_registered(false)
 {
   ink_release_assert(format);
   m_format = new LogFormat(*format);
@@ -126,7 +127,8 @@ LogObject::LogObject(const LogFormat *format, const char *log_dir, const char *b
 LogObject::LogObject(LogObject &rhs)
   : m_basename(ats_strdup(rhs.m_basename)), m_filename(ats_strdup(rhs.m_filename)), m_alt_filename(ats_strdup(rhs.m_alt_filename)),
     m_flags(rhs.m_flags), m_signature(rhs.m_signature), m_flush_threads(rhs.m_flush_threads),
-    m_rolling_interval_sec(rhs.m_rolling_interval_sec), m_last_roll_time(rhs.m_last_roll_time)
+    m_rolling_interval_sec(rhs.m_rolling_interval_sec), m_last_roll_time(rhs.m_last_roll_time), m_flush_thread(-1),
+    m_flush_stats_registered(false)
 {
   m_format = new LogFormat(*(rhs.m_format));
   m_buffer_manager = new LogBufferManager[m_flush_threads];
@@ -787,6 +789,44 @@ LogObject::_roll_files(long last_roll_time, long time_now)
 }
 
 
+/*-------------------------------------------------------------------------
+  LogObject::update_flush_stats
+
+  Export the backlog and the losses of this object, under
+  proxy.process.log.object.<basename>:
+
+  queued_buffers  buffers waiting for a preproc thread
+  queued_bytes    bytes waiting for the flush thread to write them
+  dropped_bytes   bytes lost because the threads couldn't keep up, or
+                  the file couldn't be written
+  -------------------------------------------------------------------------*/
+
+void
+LogObject::update_flush_stats()
+{
+  static const char *const stat_names[] = {"queued_buffers", "queued_bytes", "dropped_bytes"};
+  int64_t values[3] = {0, 0, 0};
+  char name[PATH_NAME_MAX + 64];
+
+  for (int i = 0; i < m_flush_threads; i++) {
+    values[0] += m_buffer_manager[i].num_flush_buffers();
+    values[2] += m_buffer_manager[i].bytes_dropped();
+  }
+  if (m_logFile) {
+    values[1] = m_logFile->m_flush_queued_bytes;
+    values[2] += m_logFile->m_bytes_dropped;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    snprintf(name, sizeof(name), "proxy.process.log.object.%s.%s", m_basename, stat_names[i]);
+    if (!m_flush_stats_registered) {
+      RecRegisterStatInt(RECT_PROCESS, name, 0, RECP_NON_PERSISTENT);
+    }
+    RecSetRecordInt(name, values[i], REC_SOURCE_DEFAULT);
+  }
+  m_flush_stats_registered = true;
+}
+
 void
 LogObject::check_buffer_expiration(long time_now)
 {
@@ -919,8 +959,13 @@ LogObjectManager::_manage_object(LogObject *log_object, bool is_api_object, int
         retVal = ERROR_DOING_FILESYSTEM_CHECKS;
 
       } else {
-        // no conflicts, add object to the list of managed objects
+        // no conflicts, add object to the list of managed objects,
+        // spread over the flush threads. An object passed on from
+        // another manager keeps its flush thread.
         //
+        if (!log_object->has_flush_thread()) {
+          log_object->set_flush_thread((_objects.length() + _APIobjects.length()) % MAX(Log::flush_threads, 1));
+        }
         REF_COUNT_OBJ_REFCOUNT_INC(log_object);
         if (is_api_object) {
           _APIobjects.push_back(log_object);
@@ -1261,18 +1306,22 @@ LogObjectManager::transfer_objects(LogObjectManager &old_mgr)
 }
 
 unsigned
-LogObjectManager::roll_files(long time_now)
+LogObjectManager::roll_files(long time_now, int flush_thread)
 {
   int num_rolled = 0;
 
   for (unsigned i = 0; i < this->_objects.length(); i++) {
-    num_rolled += this->_objects[i]->roll_files(time_now);
+    if (flush_thread < 0 || this->_objects[i]->get_flush_thread() == flush_thread) {
+      num_rolled += this->_objects[i]->roll_files(time_now);
+    }
   }
 
   ACQUIRE_API_MUTEX("A LogObjectManager::roll_files");
 
   for (unsigned i = 0; i < this->_APIobjects.length(); i++) {
-    num_rolled += this->_APIobjects[i]->roll_files(time_now);
+    if (flush_thread < 0 || this->_APIobjects[i]->get_flush_thread() == flush_thread) {
+      num_rolled += this->_APIobjects[i]->roll_files(time_now);
+    }
   }
 
   RELEASE_API_MUTEX("R LogObjectManager::roll_files");
@@ -1280,6 +1329,26 @@ LogObjectManager::roll_files(long time_now)
   return num_rolled;
 }
 
+void
+LogObjectManager::update_flush_stats(int flush_thread)
+{
+  for (unsigned i = 0; i < this->_objects.length(); i++) {
+    if (this->_objects[i]->get_flush_thread() == flush_thread) {
+      this->_objects[i]->update_flush_stats();
+    }
+  }
+
+  ACQUIRE_API_MUTEX("A LogObjectManager::update_flush_stats");
+
+  for (unsigned i = 0; i < this->_APIobjects.length(); i++) {
+    if (this->_APIobjects[i]->get_flush_thread() == flush_thread) {
+      this->_APIobjects[i]->update_flush_stats();
+    }
+  }
+
+  RELEASE_API_MUTEX("R LogObjectManager::update_flush_stats");
+}
+
 void
 LogObjectManager::display(FILE *str)
 {
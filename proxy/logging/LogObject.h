@@ -69,9 +69,10 @@ class LogBufferManager
 private:
   ASLL(LogBuffer, write_link) write_list;
   int _num_flush_buffers;
+  int64_t _bytes_dropped; // in buffers dropped because preproc can't keep up
 
 public:
-  LogBufferManager() : _num_flush_buffers(0) {}
+  LogBufferManager() : _num_flush_buffers(0), _bytes_dropped(0) {}
 
   void
   add_to_flush_queue(LogBuffer *buffer)
@@ -81,6 +82,17 @@ public:
   }
 
   size_t preproc_buffers(LogBufferSink *sink);
+
+  int
+  num_flush_buffers() const
+  {
+    return _num_flush_buffers;
+  }
+  int64_t
+  bytes_dropped() const
+  {
+    return _bytes_dropped;
+  }
 };
 
 // LogObject is atomically reference counted, and the reference count is always owned by
@@ -154,6 +166,27 @@ public:
 
   void check_buffer_expiration(long time_now);
 
+  // The flush thread writing the file of this object, assigned when the object is managed.
+  int
+  get_flush_thread() const
+  {
+    return m_flush_thread < 0 ? 0 : m_flush_thread;
+  }
+  bool
+  has_flush_thread() const
+  {
+    return m_flush_thread >= 0;
+  }
+  void
+  set_flush_thread(int idx)
+  {
+    m_flush_thread = idx;
+    if (m_logFile) {
+      m_logFile->m_flush_thread = idx;
+    }
+  }
+  void update_flush_stats();
+
   void display(FILE *fd = stdout);
   void displayAsXML(FILE *fd = stdout, bool extended = false);
   static uint64_t compute_signature(LogFormat *format, char *filename, unsigned int flags);
@@ -290,7 +323,7 @@ private:
   uint64_t m_signature; // INK_MD5 signature for object
 
   Log::RollingEnabledValues m_rolling_enabled;
-  int m_flush_threads;        // number of flush threads
+  int m_flush_threads;        // number of buffer managers, one per preproc thread
   int m_rolling_interval_sec; // time interval between rolls
   // 0 means no rolling
   int m_rolling_offset_hr; //
@@ -302,6 +335,9 @@ private:
   unsigned m_buffer_manager_idx;
   LogBufferManager *m_buffer_manager;
 
+  int m_flush_thread; // -1 until the object is managed
+  bool m_flush_stats_registered;
+
   void generate_filenames(const char *log_dir, const char *basename, LogFileFormat file_format);
   void _setup_rolling(Log::RollingEnabledValues rolling_enabled, int rolling_interval_sec, int rolling_offset_hr,
                       int rolling_size_mb);
@@ -409,7 +445,9 @@ public:
   LogObject *get_object_with_signature(uint64_t signature);
   void check_buffer_expiration(long time_now);
 
-  unsigned roll_files(long time_now);
+  // Roll the files of the objects written by @a flush_thread, of all of them if -1.
+  unsigned roll_files(long time_now, int flush_thread = -1);
+  void update_flush_stats(int flush_thread);
 
   int log(LogAccess *lad);
   void display(FILE *str = stdout);